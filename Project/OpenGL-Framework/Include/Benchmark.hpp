@@ -0,0 +1,50 @@
+/****************************************************************************/
+/*!
+\file
+   Benchmark.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Startup benchmarks, compiled in when OGL_BENCHMARK is defined.
+    Results go to the console and the Benchmark_ log.
+*/
+/****************************************************************************/
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+#pragma once
+
+#include "OPENGLPCH.hpp"
+
+namespace OGL
+{
+    namespace Benchmark
+    {
+        void Run();
+
+        void MeshCache(const std::string& path);
+        void VertexFormats(const std::string& path);
+        void ObjLoader(const std::string& path);
+        void AsyncLoad(const std::string& path);
+        void Lods(const std::string& path);
+        void Meshlets(const std::string& path);
+        void Residency(const std::string& path);
+        void AssimpIO(const std::string& path);
+        void Registry(const std::string& path);
+        void Arena(const std::string& path);
+        void BoundingVolumes(const std::string& path);
+        void Normals(const std::string& path);
+        void Bvh(const std::string& path);
+        void RayCast(const std::string& path);
+        void Progressive(const std::string& path);
+        void Uniforms(const std::string& vertexShader, const std::string& fragmentShader);
+        void UniformBlocks(const std::string& vertexShader, const std::string& fragmentShader);
+        void ProgramBinaries(const std::string& vertexShader, const std::string& fragmentShader);
+        void ParallelCompile(const std::string& vertexShader, const std::string& fragmentShader);
+        void StateCache(const std::string& vertexShader, const std::string& fragmentShader);
+    }
+}
+
+#endif // BENCHMARK_HPP
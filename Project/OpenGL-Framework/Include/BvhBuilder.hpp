@@ -0,0 +1,59 @@
+/****************************************************************************/
+/*!
+\file
+   BvhBuilder.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Triangle bounding volume hierarchies, built with a binned SAH
+*/
+/****************************************************************************/
+#ifndef BVHBUILDER_HPP
+#define BVHBUILDER_HPP
+#pragma once
+
+#include "MeshBounds.hpp"
+
+namespace OGL
+{
+    //! one node, depth first so an interior node's left child follows it, two to a cache line
+    struct BvhNode
+    {
+        glm::vec3 min = glm::vec3(0);
+        GLuint first = 0;           //!< interior: index of the right child, leaf: into the BVH triangle array
+        glm::vec3 max = glm::vec3(0);
+        GLuint count = 0;           //!< triangles of a leaf, 0 for an interior node
+    };
+
+    //! shape of a built hierarchy
+    struct BvhStats
+    {
+        std::size_t nodeCount = 0;
+        std::size_t leafCount = 0;
+        std::size_t depth = 0;
+        float cost = 0;             //!< expected SAH cost of a ray, a linear scan costs the triangle count
+    };
+
+    namespace BvhBuilder
+    {
+        //! SAH candidates per axis
+        constexpr unsigned BinCount = 16;
+
+        //! nodes are split until splitting no longer pays, but never left larger than this
+        constexpr unsigned MaxLeafTriangles = 8;
+
+        //! SAH cost of visiting a node, relative to intersecting one triangle
+        constexpr float TraversalCost = 1.0f;
+
+        //! subtrees up to this size are built whole on one thread, fixed so the output does not depend on the thread count
+        constexpr std::size_t SubtreeTriangles = 1 << 14;
+
+        BvhStats Build(const Vertex* vertices, std::size_t vertexCount, const GLuint* indices, std::size_t indexCount,
+            std::vector<BvhNode>& nodes, std::vector<GLuint>& triangles);
+    }
+}
+
+#endif // BVHBUILDER_HPP
@@ -0,0 +1,65 @@
+/****************************************************************************/
+/*!
+\file
+   FileWatcher.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Background thread reporting changes to a set of files
+*/
+/****************************************************************************/
+#ifndef FILEWATCHER_HPP
+#define FILEWATCHER_HPP
+#pragma once
+
+#include "OPENGLPCH.hpp"
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace OGL
+{
+    class FileWatcher
+    {
+    public:
+        ~FileWatcher();
+        FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        void Watch(const std::string& path);
+        std::vector<std::string> Changes();
+
+        //! longest a change goes unnoticed, and how long stopping the thread can take
+        static constexpr unsigned PollMilliseconds = 250;
+
+    private:
+        //! one watched file
+        struct File
+        {
+            std::string path;                   //!< as passed to Watch, reported back by Changes
+            std::filesystem::path normalized;   //!< absolute, to match events against
+            std::filesystem::file_time_type time;
+        };
+
+        void Run();
+        void Changed(const std::filesystem::path& normalized);
+
+        std::vector<File> mFiles;
+        std::vector<std::string> mChanged;  //!< since the last Changes call, no duplicates
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        bool mStop = false;
+        int mNotify = -1;                   //!< inotify descriptor, Linux only
+        std::unordered_map<int, std::filesystem::path> mDirectories;   //!< inotify watch descriptor to directory
+        std::thread mThread;                //!< last, it starts once everything else is set up
+    };
+}
+
+#endif // FILEWATCHER_HPP
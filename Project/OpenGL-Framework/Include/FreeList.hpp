@@ -0,0 +1,45 @@
+/****************************************************************************/
+/*!
+\file
+   FreeList.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    First fit range allocator, hands out offsets into a buffer it does not
+    own
+*/
+/****************************************************************************/
+#ifndef FREELIST_HPP
+#define FREELIST_HPP
+#pragma once
+
+#include <cstddef>
+#include <map>
+
+namespace OGL
+{
+    class FreeList
+    {
+    public:
+        explicit FreeList(std::size_t capacity = 0);
+
+        bool Allocate(std::size_t size, std::size_t& offset);
+        void Free(std::size_t offset, std::size_t size);
+        void Reset(std::size_t used, std::size_t capacity);
+
+        std::size_t Capacity() const;
+        std::size_t FreeSize() const;
+        std::size_t LargestFree() const;
+        std::size_t FragmentCount() const;
+
+    private:
+        std::map<std::size_t, std::size_t> mFree;   //!< free ranges, offset to size, never adjacent
+        std::size_t mCapacity = 0;
+        std::size_t mFreeSize = 0;
+    };
+}
+
+#endif // FREELIST_HPP
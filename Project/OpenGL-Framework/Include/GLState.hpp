@@ -0,0 +1,62 @@
+/****************************************************************************/
+/*!
+\file
+   GLState.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Shadow copy of the GL state, skips calls that would change nothing
+*/
+/****************************************************************************/
+#ifndef GLSTATE_HPP
+#define GLSTATE_HPP
+#pragma once
+
+#include "OPENGLPCH.hpp"
+
+namespace OGL
+{
+    //! state calls made through GLState
+    struct GLStateCounters
+    {
+        std::size_t issued = 0;     //!< passed on to GL
+        std::size_t elided = 0;     //!< dropped, GL already had the state
+    };
+
+    namespace GLState
+    {
+        /* objects */
+        void UseProgram(GLuint program);
+        void BindVertexArray(GLuint vertexArray);
+        void BindBuffer(GLenum target, GLuint buffer);
+        void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+        void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+        /* fixed function */
+        void Enable(GLenum capability);
+        void Disable(GLenum capability);
+        void BlendFunc(GLenum source, GLenum destination);
+        void BlendEquation(GLenum mode);
+        void DepthFunc(GLenum func);
+        void DepthMask(GLboolean write);
+        void CullFace(GLenum mode);
+        void FrontFace(GLenum mode);
+
+        /* deletion, GL unbinds a deleted object and may hand its name out again */
+        void DeleteProgram(GLuint program);
+        void DeleteVertexArray(GLuint vertexArray);
+        void DeleteBuffer(GLuint buffer);
+        void DeleteTexture(GLuint texture);
+
+        void Invalidate();
+
+        void EndFrame();
+        GLStateCounters Frame();
+        GLStateCounters LastFrame();
+    }
+}
+
+#endif // GLSTATE_HPP
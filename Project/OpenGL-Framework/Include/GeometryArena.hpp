@@ -0,0 +1,97 @@
+/****************************************************************************/
+/*!
+\file
+   GeometryArena.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Shared vertex and index buffers that meshes of one vertex format and
+    index type suballocate from
+*/
+/****************************************************************************/
+#ifndef GEOMETRYARENA_HPP
+#define GEOMETRYARENA_HPP
+#pragma once
+
+#include "FreeList.hpp"
+#include "VertexFormat.hpp"
+
+namespace OGL
+{
+    struct DrawList;
+
+    class GeometryArena
+    {
+    public:
+        //! identifies one allocation, stays valid when the arena moves it
+        using Handle = std::uint32_t;
+        static constexpr Handle InvalidHandle = ~0u;
+
+        ~GeometryArena();
+        GeometryArena(VertexFormat format, GLenum indexType);
+
+        GeometryArena(const GeometryArena&) = delete;
+        GeometryArena& operator=(const GeometryArena&) = delete;
+
+        Handle Allocate(const void* vertices, std::size_t vertexCount, const void* indices, std::size_t indexCount);
+        Handle Allocate(std::size_t vertexCount, std::size_t indexCount);
+        void Write(Handle handle, std::size_t firstVertex, const void* vertices, std::size_t vertexCount,
+            std::size_t firstIndex, const void* indices, std::size_t indexCount);
+        void Free(Handle handle);
+        void Defragment();
+
+        GLint BaseVertex(Handle handle) const;
+        std::size_t IndexOffset(Handle handle) const;
+
+        void Bind() const;
+        void Draw(const DrawList& draws) const;
+
+        GLenum IndexType() const;
+        std::size_t UsedBytes() const;
+        std::size_t CapacityBytes() const;
+        std::size_t FragmentCount() const;
+
+        static GeometryArena& Get(VertexFormat format, GLenum indexType);
+        static void DestroyAll();
+        static void Log();
+
+        //! smallest buffers an arena starts with, they double when full
+        static constexpr std::size_t MinVertices = 1 << 16;
+        static constexpr std::size_t MinIndices = 1 << 18;
+
+    private:
+        //! where one allocation currently lives, in vertices and indices
+        struct Block
+        {
+            std::size_t firstVertex = 0;
+            std::size_t vertexCount = 0;
+            std::size_t firstIndex = 0;
+            std::size_t indexCount = 0;
+            bool live = false;
+        };
+
+        bool Reserve(std::size_t vertexCount, std::size_t indexCount, std::size_t& firstVertex, std::size_t& firstIndex);
+        void Rebuild(std::size_t vertexCapacity, std::size_t indexCapacity);
+        void SetupVertexArray();
+        void Track() const;
+
+        VertexFormat mFormat;
+        GLenum mIndexType;
+        std::size_t mStride;
+        std::size_t mIndexSize;
+
+        GLuint mVAO = 0;
+        GLuint mVBO = 0;
+        GLuint mIBO = 0;
+
+        FreeList mVertexSpace;
+        FreeList mIndexSpace;
+        std::vector<Block> mBlocks;         //!< by handle
+        std::vector<Handle> mFreeHandles;
+    };
+}
+
+#endif // GEOMETRYARENA_HPP
@@ -0,0 +1,120 @@
+/****************************************************************************/
+/*!
+\file
+   Hash.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Small non-cryptographic hashing helpers used for cache keys
+*/
+/****************************************************************************/
+#ifndef HASH_HPP
+#define HASH_HPP
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace OGL
+{
+    constexpr std::uint64_t HashSeed = 0xcbf29ce484222325ull;
+    constexpr std::uint64_t HashPrime = 0x100000001b3ull;
+
+/****************************************************************************/
+/*!
+\brief
+    FNV-1a over a block of memory, eight bytes at a time
+
+\param data
+    The bytes to hash
+
+\param size
+    Number of bytes
+
+\param seed
+    Previous hash, lets several blocks be chained into one key
+
+\return
+    The 64 bit hash
+*/
+/****************************************************************************/
+    inline std::uint64_t Hash64(const void* data, std::size_t size, std::uint64_t seed = HashSeed)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        std::uint64_t hash = seed;
+
+        // bulk of the data as 64 bit words
+        for (; size >= sizeof(std::uint64_t); size -= sizeof(std::uint64_t))
+        {
+            std::uint64_t word;
+            std::memcpy(&word, bytes, sizeof(word));
+            hash = (hash ^ word) * HashPrime;
+            hash ^= hash >> 29;
+            bytes += sizeof(word);
+        }
+
+        // the tail byte by byte
+        for (; size > 0; --size)
+        {
+            hash = (hash ^ *bytes++) * HashPrime;
+        }
+
+        return hash;
+    }
+
+/****************************************************************************/
+/*!
+\brief
+    Hash a string
+*/
+/****************************************************************************/
+    inline std::uint64_t Hash64(const std::string& str, std::uint64_t seed = HashSeed)
+    {
+        return Hash64(str.data(), str.size(), seed);
+    }
+
+/****************************************************************************/
+/*!
+\brief
+    Hash a trivially copyable value
+*/
+/****************************************************************************/
+    template <typename T>
+    inline std::uint64_t HashValue(const T& value, std::uint64_t seed = HashSeed)
+    {
+        return Hash64(&value, sizeof(T), seed);
+    }
+
+/****************************************************************************/
+/*!
+\brief
+    FNV-1a over a null terminated name one byte at a time, usable at
+    compile time. Does not match Hash64 of the same string, both sides
+    of a lookup must use this one.
+
+\param name
+    The name to hash
+
+\param seed
+    Previous hash
+
+\return
+    The 64 bit hash
+*/
+/****************************************************************************/
+    constexpr std::uint64_t HashName(const char* name, std::uint64_t seed = HashSeed)
+    {
+        std::uint64_t hash = seed;
+        for (; *name; ++name)
+        {
+            hash = (hash ^ std::uint64_t(static_cast<unsigned char>(*name))) * HashPrime;
+        }
+        return hash;
+    }
+}
+
+#endif // HASH_HPP
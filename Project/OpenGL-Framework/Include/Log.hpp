@@ -21,6 +21,7 @@
 #include <iostream>
 #include <sstream>
 #include <ctime>
+#include <mutex>
 
 #define CHECK_FILE_OPEN(ofs, fname)             \
 if (!ofs)                                       \
@@ -47,6 +48,7 @@ namespace DEBUG
         template <typename... Args>
         bool Error(Args&& ... args) 
         {
+            std::lock_guard<std::mutex> lock(Mutex());
             std::string fname = std::string("Errors_") + PROJECT_NAME;
 
             if (!createLog[0]) 
@@ -87,6 +89,7 @@ namespace DEBUG
         {
 
 #ifdef _DEBUG
+            std::lock_guard<std::mutex> lock(Mutex());
             std::string fname = std::string("Errors_") + PROJECT_NAME;
 
             if (!createLog[1]) 
@@ -117,8 +120,62 @@ namespace DEBUG
             return true;
         }
 
+/****************************************************************************/
+/*!
+\brief
+    Output some text to the benchmark log, written in every build
+    configuration so release timings can be collected
+*/
+/****************************************************************************/
+        template <typename... Args>
+        bool Benchmark(Args&& ... args) 
+        {
+            std::lock_guard<std::mutex> lock(Mutex());
+            std::string fname = std::string("Benchmark_") + PROJECT_NAME;
+
+            if (!createLog[2]) 
+            {
+                if (!CreateLog(fname)) 
+                {
+                    return false;
+                }
+                createLog[2] = true;
+            }
+
+            // open the log file
+            std::ofstream ofs(fname.c_str(), std::ofstream::app);
+
+            // if it failed to be created
+            CHECK_FILE_OPEN(ofs, fname);
+
+            // write to the log and echo to the console
+            int dummy[sizeof...(Args)] = { (ofs << args << ' ', std::cout << args << ' ', 1)... };
+            UNUSED(dummy);
+            ofs << std::endl;
+            std::cout << std::endl;
+
+            // close the file
+            ofs.close();
+
+            // return success
+            return true;
+        }
+
     private:
 
+/****************************************************************************/
+/*!
+\brief
+    Serializes writes from the mesh loading threads, shared by the log
+    instance of every translation unit
+*/
+/****************************************************************************/
+        static std::mutex& Mutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
 /****************************************************************************/
 /*!
 \brief
@@ -145,7 +202,7 @@ namespace DEBUG
             return true;
         }
 
-        bool createLog[2] = { false, false };
+        bool createLog[3] = { false, false, false };
 
     }log;
 }
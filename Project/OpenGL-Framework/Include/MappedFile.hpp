@@ -0,0 +1,57 @@
+/****************************************************************************/
+/*!
+\file
+   MappedFile.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Read only memory mapped file
+*/
+/****************************************************************************/
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace OGL
+{
+    class MappedFile
+    {
+    public:
+        ~MappedFile();
+        MappedFile() = default;
+        explicit MappedFile(const std::string& path);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        bool Open(const std::string& path);
+        void Close();
+
+        bool IsOpen() const;
+        const char* Data() const;
+        std::size_t Size() const;
+
+    private:
+        void Swap(MappedFile& other) noexcept;
+
+#ifdef _WIN32
+        void* mFile = nullptr;
+        void* mMapping = nullptr;
+#else
+        int mFile = -1;
+#endif
+        const char* mData = nullptr;
+        std::size_t mSize = 0;
+        bool mOpen = false;
+    };
+}
+
+#endif // MAPPEDFILE_HPP
@@ -0,0 +1,61 @@
+/****************************************************************************/
+/*!
+\file
+   MappedIOSystem.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Assimp file system that reads straight from memory mapped files and
+    registered in-memory blobs
+*/
+/****************************************************************************/
+#ifndef MAPPEDIOSYSTEM_HPP
+#define MAPPEDIOSYSTEM_HPP
+#pragma once
+
+#include "MappedFile.hpp"
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+namespace OGL
+{
+    //! read only stream over a mapping or a blob, never copies the data
+    class MappedIOStream : public Assimp::IOStream
+    {
+    public:
+        explicit MappedIOStream(MappedFile&& file);
+        MappedIOStream(const char* data, std::size_t size);
+
+        std::size_t Read(void* buffer, std::size_t size, std::size_t count) override;
+        std::size_t Write(const void* buffer, std::size_t size, std::size_t count) override;
+        aiReturn Seek(std::size_t offset, aiOrigin origin) override;
+        std::size_t Tell() const override;
+        std::size_t FileSize() const override;
+        void Flush() override;
+
+    private:
+        MappedFile mFile;
+        const char* mData = nullptr;
+        std::size_t mSize = 0;
+        std::size_t mPosition = 0;
+    };
+
+    //! hand to Assimp::Importer::SetIOHandler, the importer takes ownership
+    class MappedIOSystem : public Assimp::IOSystem
+    {
+    public:
+        bool Exists(const char* file) const override;
+        char getOsSeparator() const override;
+        Assimp::IOStream* Open(const char* file, const char* mode = "rb") override;
+        void Close(Assimp::IOStream* file) override;
+
+        static void RegisterBlob(const std::string& path, const void* data, std::size_t size);
+        static void UnregisterBlob(const std::string& path);
+        static bool HasBlob(const std::string& path);
+    };
+}
+
+#endif // MAPPEDIOSYSTEM_HPP
@@ -0,0 +1,43 @@
+/****************************************************************************/
+/*!
+\file
+   MemoryTracker.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Engine wide accounting of the CPU and GPU memory held by each asset
+*/
+/****************************************************************************/
+#ifndef MEMORYTRACKER_HPP
+#define MEMORYTRACKER_HPP
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace OGL
+{
+    //! memory held by one asset
+    struct AssetMemory
+    {
+        std::string name;
+        std::size_t cpuBytes = 0;
+        std::size_t gpuBytes = 0;
+    };
+
+    namespace MemoryTracker
+    {
+        void Track(const void* owner, const std::string& name, std::size_t cpuBytes, std::size_t gpuBytes);
+        void Untrack(const void* owner);
+
+        std::vector<AssetMemory> Report();
+        AssetMemory Total();
+        void Log();
+    }
+}
+
+#endif // MEMORYTRACKER_HPP
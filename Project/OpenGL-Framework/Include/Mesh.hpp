@@ -14,6 +14,11 @@
 #pragma once
 
 #include "OPENGLPCH.hpp"
+#include "VertexFormat.hpp"
+#include "BvhBuilder.hpp"
+#include "GeometryArena.hpp"
+#include "MeshBounds.hpp"
+#include "MeshletBuilder.hpp"
 
 #pragma warning(push)
 #pragma warning(disable : 26812 26495 26451)
@@ -25,10 +30,70 @@
 namespace OGL 
 {
 
-    struct Vertex 
+    //! one Assimp mesh, its indices are relative to baseVertex
+    struct SubMesh
     {
-        glm::vec4 position = glm::vec4(0);
-        glm::vec4 normal = glm::vec4(0);
+        GLuint firstIndex = 0;
+        GLuint indexCount = 0;
+        GLint baseVertex = 0;
+        GLuint vertexCount = 0;
+        Bounds bounds;
+        BoundingSphere sphere;
+        GLuint firstLod = 0;        //!< range in the LOD table, the first LOD is the full submesh
+        GLuint lodCount = 0;
+        GLuint firstMeshlet = 0;    //!< range in the meshlet table, built from the full submesh
+        GLuint meshletCount = 0;
+        GLuint firstBvhNode = 0;    //!< range in the BVH node table, empty unless the mesh was loaded with one
+        GLuint bvhNodeCount = 0;
+    };
+
+    //! one level of detail of a submesh, an index range over the submesh's vertices
+    struct MeshLod
+    {
+        GLuint firstIndex = 0;
+        GLuint indexCount = 0;
+        float error = 0;            //!< bound on how far a vertex moved off the full detail triangles
+        GLuint vertexCount = 0;     //!< this level only uses the submesh's first vertexCount vertices, all of them unless ordered progressive
+    };
+
+    //! everything an import produces, exactly what the mesh cache stores
+    struct MeshData
+    {
+        std::vector<Vertex> vertices;
+        std::vector<GLuint> indices;
+        std::vector<SubMesh> subMeshes;
+        std::vector<MeshLod> lods;
+        std::vector<Meshlet> meshlets;
+        std::vector<GLuint> meshletVertices;            //!< relative to the submesh's base vertex
+        std::vector<std::uint8_t> meshletTriangles;     //!< 3 per triangle, into the meshlet's vertices
+        std::vector<BvhNode> bvhNodes;
+        std::vector<GLuint> bvhTriangles;               //!< triangle numbers, relative to the submesh's first index
+
+        void Clear();
+        void ReleaseGeometry();
+        std::size_t Bytes() const;
+        std::uint64_t Hash() const;
+    };
+
+    //! where a mesh keeps its data once it has been uploaded
+    enum class Residency
+    {
+        GpuOnly,        //!< the vertex, index, meshlet and BVH arrays are freed after upload
+        CpuAndGpu,      //!< everything stays in system memory, for picking or re-upload
+        CpuOnly         //!< never uploaded, a source for streaming or processing
+    };
+
+    //! arguments of one glMultiDrawElementsBaseVertex call
+    struct DrawList
+    {
+        std::vector<GLsizei> counts;
+        std::vector<void*> offsets;
+        std::vector<GLint> baseVertices;
+
+        void Add(GLsizei count, std::size_t offset, GLint baseVertex);
+        void Append(const DrawList& other, GLsizei first, GLsizei count);
+        void Clear();
+        GLsizei Size() const;
     };
 
     class Mesh 
@@ -36,19 +101,84 @@ namespace OGL
     public:
         ~Mesh();
         Mesh() = default;
-        void Create(std::string path);
+        void Create(std::string path, VertexFormat format = VertexFormat());
+        void Load(const std::string& path, bool useCache = true, bool buildBvh = false, bool progressive = false);
+        void Upload(VertexFormat format = VertexFormat(), bool progressive = false);
+        bool Refine();
+
+        void Draw(float maxError = 0);
+        void GatherDraws(float maxError, DrawList& draws) const;
+        GeometryArena* Arena() const;
+
+        bool IsResident() const;
+        bool IsRefining() const;
+        void SetResidency(Residency residency);
+        Residency GetResidency() const;
+        std::size_t CpuBytes() const;
+        std::size_t GpuBytes() const;
+        std::uint64_t ContentKey() const;
+
+        const VertexFormat& Format() const;
+        const VertexDecode& Decode() const;
+        const std::vector<Vertex>& Vertices() const;
+        const std::vector<SubMesh>& SubMeshes() const;
+        const std::vector<MeshLod>& Lods() const;
+        bool HasBvh() const;
+        const MeshData& Data() const;
+        Bounds GetBounds() const;
+        BoundingSphere GetSphere() const;
 
-        void Draw();
+        //! Assimp post processing applied to every import, part of the cache key
+        static constexpr unsigned ImportFlags = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices;
+
+        //! faces meeting at a sharper angle get a hard edge when normals are generated, a MeshCache::Version bump applies a change
+        static constexpr float NormalCreaseDegrees = 60.0f;
+
+        //! largest vertex range a 16 bit index can address
+        static constexpr std::size_t ShortIndexRange = 1 << 16;
+
+        //! LOD chain limits, each level targets LodReduction of the previous one's triangles
+        static constexpr unsigned MaxLods = 8;
+        static constexpr float LodReduction = 0.5f;
+        static constexpr std::size_t LodMinTriangles = 64;
 
     private:
+        void Release();
+        void Track() const;
+        void ComputeBounds();
+        void Import(const std::string& path);
+        void GenerateNormals();
+        void Optimize();
+        void BuildLods();
+        void OrderProgressive();
+        void BuildMeshlets();
+        void BuildBvh();
         void GetMesh(aiMesh* mesh);
 
-        GLuint mVBO = 0;
-        GLuint mVAO = 0;
-        GLuint mIBO = 0;
+        GeometryArena* mArena = nullptr;    //!< shared by every mesh of the same format and index type
+        GeometryArena::Handle mAllocation = GeometryArena::InvalidHandle;
+
+        VertexFormat mFormat;
+        VertexDecode mDecode;
+
+        GLenum mIndexType = GL_UNSIGNED_INT;
+        DrawList mDraws;                    //!< every LOD of every submesh, relative to the allocation
+        std::vector<GLsizei> mLodDraws;     //!< draws of LOD i are [mLodDraws[i], mLodDraws[i + 1])
+        DrawList mFrameDraws;               //!< the draws picked by the last Draw call
+        bool mResident = false;
+        GLuint mStreamedLevels = 0;         //!< LODs written so far, coarsest first, drawing never picks a finer one
+        GLuint mLevelCount = 0;             //!< LODs of the longest chain, the mesh is refined once they are all written
+        std::vector<unsigned char> mStreamVertices; //!< packed vertices, until refined
+        std::vector<GLushort> mStreamIndices;       //!< 16 bit indices, until refined
+        std::vector<std::size_t> mLodIndices;       //!< first index and index count of each LOD in the allocation, until refined
+        Residency mResidency = Residency::CpuAndGpu;
+        std::size_t mGpuBytes = 0;
+        std::uint64_t mContentKey = 0;      //!< MeshData::Hash of the loaded data, kept after it is released
+        Bounds mBounds;                     //!< of every vertex, kept after the data is released
+        BoundingSphere mSphere;
+        std::string mName;
 
-        std::vector<Vertex> mVertices;
-        std::vector<GLuint> mIndices;
+        MeshData mData;
     };
 }
 
@@ -0,0 +1,49 @@
+/****************************************************************************/
+/*!
+\file
+   MeshBounds.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Vectorized vertex conversion and bounding volumes
+*/
+/****************************************************************************/
+#ifndef MESHBOUNDS_HPP
+#define MESHBOUNDS_HPP
+#pragma once
+
+#include "VertexFormat.hpp"
+
+namespace OGL
+{
+    //! axis aligned bounding box
+    struct Bounds
+    {
+        glm::vec3 min = glm::vec3(0);
+        glm::vec3 max = glm::vec3(0);
+    };
+
+    //! sphere holding every vertex
+    struct BoundingSphere
+    {
+        glm::vec3 center = glm::vec3(0);
+        float radius = 0;
+    };
+
+    namespace MeshBounds
+    {
+        //! farthest point steps the sphere fit takes before settling for what it has
+        constexpr unsigned SphereIterations = 16;
+
+        void Convert(const float* positions, const float* normals, std::size_t count, Vertex* vertices);
+
+        Bounds ComputeAabb(const Vertex* vertices, std::size_t count);
+        BoundingSphere ComputeSphere(const Vertex* vertices, std::size_t count, const Bounds& aabb);
+        void Compute(const Vertex* vertices, std::size_t count, Bounds& aabb, BoundingSphere& sphere);
+    }
+}
+
+#endif // MESHBOUNDS_HPP
@@ -0,0 +1,45 @@
+/****************************************************************************/
+/*!
+\file
+   MeshCache.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Versioned binary cache of imported, upload-ready mesh data
+*/
+/****************************************************************************/
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+#pragma once
+
+#include "Mesh.hpp"
+
+namespace OGL
+{
+    class MeshCache
+    {
+    public:
+        MeshCache(const std::string& source, unsigned importFlags, bool progressive = false);
+
+        bool Load(MeshData& data) const;
+        void Save(const MeshData& data) const;
+
+        std::uint64_t Key() const;
+        const std::string& Path() const;
+
+        //! bump whenever the layout of the cache file or the import changes
+        static constexpr std::uint32_t Version = 14;
+
+        //! where cache files are written, relative to the working directory
+        static constexpr const char* Directory = "../Resource/Cache/Meshes/";
+
+    private:
+        std::uint64_t mKey = 0;
+        std::string mPath;
+    };
+}
+
+#endif // MESHCACHE_HPP
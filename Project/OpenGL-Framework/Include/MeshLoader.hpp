@@ -0,0 +1,76 @@
+/****************************************************************************/
+/*!
+\file
+   MeshLoader.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Asynchronous mesh loading. Import, optimization and the mesh cache run
+    on worker threads, the GL thread uploads finished meshes in Update.
+*/
+/****************************************************************************/
+#ifndef MESHLOADER_HPP
+#define MESHLOADER_HPP
+#pragma once
+
+#include "Mesh.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace OGL
+{
+    class MeshLoader
+    {
+    public:
+        ~MeshLoader();
+        explicit MeshLoader(unsigned threads = 1);
+
+        MeshLoader(const MeshLoader&) = delete;
+        MeshLoader& operator=(const MeshLoader&) = delete;
+
+        //! runs on the GL thread once a load finishes, return false to skip the upload,
+        //! a failed load leaves the mesh empty and the return value is ignored
+        using Loaded = std::function<bool(Mesh& mesh, bool failed)>;
+
+        void LoadAsync(Mesh& mesh, const std::string& path, VertexFormat format = VertexFormat(), Loaded loaded = nullptr,
+            bool buildBvh = false, bool progressive = false);
+        unsigned Update(double budgetMs);
+        void Finish();
+        void Cancel();
+
+        std::size_t Pending() const;
+
+    private:
+        //! one queued load, the mesh must outlive the loader or the job
+        struct Job
+        {
+            Mesh* mesh = nullptr;
+            std::string path;
+            VertexFormat format;
+            Loaded loaded;
+            bool buildBvh = false;
+            bool progressive = false;   //!< ordered for streaming, see Mesh::Load
+            bool failed = false;
+        };
+
+        void Worker();
+
+        std::vector<std::thread> mThreads;
+        std::deque<Job> mQueued;            //!< waiting for a worker
+        std::deque<Job> mLoaded;            //!< waiting for the GL thread
+        std::deque<Job> mRefining;          //!< uploaded, streaming finer LODs, only touched on the GL thread
+        std::size_t mLoading = 0;           //!< taken by a worker
+        mutable std::mutex mMutex;
+        std::condition_variable mWake;      //!< signals workers
+        std::condition_variable mDone;      //!< signals Finish
+        bool mStop = false;
+    };
+}
+
+#endif // MESHLOADER_HPP
@@ -0,0 +1,53 @@
+/****************************************************************************/
+/*!
+\file
+   MeshOptimizer.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Offline triangle and vertex reordering for post-transform vertex cache,
+    overdraw and vertex fetch locality
+*/
+/****************************************************************************/
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+#pragma once
+
+#include "VertexFormat.hpp"
+
+namespace OGL
+{
+    //! post-transform cache efficiency of an index buffer
+    struct VertexCacheStats
+    {
+        float acmr = 0;     //!< cache misses per triangle, 0.5 is ideal, 3 is worst
+        float atvr = 0;     //!< cache misses per vertex, 1 is ideal
+    };
+
+    namespace MeshOptimizer
+    {
+        //! FIFO size the optimizer and the statistics model
+        constexpr unsigned CacheSize = 16;
+
+        //! how much worse than the whole cluster a split point may be
+        constexpr float OverdrawThreshold = 1.05f;
+
+        VertexCacheStats Analyze(const GLuint* indices, std::size_t indexCount, std::size_t vertexCount, unsigned cacheSize = CacheSize);
+
+        void OptimizeVertexCache(GLuint* indices, std::size_t indexCount, std::size_t vertexCount,
+            std::vector<std::size_t>& clusters, unsigned cacheSize = CacheSize);
+
+        void OptimizeOverdraw(GLuint* indices, std::size_t indexCount, const Vertex* vertices, std::size_t vertexCount,
+            const std::vector<std::size_t>& clusters, float threshold = OverdrawThreshold, unsigned cacheSize = CacheSize);
+
+        void OptimizeVertexFetch(Vertex* vertices, std::size_t vertexCount, GLuint* indices, std::size_t indexCount);
+
+        void Optimize(Vertex* vertices, std::size_t vertexCount, GLuint* indices, std::size_t indexCount,
+            VertexCacheStats* before = nullptr, VertexCacheStats* after = nullptr);
+    }
+}
+
+#endif // MESHOPTIMIZER_HPP
@@ -0,0 +1,99 @@
+/****************************************************************************/
+/*!
+\file
+   MeshRegistry.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Hands out shared, reference counted meshes so equal geometry is only
+    ever uploaded once
+*/
+/****************************************************************************/
+#ifndef MESHREGISTRY_HPP
+#define MESHREGISTRY_HPP
+#pragma once
+
+#include "Mesh.hpp"
+#include "MeshLoader.hpp"
+#include <unordered_map>
+
+namespace OGL
+{
+    //! reference to a registry mesh, the mesh lives while any handle to it does
+    class MeshHandle
+    {
+    public:
+        MeshHandle() = default;
+
+        Mesh* Get() const;
+        Mesh* operator->() const;
+        Mesh& operator*() const;
+
+        bool IsResident() const;
+        bool IsLoaded() const;
+        bool IsFailed() const;
+
+    private:
+        friend class MeshRegistry;
+
+        //! filled in once the load finishes, possibly with another path's mesh
+        struct Slot
+        {
+            std::shared_ptr<Mesh> mesh;
+            bool failed = false;
+        };
+
+        explicit MeshHandle(std::shared_ptr<Slot> slot);
+
+        std::shared_ptr<Slot> mSlot;
+    };
+
+    //! GL thread only, the loads themselves run on the loader's threads
+    class MeshRegistry
+    {
+    public:
+        explicit MeshRegistry(MeshLoader& loader);
+
+        MeshRegistry(const MeshRegistry&) = delete;
+        MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+        MeshHandle Load(const std::string& path, VertexFormat format = VertexFormat(), Residency residency = Residency::GpuOnly,
+            bool buildBvh = false, bool progressive = false);
+        void Collect();
+
+        std::size_t MeshCount() const;
+        std::size_t SharedLoads() const;
+
+    private:
+        //! a path loaded with one format, residency and BVH setting
+        struct PathKey
+        {
+            std::string path;
+            VertexFormat format;
+            Residency residency;
+            bool buildBvh;
+            bool progressive;
+
+            bool operator==(const PathKey& other) const;
+        };
+
+        struct PathHash
+        {
+            std::size_t operator()(const PathKey& key) const;
+        };
+
+        bool Resolve(const std::weak_ptr<MeshHandle::Slot>& slot, const std::shared_ptr<Mesh>& mesh,
+            VertexFormat format, Residency residency);
+        void Fail(const std::weak_ptr<MeshHandle::Slot>& slot, const PathKey& key);
+
+        MeshLoader& mLoader;
+        std::unordered_map<PathKey, std::weak_ptr<MeshHandle::Slot>, PathHash> mPaths;
+        std::unordered_map<std::uint64_t, std::weak_ptr<Mesh>> mMeshes;    //!< by content, format, residency and BVH
+        std::size_t mSharedLoads = 0;
+    };
+}
+
+#endif // MESHREGISTRY_HPP
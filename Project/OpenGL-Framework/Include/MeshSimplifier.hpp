@@ -0,0 +1,29 @@
+/****************************************************************************/
+/*!
+\file
+   MeshSimplifier.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Quadric error edge collapse simplification, used to build the LOD chain
+*/
+/****************************************************************************/
+#ifndef MESHSIMPLIFIER_HPP
+#define MESHSIMPLIFIER_HPP
+#pragma once
+
+#include "VertexFormat.hpp"
+
+namespace OGL
+{
+    namespace MeshSimplifier
+    {
+        float Simplify(const Vertex* vertices, std::size_t vertexCount, const GLuint* indices, std::size_t indexCount,
+            std::size_t targetIndexCount, float targetError, std::vector<GLuint>& result);
+    }
+}
+
+#endif // MESHSIMPLIFIER_HPP
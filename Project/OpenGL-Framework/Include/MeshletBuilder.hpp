@@ -0,0 +1,65 @@
+/****************************************************************************/
+/*!
+\file
+   MeshletBuilder.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Splits triangle lists into small clusters with culling bounds
+*/
+/****************************************************************************/
+#ifndef MESHLETBUILDER_HPP
+#define MESHLETBUILDER_HPP
+#pragma once
+
+#include "VertexFormat.hpp"
+
+namespace OGL
+{
+    //! a cluster of triangles, small enough to cull on its own
+    struct Meshlet
+    {
+        GLuint firstVertex = 0;         //!< into the meshlet vertex array
+        GLuint firstTriangle = 0;       //!< into the meshlet triangle array, in triangles
+        GLuint vertexCount = 0;
+        GLuint triangleCount = 0;
+
+        glm::vec3 center = glm::vec3(0);    //!< bounding sphere
+        float radius = 0;
+
+        glm::vec3 coneApex = glm::vec3(0);  //!< backface cone, see MeshletBuilder::IsBackfacing
+        float coneCutoff = 2;               //!< above 1 the cluster is never backfacing
+        glm::vec3 coneAxis = glm::vec3(0, 0, 1);
+        float padding = 0;
+    };
+
+    //! how full the built meshlets are, 1 is perfect
+    struct MeshletStats
+    {
+        std::size_t meshletCount = 0;
+        std::size_t coneCount = 0;      //!< meshlets with a usable backface cone
+        float vertexFill = 0;           //!< mean vertices / MaxVertices
+        float triangleFill = 0;         //!< mean triangles / MaxTriangles
+    };
+
+    namespace MeshletBuilder
+    {
+        //! cluster limits, the usual mesh shader sweet spot
+        constexpr unsigned MaxVertices = 64;
+        constexpr unsigned MaxTriangles = 124;
+
+        //! triangles per independently built block, fixed so the output does not depend on the thread count
+        constexpr std::size_t BlockTriangles = 4096;
+
+        MeshletStats Build(const Vertex* vertices, std::size_t vertexCount, const GLuint* indices, std::size_t indexCount,
+            std::vector<Meshlet>& meshlets, std::vector<GLuint>& meshletVertices, std::vector<std::uint8_t>& meshletTriangles);
+
+        bool IsBackfacing(const Meshlet& meshlet, const glm::vec3& eye);
+        bool IsOutside(const Meshlet& meshlet, const glm::vec4 planes[6]);
+    }
+}
+
+#endif // MESHLETBUILDER_HPP
@@ -0,0 +1,31 @@
+/****************************************************************************/
+/*!
+\file
+   NormalGenerator.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Multi-threaded angle weighted smooth normals with hard creases
+*/
+/****************************************************************************/
+#ifndef NORMALGENERATOR_HPP
+#define NORMALGENERATOR_HPP
+#pragma once
+
+#include "VertexFormat.hpp"
+
+namespace OGL
+{
+    namespace NormalGenerator
+    {
+        bool HasNormals(const Vertex* vertices, std::size_t vertexCount);
+
+        void Generate(const Vertex* vertices, std::size_t vertexCount, const GLuint* indices, std::size_t indexCount,
+            float creaseAngle, std::vector<Vertex>& outVertices, std::vector<GLuint>& outIndices);
+    }
+}
+
+#endif // NORMALGENERATOR_HPP
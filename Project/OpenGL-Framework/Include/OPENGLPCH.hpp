@@ -23,6 +23,7 @@
 #include <gtc/matrix_transform.hpp>
 
 // GLFW
+#define NOMINMAX // windows.h via glfw3native, keep std::min / std::max usable
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include "glfw3.h"
 #include "glfw3native.h"
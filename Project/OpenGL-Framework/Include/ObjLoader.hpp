@@ -0,0 +1,36 @@
+/****************************************************************************/
+/*!
+\file
+   ObjLoader.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Multi-threaded, memory mapped Wavefront OBJ loader. Produces the same
+    triangulated, welded data as the Assimp path in Mesh::Import without
+    going through Assimp, missing normals are left for Mesh to generate.
+*/
+/****************************************************************************/
+#ifndef OBJLOADER_HPP
+#define OBJLOADER_HPP
+#pragma once
+
+#include "Mesh.hpp"
+
+namespace OGL
+{
+    namespace ObjLoader
+    {
+        //! smallest file chunk worth parsing on its own thread
+        constexpr std::size_t MinChunkSize = 1 << 20;
+
+        bool IsObj(const std::string& path);
+
+        bool Load(const std::string& path, std::vector<Vertex>& vertices,
+            std::vector<GLuint>& indices, std::vector<SubMesh>& subMeshes);
+    }
+}
+
+#endif // OBJLOADER_HPP
@@ -0,0 +1,156 @@
+/****************************************************************************/
+/*!
+\file
+   Parallel.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Minimal fork / join helpers for the offline mesh processing passes
+*/
+/****************************************************************************/
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace OGL
+{
+
+/****************************************************************************/
+/*!
+\brief
+    Number of worker threads the parallel passes use
+
+\return
+    Hardware thread count, at least 1
+*/
+/****************************************************************************/
+    inline unsigned ThreadCount()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+/****************************************************************************/
+/*!
+\brief
+    Number of ranges ParallelFor splits count items into, so per range
+    results can be allocated up front
+
+\param count
+    Number of items
+
+\param minPerThread
+    Smallest range worth a thread
+
+\return
+    Range count, at least 1
+*/
+/****************************************************************************/
+    inline unsigned ParallelRanges(std::size_t count, std::size_t minPerThread)
+    {
+        std::size_t maxRanges = std::max<std::size_t>(1, count / std::max<std::size_t>(1, minPerThread));
+        return unsigned(std::min<std::size_t>(ThreadCount(), maxRanges));
+    }
+
+/****************************************************************************/
+/*!
+\brief
+    Split [0, count) into contiguous ranges and run them on worker threads,
+    the calling thread runs the first range. The split depends only on count
+    and the thread count, so results written per range are deterministic.
+
+\param count
+    Number of items
+
+\param minPerThread
+    Smallest range worth a thread
+
+\param func
+    Called as func(begin, end, rangeIndex)
+
+\return
+    Number of ranges used
+*/
+/****************************************************************************/
+    template <typename Func>
+    inline unsigned ParallelFor(std::size_t count, std::size_t minPerThread, Func&& func)
+    {
+        unsigned ranges = ParallelRanges(count, minPerThread);
+        std::size_t step = (count + ranges - 1) / ranges;
+
+        std::vector<std::thread> threads;
+        threads.reserve(ranges);
+        for (unsigned r = 1; r < ranges; ++r)
+        {
+            std::size_t begin = std::min(count, r * step);
+            std::size_t end = std::min(count, begin + step);
+            threads.emplace_back([&func, begin, end, r]() { func(begin, end, r); });
+        }
+
+        func(0, std::min(count, step), 0u);
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        return ranges;
+    }
+
+/****************************************************************************/
+/*!
+\brief
+    Sort on the worker threads, each range is sorted on its own and the
+    sorted runs are then merged pairwise. The comparison must be a total
+    order for the result to be deterministic.
+
+\param first
+    Start of the range to sort
+
+\param last
+    End of the range to sort
+
+\param less
+    Strict weak ordering
+
+\param minPerThread
+    Smallest range worth a thread
+*/
+/****************************************************************************/
+    template <typename Iterator, typename Less>
+    inline void ParallelSort(Iterator first, Iterator last, Less less, std::size_t minPerThread = 1 << 16)
+    {
+        const std::size_t count = std::size_t(last - first);
+        unsigned ranges = ParallelRanges(count, minPerThread);
+        std::size_t step = (count + ranges - 1) / std::max(1u, ranges);
+
+        ParallelFor(count, minPerThread, [&](std::size_t begin, std::size_t end, unsigned)
+        {
+            std::sort(first + begin, first + end, less);
+        });
+
+        // runs of width sorted elements, merge neighbours until one is left
+        for (std::size_t width = step; width > 0 && width < count; width *= 2)
+        {
+            std::size_t pairs = (count + 2 * width - 1) / (2 * width);
+            ParallelFor(pairs, 1, [&](std::size_t begin, std::size_t end, unsigned)
+            {
+                for (std::size_t pair = begin; pair < end; ++pair)
+                {
+                    std::size_t low = pair * 2 * width;
+                    std::size_t middle = std::min(count, low + width);
+                    std::size_t high = std::min(count, low + 2 * width);
+                    std::inplace_merge(first + low, first + middle, first + high, less);
+                }
+            });
+        }
+    }
+}
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,60 @@
+/****************************************************************************/
+/*!
+\file
+   RayCaster.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Ray queries against mesh triangles, for picking and other CPU side
+    lookups
+*/
+/****************************************************************************/
+#ifndef RAYCASTER_HPP
+#define RAYCASTER_HPP
+#pragma once
+
+#include "Mesh.hpp"
+#include <limits>
+
+namespace OGL
+{
+    //! hits are only reported between tMin and tMax, in units of direction
+    struct Ray
+    {
+        glm::vec3 origin = glm::vec3(0);
+        float tMin = 0;
+        glm::vec3 direction = glm::vec3(0, 0, -1);
+        float tMax = std::numeric_limits<float>::max();
+    };
+
+    //! the closest hit found so far, passed through several queries it finds the closest of a scene
+    struct RayHit
+    {
+        const Mesh* mesh = nullptr;     //!< nullptr until something is hit
+        GLuint subMesh = 0;
+        GLuint triangle = 0;            //!< relative to the submesh's first index, in triangles
+        float t = std::numeric_limits<float>::max();
+        glm::vec2 barycentrics = glm::vec2(0);  //!< weights of the triangle's second and third vertex
+    };
+
+    namespace RayCaster
+    {
+        //! rays traced together by the batch query
+        constexpr unsigned PacketSize = 4;
+
+        //! smallest number of packets worth a thread
+        constexpr std::size_t MinPacketsPerThread = 64;
+
+        bool Intersect(const Mesh& mesh, const Ray& ray, RayHit& hit);
+        void Intersect(const Mesh& mesh, const Ray* rays, std::size_t count, RayHit* hits);
+        bool IntersectLinear(const Mesh& mesh, const Ray& ray, RayHit& hit);
+
+        Ray Transform(const Ray& ray, const glm::mat4& transform);
+        Ray ScreenRay(const glm::mat4& projection, const glm::mat4& view, const glm::vec2& cursor, const glm::vec2& viewport);
+    }
+}
+
+#endif // RAYCASTER_HPP
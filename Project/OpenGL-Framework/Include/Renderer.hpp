@@ -17,7 +17,13 @@
 #pragma once
 
 #include "Mesh.hpp"
+#include "MeshLoader.hpp"
+#include "MeshRegistry.hpp"
 #include "Shader.hpp"
+#include "ShaderVariants.hpp"
+#include "ShaderWatcher.hpp"
+#include "Timer.hpp"
+#include "UniformBuffer.hpp"
 
 struct GLFWwindow;
 typedef GLFWwindow* WindowPtr;
@@ -52,6 +58,7 @@ namespace OGL
         void ShutdownOGL();
 
         void Present();
+        void Pick(const glm::mat4& world);
 
         // window
         WindowPtr mWindow = nullptr;
@@ -61,11 +68,26 @@ namespace OGL
         bool mFramebufferResized = false;
 
         // scene
-        OGL::Mesh mMesh;
-        OGL::Shader mShader;
+        OGL::MeshRegistry mMeshes{ mLoader };
+        OGL::MeshHandle mMesh;
+        OGL::ShaderWatcher mShaderWatcher; //!< before the shaders so it outlives them
+        OGL::ShaderVariants mShaders{ "../Resource/Shaders/Simple.vert", "../Resource/Shaders/Simple.frag", { "OCTAHEDRAL_NORMALS" } };
+        OGL::UniformRing mUniforms;
+        OGL::MeshLoader mLoader;    //!< after the meshes so it is destroyed first
         glm::mat4 mProj = glm::mat4(1);
         glm::mat4 mView = glm::mat4(1);
+        float mFov = 0.42173f;
+        float mNearPlane = 0.1f;
         float mAngle = 0;
+        bool mMouseDown = false;
+
+        // LOD
+        static constexpr float LodPixelError = 1.0f;   //!< screen space error a LOD may introduce
+
+        // startup
+        static constexpr double UploadBudget = 2.0;   //!< ms of mesh uploads per frame
+        Timer mStartup;
+        bool mFirstFrame = true;
     };
 }
 
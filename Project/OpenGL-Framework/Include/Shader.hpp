@@ -14,36 +14,148 @@
 #pragma once
 
 #include "OPENGLPCH.hpp"
+#include "Hash.hpp"
+#include "Timer.hpp"
 
 namespace OGL
 {
+    //! location of a uniform, -1 for one the program does not have, setting it is then ignored
+    using UniformHandle = GLint;
+
+    //! a uniform's name hashed with HashName, declared constexpr the hashing happens at compile time
+    struct UniformName
+    {
+        constexpr UniformName(const char* name) : hash(HashName(name)) {}
+
+        std::uint64_t hash;
+    };
+
+    //! one active uniform, as reflected after linking
+    struct ShaderUniform
+    {
+        std::uint64_t hash = 0;     //!< HashName of the name, array elements are also found by the bare array name
+        GLint location = -1;
+        GLenum type = 0;
+        GLint size = 0;             //!< array length, 1 for a single value
+        std::string name;
+    };
+
+    //! one member of a uniform block, as reflected after linking
+    struct ShaderBlockMember
+    {
+        GLint offset = 0;
+        GLenum type = 0;
+        std::string name;
+    };
+
+    //! one active uniform block
+    struct ShaderBlock
+    {
+        std::uint64_t hash = 0;     //!< HashName of the block name
+        GLuint index = 0;
+        GLint size = 0;             //!< bytes of buffer the block reads
+        std::string name;
+        std::vector<ShaderBlockMember> members;    //!< sorted by offset
+    };
+
     class Shader
     {
     public:
         ~Shader();
         Shader() = default;
-        void Create(const std::string vertexShader, const std::string fragmentShader);
+        void Create(const std::string vertexShader, const std::string fragmentShader, bool useCache = true,
+            const std::vector<std::string>& defines = {});
+
+        void Submit(const std::string vertexShader, const std::string fragmentShader, bool useCache = true,
+            const std::vector<std::string>& defines = {});
+        bool IsCompiled() const;
+        void Complete();
 
         void Use();
 
-        void SetUniform(const std::string name, bool value) const;
-        void SetUniform(const std::string name, int value) const;
-        void SetUniform(const std::string name, float value) const;
-        void SetUniform(const std::string name, const glm::vec2 value) const;
-        void SetUniform(const std::string name, float x, float y) const;
-        void SetUniform(const std::string name, const glm::vec3 value) const;
-        void SetUniform(const std::string name, float x, float y, float z) const;
-        void SetUniform(const std::string name, const glm::vec4 value) const;
-        void SetUniform(const std::string name, float x, float y, float z, float w);
-        void SetUniform(const std::string name, const glm::mat2 mat) const;
-        void SetUniform(const std::string name, const glm::mat3 mat) const;
-        void SetUniform(const std::string name, const glm::mat4 mat) const;
+        bool BeginReload();
+        bool UpdateReload();
+        bool IsReloading() const;
+        bool IsLinked() const;
+        double BuildMilliseconds() const;
+        bool IsFromCache() const;
+        const std::string& VertexPath() const;
+        const std::string& FragmentPath() const;
+        const std::vector<std::string>& Defines() const;
+        const std::vector<std::string>& Files() const;
+
+        UniformHandle Uniform(UniformName name) const;
+        const std::vector<ShaderUniform>& Uniforms() const;
+        const std::vector<ShaderBlock>& Blocks() const;
+
+        void SetUniform(UniformHandle handle, bool value) const;
+        void SetUniform(UniformHandle handle, int value) const;
+        void SetUniform(UniformHandle handle, float value) const;
+        void SetUniform(UniformHandle handle, const glm::vec2 value) const;
+        void SetUniform(UniformHandle handle, float x, float y) const;
+        void SetUniform(UniformHandle handle, const glm::vec3 value) const;
+        void SetUniform(UniformHandle handle, float x, float y, float z) const;
+        void SetUniform(UniformHandle handle, const glm::vec4 value) const;
+        void SetUniform(UniformHandle handle, float x, float y, float z, float w) const;
+        void SetUniform(UniformHandle handle, const glm::mat2 mat) const;
+        void SetUniform(UniformHandle handle, const glm::mat3 mat) const;
+        void SetUniform(UniformHandle handle, const glm::mat4 mat) const;
+
+        //! set a uniform by name, looked up in the reflected table without calling into GL
+        template <typename... Args>
+        void SetUniform(UniformName name, const Args&... args) const
+        {
+            SetUniform(Uniform(name), args...);
+        }
+
+        //! check a block struct, see Std140Layout, against the program's block of the same
+        //! name and bind the block to the struct's binding point
+        template <typename Block>
+        bool BindBlock()
+        {
+            return BindBlock(Block::Name, Block::Binding, Block::Layout::Offsets.data(), Block::Layout::Types.data(),
+                Block::Layout::Count, sizeof(Block));
+        }
 
     private:
+        //! a BindBlock call, replayed whenever a reload swaps in a new program
+        struct BlockBinding
+        {
+            UniformName name;
+            GLuint binding;
+            const std::size_t* offsets;
+            const GLenum* types;
+            std::size_t count;
+            std::size_t size;
+        };
 
-        GLuint LoadShader(const std::string shader, const int type);
+        void Preprocess(std::string& vertexSource, std::string& fragmentSource);
+        void Start(const std::string& vertexSource, const std::string& fragmentSource, bool useCache);
+        std::string Resolve();
+        GLuint Build(const std::string& vertexSource, const std::string& fragmentSource, GLuint* stages);
+        std::string Finish(GLuint program, GLuint* stages);
+        void Adopt(GLuint program);
+        void Reflect();
+        bool BindBlock(UniformName name, GLuint binding, const std::size_t* offsets, const GLenum* types, std::size_t count, std::size_t size);
+        bool ApplyBlock(const BlockBinding& binding);
 
         GLuint mID = 0;
+        std::vector<ShaderUniform> mUniforms;   //!< sorted by hash
+        std::vector<ShaderBlock> mBlocks;
+        std::vector<BlockBinding> mBlockBindings;
+
+        std::string mVertexPath;
+        std::string mFragmentPath;
+        std::vector<std::string> mDefines;
+        std::vector<std::string> mFiles;        //!< stages and includes, for the shader watcher
+
+        /* build in flight, linked in the background while mID keeps drawing */
+        GLuint mPending = 0;
+        GLuint mPendingStages[2] = { 0, 0 };
+        std::vector<std::string> mPendingSources;   //!< for the cache key
+        Timer mPendingTimer;
+        double mBuildMilliseconds = 0;
+        bool mFromCache = false;
     };
 }
 
@@ -0,0 +1,63 @@
+/****************************************************************************/
+/*!
+\file
+   ShaderBatch.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Builds many shader programs side by side
+*/
+/****************************************************************************/
+#ifndef SHADERBATCH_HPP
+#define SHADERBATCH_HPP
+#pragma once
+
+#include "OPENGLPCH.hpp"
+#include "Shader.hpp"
+#include "Timer.hpp"
+
+namespace OGL
+{
+    class ShaderBatch
+    {
+    public:
+        void Add(Shader& shader, const std::string& vertexShader, const std::string& fragmentShader, bool useCache = true,
+            const std::vector<std::string>& defines = {});
+        void Submit();
+        bool Update();
+        void Complete();
+        void Report() const;
+
+        std::size_t Pending() const;
+        double Milliseconds() const;
+
+        static bool IsParallel();
+        static GLint CompilerThreads();
+
+    private:
+        //! one program of the batch
+        struct Entry
+        {
+            Shader* shader;         //!< not owned, must outlive the batch's Complete
+            std::string vertexShader;
+            std::string fragmentShader;
+            bool useCache;
+            std::vector<std::string> defines;
+            bool submitted = false;
+            bool done = false;
+            std::string errors;     //!< compile and link logs if it failed
+        };
+
+        bool Resolve(Entry& entry);
+
+        std::vector<Entry> mEntries;
+        std::size_t mPending = 0;
+        Timer mTimer;
+        double mMilliseconds = 0;   //!< wall time from Submit until the last program was picked up
+    };
+}
+
+#endif // SHADERBATCH_HPP
@@ -0,0 +1,47 @@
+/****************************************************************************/
+/*!
+\file
+   ShaderCache.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    On disk cache of linked program binaries
+*/
+/****************************************************************************/
+#ifndef SHADERCACHE_HPP
+#define SHADERCACHE_HPP
+#pragma once
+
+#include "OPENGLPCH.hpp"
+
+namespace OGL
+{
+    class ShaderCache
+    {
+    public:
+        ShaderCache(const std::vector<std::string>& sources, const std::string& defines = std::string());
+
+        bool Load(GLuint program) const;
+        void Save(GLuint program) const;
+
+        std::uint64_t Key() const;
+        const std::string& Path() const;
+
+        static bool IsSupported();
+
+        //! bump whenever the layout of the cache file changes
+        static constexpr std::uint32_t Version = 1;
+
+        //! where cache files are written, relative to the working directory
+        static constexpr const char* Directory = "../Resource/Cache/Shaders/";
+
+    private:
+        std::uint64_t mKey = 0;
+        std::string mPath;
+    };
+}
+
+#endif // SHADERCACHE_HPP
@@ -0,0 +1,38 @@
+/****************************************************************************/
+/*!
+\file
+   ShaderPreprocessor.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Resolves #include and injects defines before GLSL reaches the driver
+*/
+/****************************************************************************/
+#ifndef SHADERPREPROCESSOR_HPP
+#define SHADERPREPROCESSOR_HPP
+#pragma once
+
+#include "OPENGLPCH.hpp"
+
+namespace OGL
+{
+    //! a shader stage ready for glShaderSource
+    struct ShaderSource
+    {
+        std::string code;
+        std::vector<std::string> files;     //!< every file read, the stage first, indexed by the #line source numbers
+    };
+
+    namespace ShaderPreprocessor
+    {
+        //! deepest #include nesting before the file is rejected
+        constexpr unsigned MaxIncludeDepth = 16;
+
+        ShaderSource Process(const std::string& path, const std::vector<std::string>& defines = {});
+    }
+}
+
+#endif // SHADERPREPROCESSOR_HPP
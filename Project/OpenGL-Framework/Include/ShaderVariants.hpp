@@ -0,0 +1,74 @@
+/****************************************************************************/
+/*!
+\file
+   ShaderVariants.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Programs specialized by a set of feature defines, built on demand
+*/
+/****************************************************************************/
+#ifndef SHADERVARIANTS_HPP
+#define SHADERVARIANTS_HPP
+#pragma once
+
+#include "OPENGLPCH.hpp"
+#include "Shader.hpp"
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+namespace OGL
+{
+    class ShaderWatcher;
+
+    //! one bit per feature, bit i defines the i-th feature name
+    using ShaderFeatures = std::uint32_t;
+
+    class ShaderVariants
+    {
+    public:
+        ~ShaderVariants();
+        ShaderVariants(const std::string& vertexShader, const std::string& fragmentShader, const std::vector<std::string>& features);
+
+        ShaderVariants(const ShaderVariants&) = delete;
+        ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+        Shader& Get(ShaderFeatures features);
+        void Preload(const std::vector<ShaderFeatures>& variants);
+        bool IsLoaded(ShaderFeatures features) const;
+        std::size_t Count() const;
+
+        std::vector<std::string> Defines(ShaderFeatures features) const;
+        void Watch(ShaderWatcher& watcher);
+
+        //! bind a block, see Shader::BindBlock, in every variant built so far and from now on
+        template <typename Block>
+        void BindBlock()
+        {
+            mBindings.push_back([](Shader& shader) { shader.BindBlock<Block>(); });
+            for (auto& variant : mVariants)
+            {
+                mBindings.back()(*variant.second);
+            }
+        }
+
+        //! features a set can name
+        static constexpr std::size_t MaxFeatures = 32;
+
+    private:
+        Shader& Variant(ShaderFeatures features);
+
+        std::string mVertexShader;
+        std::string mFragmentShader;
+        std::vector<std::string> mFeatures;
+        std::unordered_map<ShaderFeatures, std::unique_ptr<Shader>> mVariants;
+        std::vector<std::function<void(Shader&)>> mBindings;
+        ShaderWatcher* mWatcher = nullptr;  //!< must outlive the variants
+    };
+}
+
+#endif // SHADERVARIANTS_HPP
@@ -0,0 +1,37 @@
+/****************************************************************************/
+/*!
+\file
+   ShaderWatcher.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Reloads shaders whose source files change on disk
+*/
+/****************************************************************************/
+#ifndef SHADERWATCHER_HPP
+#define SHADERWATCHER_HPP
+#pragma once
+
+#include "OPENGLPCH.hpp"
+#include "FileWatcher.hpp"
+#include "Shader.hpp"
+
+namespace OGL
+{
+    class ShaderWatcher
+    {
+    public:
+        void Watch(Shader& shader);
+        void Unwatch(const Shader& shader);
+        void Update();
+
+    private:
+        std::vector<Shader*> mShaders;  //!< not owned, unwatch a shader before destroying it
+        FileWatcher mFiles;
+    };
+}
+
+#endif // SHADERWATCHER_HPP
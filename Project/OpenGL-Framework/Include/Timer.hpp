@@ -0,0 +1,58 @@
+/****************************************************************************/
+/*!
+\file
+   Timer.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    High resolution wall clock timer for profiling and benchmarks
+*/
+/****************************************************************************/
+#ifndef TIMER_HPP
+#define TIMER_HPP
+#pragma once
+
+#include <chrono>
+
+namespace OGL
+{
+    class Timer
+    {
+    public:
+        Timer() : mStart(Clock::now()) {}
+
+/****************************************************************************/
+/*!
+\brief
+    Restart the timer
+*/
+/****************************************************************************/
+        void Reset()
+        {
+            mStart = Clock::now();
+        }
+
+/****************************************************************************/
+/*!
+\brief
+    Time since construction or the last reset
+
+\return
+    Elapsed milliseconds
+*/
+/****************************************************************************/
+        double Milliseconds() const
+        {
+            return std::chrono::duration<double, std::milli>(Clock::now() - mStart).count();
+        }
+
+    private:
+        using Clock = std::chrono::high_resolution_clock;
+        Clock::time_point mStart;
+    };
+}
+
+#endif // TIMER_HPP
@@ -0,0 +1,186 @@
+/****************************************************************************/
+/*!
+\file
+   UniformBuffer.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    std140 uniform blocks declared as C++ structs, and the ring buffer
+    they are uploaded through
+*/
+/****************************************************************************/
+#ifndef UNIFORMBUFFER_HPP
+#define UNIFORMBUFFER_HPP
+#pragma once
+
+#include "OPENGLPCH.hpp"
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+
+namespace OGL
+{
+    //! std140 rules of a C++ type standing in for a GLSL type, only these can be block members
+    template <typename T>
+    struct Std140Type;
+
+    template <> struct Std140Type<float> { static constexpr GLenum Type = GL_FLOAT; static constexpr std::size_t Align = 4; static constexpr std::size_t Size = 4; };
+    template <> struct Std140Type<GLint> { static constexpr GLenum Type = GL_INT; static constexpr std::size_t Align = 4; static constexpr std::size_t Size = 4; };
+    template <> struct Std140Type<GLuint> { static constexpr GLenum Type = GL_UNSIGNED_INT; static constexpr std::size_t Align = 4; static constexpr std::size_t Size = 4; };
+    template <> struct Std140Type<glm::vec2> { static constexpr GLenum Type = GL_FLOAT_VEC2; static constexpr std::size_t Align = 8; static constexpr std::size_t Size = 8; };
+    template <> struct Std140Type<glm::vec3> { static constexpr GLenum Type = GL_FLOAT_VEC3; static constexpr std::size_t Align = 16; static constexpr std::size_t Size = 12; };
+    template <> struct Std140Type<glm::vec4> { static constexpr GLenum Type = GL_FLOAT_VEC4; static constexpr std::size_t Align = 16; static constexpr std::size_t Size = 16; };
+    template <> struct Std140Type<glm::ivec4> { static constexpr GLenum Type = GL_INT_VEC4; static constexpr std::size_t Align = 16; static constexpr std::size_t Size = 16; };
+    template <> struct Std140Type<glm::mat3x4> { static constexpr GLenum Type = GL_FLOAT_MAT3; static constexpr std::size_t Align = 16; static constexpr std::size_t Size = 48; };  //!< a GLSL mat3, its columns are padded to vec4
+    template <> struct Std140Type<glm::mat4> { static constexpr GLenum Type = GL_FLOAT_MAT4; static constexpr std::size_t Align = 16; static constexpr std::size_t Size = 64; };
+
+/****************************************************************************/
+/*!
+\brief
+    Offsets std140 gives members of the listed types, in order
+
+\return
+    The byte offset of every member
+*/
+/****************************************************************************/
+    template <typename... Members>
+    constexpr std::array<std::size_t, sizeof...(Members)> Std140Offsets()
+    {
+        constexpr std::size_t aligns[] = { Std140Type<Members>::Align... };
+        constexpr std::size_t sizes[] = { Std140Type<Members>::Size... };
+
+        std::array<std::size_t, sizeof...(Members)> offsets{};
+        std::size_t offset = 0;
+        for (std::size_t i = 0; i < sizeof...(Members); ++i)
+        {
+            offset = (offset + aligns[i] - 1) / aligns[i] * aligns[i];
+            offsets[i] = offset;
+            offset += sizes[i];
+        }
+        return offsets;
+    }
+
+/****************************************************************************/
+/*!
+\brief
+    Size std140 gives a block with members of the listed types
+
+\return
+    End of the last member rounded up to a vec4
+*/
+/****************************************************************************/
+    template <typename... Members>
+    constexpr std::size_t Std140Size()
+    {
+        constexpr std::size_t sizes[] = { Std140Type<Members>::Size... };
+        constexpr std::size_t last = sizeof...(Members) - 1;
+        return (Std140Offsets<Members...>()[last] + sizes[last] + 15) / 16 * 16;
+    }
+
+    //! the std140 layout of a block's members, in declaration order. A block struct
+    //! names it Layout, static_asserts Matches on its own offsets, and gives its
+    //! GLSL block Name and binding point as static constants.
+    template <typename... Members>
+    struct Std140Layout
+    {
+        static_assert(sizeof...(Members) > 0, "a uniform block needs a member");
+
+        static constexpr std::size_t Count = sizeof...(Members);
+        static constexpr std::array<GLenum, Count> Types = { Std140Type<Members>::Type... };
+        static constexpr std::array<std::size_t, Count> Offsets = Std140Offsets<Members...>();
+
+        //! the smallest size the struct may have
+        static constexpr std::size_t Size = Std140Size<Members...>();
+
+/****************************************************************************/
+/*!
+\brief
+    Does a C++ struct lay its members out as std140 does
+
+\param offsets
+    offsetof every member, in declaration order
+
+\param size
+    sizeof the struct
+
+\return
+    True if every offset matches and the struct covers the block
+*/
+/****************************************************************************/
+        static constexpr bool Matches(std::initializer_list<std::size_t> offsets, std::size_t size)
+        {
+            if (offsets.size() != Count || size < Size)
+            {
+                return false;
+            }
+
+            std::size_t i = 0;
+            for (std::size_t offset : offsets)
+            {
+                if (offset != Offsets[i++])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    //! where one pushed block lives in the ring buffer
+    struct UniformSlice
+    {
+        std::size_t offset = 0;
+        std::size_t size = 0;
+    };
+
+    class UniformRing
+    {
+    public:
+        ~UniformRing();
+        UniformRing() = default;
+
+        UniformRing(const UniformRing&) = delete;
+        UniformRing& operator=(const UniformRing&) = delete;
+
+        void Create(std::size_t frameBytes = DefaultFrameBytes);
+
+        void BeginFrame();
+        UniformSlice Push(const void* data, std::size_t size);
+        void Flush();
+        void Bind(GLuint binding, const UniformSlice& slice);
+        void EndFrame();
+
+        std::size_t FrameBytes() const;
+        std::size_t UsedBytes() const;
+
+        //! copy a block struct in, it is on the GPU after the next Flush or Bind
+        template <typename Block>
+        UniformSlice Push(const Block& block)
+        {
+            static_assert(std::is_trivially_copyable<Block>::value, "uniform blocks are copied as raw bytes");
+            return Push(&block, sizeof(Block));
+        }
+
+        //! frames the GPU may still be reading when one is written, each has its own region
+        static constexpr unsigned FramesInFlight = 3;
+
+        //! space for one frame's blocks
+        static constexpr std::size_t DefaultFrameBytes = 1 << 20;
+
+    private:
+        GLuint mBuffer = 0;
+        std::size_t mFrameBytes = 0;
+        std::size_t mAlignment = 256;
+        unsigned mFrame = 0;
+        std::size_t mHead = 0;              //!< end of the last push, relative to the frame's region
+        std::size_t mFlushed = 0;           //!< everything before this is on the GPU
+        std::vector<unsigned char> mStaging;
+        std::array<GLsync, FramesInFlight> mFences = {};
+    };
+}
+
+#endif // UNIFORMBUFFER_HPP
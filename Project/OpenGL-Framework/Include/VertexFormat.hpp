@@ -0,0 +1,70 @@
+/****************************************************************************/
+/*!
+\file
+   VertexFormat.hpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Vertex type and the compact GPU encodings a mesh can be uploaded in
+*/
+/****************************************************************************/
+#ifndef VERTEXFORMAT_HPP
+#define VERTEXFORMAT_HPP
+#pragma once
+
+#include "OPENGLPCH.hpp"
+
+namespace OGL
+{
+
+    struct Vertex
+    {
+        glm::vec4 position = glm::vec4(0);
+        glm::vec4 normal = glm::vec4(0);
+    };
+
+    //! how positions are stored on the GPU
+    enum class PositionEncoding
+    {
+        Float,      //!< 4 floats, 16 bytes
+        Half,       //!< 4 half floats, 8 bytes
+        Quantized   //!< 4 snorm16 relative to the mesh bounds, 8 bytes
+    };
+
+    //! how normals are stored on the GPU
+    enum class NormalEncoding
+    {
+        Float,      //!< 4 floats, 16 bytes
+        Packed,     //!< 10-10-10-2 snorm, 4 bytes
+        Octahedral  //!< 2 snorm16 octahedral, 4 bytes
+    };
+
+    //! uniforms the vertex shader needs to decode positions
+    struct VertexDecode
+    {
+        glm::vec3 positionScale = glm::vec3(1);
+        glm::vec3 positionBias = glm::vec3(0);
+        bool octahedralNormals = false;
+    };
+
+    struct VertexFormat
+    {
+        PositionEncoding position = PositionEncoding::Float;
+        NormalEncoding normal = NormalEncoding::Float;
+
+        bool IsPacked() const;
+        GLsizei Stride() const;
+        GLsizei NormalOffset() const;
+
+        VertexDecode Pack(const std::vector<Vertex>& vertices, std::vector<unsigned char>& packed) const;
+        Vertex Unpack(const unsigned char* vertex, const VertexDecode& decode) const;
+        void SetAttributes() const;
+
+        std::string Name() const;
+    };
+}
+
+#endif // VERTEXFORMAT_HPP
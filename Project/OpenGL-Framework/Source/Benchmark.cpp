@@ -0,0 +1,1318 @@
+/****************************************************************************/
+/*!
+\file
+   Benchmark.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Startup benchmarks, compiled in when OGL_BENCHMARK is defined.
+    Results go to the console and the Benchmark_ log.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "Benchmark.hpp"
+#include "BvhBuilder.hpp"
+#include "GeometryArena.hpp"
+#include "GLState.hpp"
+#include "MappedIOSystem.hpp"
+#include "MeshBounds.hpp"
+#include "MemoryTracker.hpp"
+#include "MeshCache.hpp"
+#include "Mesh.hpp"
+#include "MeshletBuilder.hpp"
+#include "MeshLoader.hpp"
+#include "MeshRegistry.hpp"
+#include "NormalGenerator.hpp"
+#include "ObjLoader.hpp"
+#include "Parallel.hpp"
+#include "RayCaster.hpp"
+#include "Shader.hpp"
+#include "ShaderBatch.hpp"
+#include "ShaderCache.hpp"
+#include "Timer.hpp"
+#include "UniformBuffer.hpp"
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+#define BENCHMARK_MODEL "../Resource/Models/StanfordBunny.obj"
+#define BENCHMARK_VERTEX_SHADER "../Resource/Shaders/Benchmark.vert"
+#define BENCHMARK_FRAGMENT_SHADER "../Resource/Shaders/Benchmark.frag"
+
+namespace
+{
+    //! the Camera block of Benchmark.vert
+    struct BenchmarkCamera
+    {
+        glm::mat4 projection;
+        glm::mat4 view;
+
+        using Layout = OGL::Std140Layout<glm::mat4, glm::mat4>;
+        static constexpr const char* Name = "Camera";
+        static constexpr GLuint Binding = 0;
+    };
+    static_assert(BenchmarkCamera::Layout::Matches({ offsetof(BenchmarkCamera, projection), offsetof(BenchmarkCamera, view) },
+        sizeof(BenchmarkCamera)), "BenchmarkCamera does not match std140");
+
+    //! the Object block of Benchmark.vert
+    struct BenchmarkObject
+    {
+        glm::mat4 world;
+        glm::vec4 tint;
+
+        using Layout = OGL::Std140Layout<glm::mat4, glm::vec4>;
+        static constexpr const char* Name = "Object";
+        static constexpr GLuint Binding = 1;
+    };
+    static_assert(BenchmarkObject::Layout::Matches({ offsetof(BenchmarkObject, world), offsetof(BenchmarkObject, tint) },
+        sizeof(BenchmarkObject)), "BenchmarkObject does not match std140");
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Largest resident set the process has had, in bytes
+    */
+    /****************************************************************************/
+    static std::size_t PeakResidentBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters = {};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage = {};
+        getrusage(RUSAGE_SELF, &usage);
+        return std::size_t(usage.ru_maxrss) * 1024;
+#endif
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Start a new peak resident set measurement where the platform allows,
+      elsewhere the peak only ever grows so later runs may read low
+    */
+    /****************************************************************************/
+    static void ResetPeakResident()
+    {
+#ifndef _WIN32
+        std::ofstream clear("/proc/self/clear_refs");
+        clear << "5";
+#endif
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Run every benchmark, needs a current GL context
+*/
+/****************************************************************************/
+void OGL::Benchmark::Run()
+{
+    MeshCache(BENCHMARK_MODEL);
+    VertexFormats(BENCHMARK_MODEL);
+    ObjLoader(BENCHMARK_MODEL);
+    AsyncLoad(BENCHMARK_MODEL);
+    Lods(BENCHMARK_MODEL);
+    Meshlets(BENCHMARK_MODEL);
+    Residency(BENCHMARK_MODEL);
+    AssimpIO(BENCHMARK_MODEL);
+    Registry(BENCHMARK_MODEL);
+    Arena(BENCHMARK_MODEL);
+    BoundingVolumes(BENCHMARK_MODEL);
+    Normals(BENCHMARK_MODEL);
+    Bvh(BENCHMARK_MODEL);
+    RayCast(BENCHMARK_MODEL);
+    Progressive(BENCHMARK_MODEL);
+    Uniforms(BENCHMARK_VERTEX_SHADER, BENCHMARK_FRAGMENT_SHADER);
+    UniformBlocks(BENCHMARK_VERTEX_SHADER, BENCHMARK_FRAGMENT_SHADER);
+    ProgramBinaries(BENCHMARK_VERTEX_SHADER, BENCHMARK_FRAGMENT_SHADER);
+    ParallelCompile(BENCHMARK_VERTEX_SHADER, BENCHMARK_FRAGMENT_SHADER);
+    StateCache(BENCHMARK_VERTEX_SHADER, BENCHMARK_FRAGMENT_SHADER);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time a mesh load with a cold cache against one with a warm cache,
+  both including the GPU upload
+
+\param path
+  Path of the model to load
+*/
+/****************************************************************************/
+void OGL::Benchmark::MeshCache(const std::string& path)
+{
+    // cold, full Assimp import, this also writes the cache entry
+    Timer timer;
+    {
+        Mesh mesh;
+        mesh.Load(path, false);
+        mesh.Upload();
+        glFinish();
+    }
+    double cold = timer.Milliseconds();
+
+    // warm, straight from the cache entry written above
+    timer.Reset();
+    {
+        Mesh mesh;
+        mesh.Load(path);
+        mesh.Upload();
+        glFinish();
+    }
+    double warm = timer.Milliseconds();
+
+    DEBUG::log.Benchmark("MeshCache:", path);
+    DEBUG::log.Benchmark("  cold", cold, "ms");
+    DEBUG::log.Benchmark("  warm", warm, "ms");
+    DEBUG::log.Benchmark("  speedup", cold / warm, "x");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Report the size and decode error of every vertex encoding.
+  Position error is relative to the bounding box diagonal, normal error
+  is the angle between the original and decoded normal.
+
+\param path
+  Path of the model to encode
+*/
+/****************************************************************************/
+void OGL::Benchmark::VertexFormats(const std::string& path)
+{
+    Mesh mesh;
+    mesh.Load(path);
+    const std::vector<Vertex>& vertices = mesh.Vertices();
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    glm::vec3 min(vertices[0].position);
+    glm::vec3 max(vertices[0].position);
+    for (const Vertex& v : vertices)
+    {
+        min = glm::min(min, glm::vec3(v.position));
+        max = glm::max(max, glm::vec3(v.position));
+    }
+    float diagonal = glm::length(max - min);
+
+    DEBUG::log.Benchmark("VertexFormats:", path, vertices.size(), "vertices");
+
+    const PositionEncoding positions[] = { PositionEncoding::Float, PositionEncoding::Half, PositionEncoding::Quantized };
+    const NormalEncoding normals[] = { NormalEncoding::Float, NormalEncoding::Packed, NormalEncoding::Octahedral };
+    for (PositionEncoding position : positions)
+    {
+        for (NormalEncoding normal : normals)
+        {
+            VertexFormat format = { position, normal };
+
+            Timer timer;
+            std::vector<unsigned char> packed;
+            VertexDecode decode = format.Pack(vertices, packed);
+            double packTime = timer.Milliseconds();
+
+            double positionError = 0, positionErrorMax = 0;
+            double normalError = 0, normalErrorMax = 0;
+            for (std::size_t i = 0; i < vertices.size(); ++i)
+            {
+                Vertex decoded = format.Unpack(packed.data() + i * format.Stride(), decode);
+
+                double p = glm::length(glm::vec3(decoded.position - vertices[i].position)) / diagonal;
+                float cosine = glm::dot(glm::normalize(glm::vec3(vertices[i].normal)), glm::vec3(decoded.normal));
+                double n = glm::degrees(std::acos(glm::clamp(cosine, -1.0f, 1.0f)));
+
+                positionError += p;
+                normalError += n;
+                positionErrorMax = std::max(positionErrorMax, p);
+                normalErrorMax = std::max(normalErrorMax, n);
+            }
+
+            DEBUG::log.Benchmark(" ", format.Name());
+            DEBUG::log.Benchmark("    bytes/vertex", format.Stride(), "(", float(sizeof(Vertex)) / format.Stride(), "x smaller )");
+            DEBUG::log.Benchmark("    position error mean", positionError / vertices.size(), "max", positionErrorMax);
+            DEBUG::log.Benchmark("    normal error mean", normalError / vertices.size(), "deg max", normalErrorMax, "deg");
+            DEBUG::log.Benchmark("    pack", packTime, "ms");
+        }
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Compare the throughput of the ObjLoader against Assimp on the same file,
+  neither goes through the mesh cache or the optimizer
+
+\param path
+  Path of the OBJ file to parse
+*/
+/****************************************************************************/
+void OGL::Benchmark::ObjLoader(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    double megabytes = double(file.tellg()) / (1024.0 * 1024.0);
+
+    Timer timer;
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<SubMesh> subMeshes;
+    if (!ObjLoader::Load(path, vertices, indices, subMeshes))
+    {
+        DEBUG::log.Benchmark("ObjLoader: could not load", path);
+        return;
+    }
+    double fast = timer.Milliseconds();
+
+    timer.Reset();
+    std::size_t assimpVertices = 0;
+    std::size_t assimpTriangles = 0;
+    {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path, Mesh::ImportFlags);
+        for (unsigned i = 0; scene && i < scene->mNumMeshes; ++i)
+        {
+            assimpVertices += scene->mMeshes[i]->mNumVertices;
+            assimpTriangles += scene->mMeshes[i]->mNumFaces;
+        }
+    }
+    double assimp = timer.Milliseconds();
+
+    DEBUG::log.Benchmark("ObjLoader:", path, megabytes, "MB", ThreadCount(), "threads");
+    DEBUG::log.Benchmark("  ObjLoader", fast, "ms", megabytes / (fast / 1000.0), "MB/s",
+        vertices.size(), "vertices", indices.size() / 3, "triangles", subMeshes.size(), "submeshes");
+    DEBUG::log.Benchmark("  Assimp   ", assimp, "ms", megabytes / (assimp / 1000.0), "MB/s",
+        assimpVertices, "vertices", assimpTriangles, "triangles");
+    DEBUG::log.Benchmark("  speedup", assimp / fast, "x");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Compare how long the GL thread is blocked by a synchronous mesh load
+  against an asynchronous one, both from a warm cache
+
+\param path
+  Path of the model to load
+*/
+/****************************************************************************/
+void OGL::Benchmark::AsyncLoad(const std::string& path)
+{
+    // make sure both runs start from the same cache state
+    {
+        Mesh mesh;
+        mesh.Load(path);
+    }
+
+    Timer timer;
+    {
+        Mesh mesh;
+        mesh.Create(path);
+        glFinish();
+    }
+    double blocking = timer.Milliseconds();
+
+    // the GL thread only pays for queueing and the uploads
+    double stalled = 0;
+    double resident = 0;
+    unsigned frames = 0;
+    timer.Reset();
+    {
+        Mesh mesh;
+        MeshLoader loader;
+
+        Timer frame;
+        loader.LoadAsync(mesh, path);
+        stalled += frame.Milliseconds();
+
+        while (!mesh.IsResident() && loader.Pending())
+        {
+            frame.Reset();
+            loader.Update(2.0);
+            glFinish();
+            stalled += frame.Milliseconds();
+            ++frames;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        resident = timer.Milliseconds();
+    }
+
+    DEBUG::log.Benchmark("AsyncLoad:", path);
+    DEBUG::log.Benchmark("  synchronous, GL thread blocked", blocking, "ms");
+    DEBUG::log.Benchmark("  asynchronous, GL thread blocked", stalled, "ms over", frames, "frames, resident after", resident, "ms");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Report the LOD chain of every submesh, with the on screen size below
+  which each level is used at 1 pixel of error
+
+\param path
+  Path of the model
+*/
+/****************************************************************************/
+void OGL::Benchmark::Lods(const std::string& path)
+{
+    Timer timer;
+    Mesh mesh;
+    mesh.Load(path, false);
+    double load = timer.Milliseconds();
+
+    Bounds bounds = mesh.GetBounds();
+    float diagonal = glm::length(bounds.max - bounds.min);
+
+    DEBUG::log.Benchmark("Lods:", path, "import, optimize and LOD build", load, "ms");
+    const std::vector<MeshLod>& lods = mesh.Lods();
+    for (const SubMesh& subMesh : mesh.SubMeshes())
+    {
+        for (GLuint i = subMesh.firstLod; i < subMesh.firstLod + subMesh.lodCount; ++i)
+        {
+            const MeshLod& lod = lods[i];
+            if (lod.error > 0)
+            {
+                DEBUG::log.Benchmark("  LOD", i - subMesh.firstLod, lod.indexCount / 3, "triangles, error",
+                    lod.error / diagonal, "of the diagonal, used below", diagonal / lod.error, "px");
+            }
+            else
+            {
+                DEBUG::log.Benchmark("  LOD", i - subMesh.firstLod, lod.indexCount / 3, "triangles");
+            }
+        }
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time the meshlet build, report how full the meshlets are and how many
+  the backface cones cull from the six axis views
+
+\param path
+  Path of the model
+*/
+/****************************************************************************/
+void OGL::Benchmark::Meshlets(const std::string& path)
+{
+    Mesh mesh;
+    mesh.Load(path);
+    const MeshData& data = mesh.Data();
+
+    Timer timer;
+    std::vector<Meshlet> meshlets;
+    std::vector<GLuint> meshletVertices;
+    std::vector<std::uint8_t> meshletTriangles;
+    MeshletStats stats;
+    for (const SubMesh& subMesh : data.subMeshes)
+    {
+        MeshletStats subStats = MeshletBuilder::Build(data.vertices.data() + subMesh.baseVertex, subMesh.vertexCount,
+            data.indices.data() + subMesh.firstIndex, subMesh.indexCount, meshlets, meshletVertices, meshletTriangles);
+        stats.meshletCount += subStats.meshletCount;
+        stats.coneCount += subStats.coneCount;
+    }
+    double build = timer.Milliseconds();
+
+    std::size_t vertexTotal = 0;
+    std::size_t triangleTotal = 0;
+    for (const Meshlet& meshlet : meshlets)
+    {
+        vertexTotal += meshlet.vertexCount;
+        triangleTotal += meshlet.triangleCount;
+    }
+
+    // cameras on each axis, well outside the model
+    Bounds bounds = mesh.GetBounds();
+    glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+    float distance = glm::length(bounds.max - bounds.min) * 2;
+    const glm::vec3 axes[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    std::size_t culled = 0;
+    for (const glm::vec3& axis : axes)
+    {
+        for (const Meshlet& meshlet : meshlets)
+        {
+            culled += MeshletBuilder::IsBackfacing(meshlet, center + axis * distance);
+        }
+    }
+
+    DEBUG::log.Benchmark("Meshlets:", path, ThreadCount(), "threads");
+    DEBUG::log.Benchmark("  build", build, "ms", meshlets.size(), "meshlets");
+    DEBUG::log.Benchmark("  vertex fill", float(vertexTotal) / (meshlets.size() * MeshletBuilder::MaxVertices),
+        "triangle fill", float(triangleTotal) / (meshlets.size() * MeshletBuilder::MaxTriangles));
+    DEBUG::log.Benchmark("  meshlets with a cone", stats.coneCount, "backface culled per view", float(culled) / 6);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Report the tracked CPU and GPU footprint of a mesh under every
+  residency policy
+
+\param path
+  Path of the model
+*/
+/****************************************************************************/
+void OGL::Benchmark::Residency(const std::string& path)
+{
+    const OGL::Residency policies[] = { Residency::GpuOnly, Residency::CpuAndGpu, Residency::CpuOnly };
+    const char* names[] = { "GpuOnly", "CpuAndGpu", "CpuOnly" };
+
+    DEBUG::log.Benchmark("Residency:", path);
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        AssetMemory before = MemoryTracker::Total();
+        {
+            Mesh mesh;
+            mesh.SetResidency(policies[i]);
+            mesh.Load(path);
+            mesh.Upload();
+
+            AssetMemory after = MemoryTracker::Total();
+            DEBUG::log.Benchmark(" ", names[i], "cpu", (after.cpuBytes - before.cpuBytes) / 1024.0,
+                "KB gpu", (after.gpuBytes - before.gpuBytes) / 1024.0, "KB");
+        }
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time an Assimp import and measure its peak memory through the default
+  stdio IO system, a MappedIOSystem and a MappedIOSystem blob. The mapped
+  runs go first, on platforms where the peak can not be reset they would
+  otherwise hide under the default run's peak.
+
+\param path
+  Path of the model to import
+*/
+/****************************************************************************/
+void OGL::Benchmark::AssimpIO(const std::string& path)
+{
+    MappedFile file(path);
+    if (!file.IsOpen())
+    {
+        return;
+    }
+
+    // same extension so Assimp picks the same importer
+    const std::string blobPath = "blob/" + path.substr(path.find_last_of("/\\") + 1);
+    MappedIOSystem::RegisterBlob(blobPath, file.Data(), file.Size());
+
+    auto run = [&](const char* name, const std::string& source, bool mapped)
+    {
+        ResetPeakResident();
+        std::size_t before = PeakResidentBytes();
+        Timer timer;
+        {
+            Assimp::Importer importer;
+            if (mapped)
+            {
+                importer.SetIOHandler(new MappedIOSystem);
+            }
+            if (!importer.ReadFile(source, Mesh::ImportFlags))
+            {
+                DEBUG::log.Error("AssimpIO:", name, importer.GetErrorString());
+                return;
+            }
+        }
+        double ms = timer.Milliseconds();
+        std::size_t peak = PeakResidentBytes() - before;
+        DEBUG::log.Benchmark(" ", name, ms, "ms peak +", peak / (1024.0 * 1024.0), "MB");
+    };
+
+    DEBUG::log.Benchmark("AssimpIO:", path, file.Size() / (1024.0 * 1024.0), "MB");
+    run("mapped", path, true);
+    run("blob", blobPath, true);
+    run("default", path, false);
+
+    MappedIOSystem::UnregisterBlob(blobPath);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Load one model many times, half of them through a copy under another
+  name, and compare the GPU memory and load time to one upload per load
+
+\param path
+  Path of the model to load
+*/
+/****************************************************************************/
+void OGL::Benchmark::Registry(const std::string& path)
+{
+    const std::size_t instances = 1000;
+    const std::string copy = std::string(MeshCache::Directory) + "RegistryCopy" + std::filesystem::path(path).extension().string();
+    std::error_code error;
+    std::filesystem::create_directories(MeshCache::Directory, error);
+    if (!std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing, error))
+    {
+        return;
+    }
+
+    // one upload, what every instance costs without sharing
+    std::size_t single = 0;
+    double singleMs = 0;
+    {
+        Timer timer;
+        Mesh mesh;
+        mesh.Load(path);
+        mesh.Upload();
+        glFinish();
+        singleMs = timer.Milliseconds();
+        single = mesh.GpuBytes();
+    }
+
+    AssetMemory before = MemoryTracker::Total();
+    Timer timer;
+    {
+        MeshLoader loader;
+        MeshRegistry registry(loader);
+        std::vector<MeshHandle> handles;
+        for (std::size_t i = 0; i < instances; ++i)
+        {
+            handles.push_back(registry.Load(i % 2 ? copy : path));
+        }
+        loader.Finish();
+        glFinish();
+
+        AssetMemory after = MemoryTracker::Total();
+        DEBUG::log.Benchmark("Registry:", path, instances, "loads");
+        DEBUG::log.Benchmark("  meshes", registry.MeshCount(), "shared loads", registry.SharedLoads());
+        DEBUG::log.Benchmark("  shared", timer.Milliseconds(), "ms gpu", (after.gpuBytes - before.gpuBytes) / 1024.0, "KB");
+        DEBUG::log.Benchmark("  unshared estimate", singleMs * instances, "ms gpu", single * instances / 1024.0, "KB");
+    }
+
+    std::filesystem::remove(copy, error);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Draw many meshes sharing a geometry arena one call each against one
+  gathered call, then free every other mesh and time the defragmentation
+
+\param path
+  Path of the model to draw
+*/
+/****************************************************************************/
+void OGL::Benchmark::Arena(const std::string& path)
+{
+    const std::size_t meshCount = 64;
+    const unsigned frames = 100;
+
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    for (std::size_t i = 0; i < meshCount; ++i)
+    {
+        meshes.push_back(std::make_unique<Mesh>());
+        meshes.back()->Load(path);
+        meshes.back()->Upload();
+    }
+
+    GeometryArena* arena = meshes.front()->Arena();
+    if (!arena)
+    {
+        return;
+    }
+
+    Timer timer;
+    for (unsigned frame = 0; frame < frames; ++frame)
+    {
+        for (const auto& mesh : meshes)
+        {
+            mesh->Draw();
+        }
+    }
+    glFinish();
+    double separate = timer.Milliseconds() / frames;
+
+    DrawList draws;
+    timer.Reset();
+    for (unsigned frame = 0; frame < frames; ++frame)
+    {
+        draws.Clear();
+        for (const auto& mesh : meshes)
+        {
+            mesh->GatherDraws(0, draws);
+        }
+        arena->Draw(draws);
+    }
+    glFinish();
+    double gathered = timer.Milliseconds() / frames;
+
+    for (std::size_t i = 0; i < meshCount; i += 2)
+    {
+        meshes[i].reset();
+    }
+    std::size_t fragments = arena->FragmentCount();
+
+    timer.Reset();
+    arena->Defragment();
+    glFinish();
+    double defragment = timer.Milliseconds();
+
+    DEBUG::log.Benchmark("Arena:", path, meshCount, "meshes");
+    DEBUG::log.Benchmark("  one draw per mesh", separate, "ms per frame");
+    DEBUG::log.Benchmark("  one gathered draw", gathered, "ms per frame");
+    DEBUG::log.Benchmark("  defragment", fragments, "free ranges in", defragment, "ms");
+    GeometryArena::Log();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time the vectorized vertex conversion and bounds against the per
+  vertex push_back loop they replace, and compare the fitted sphere to
+  the box's circumscribed sphere
+
+\param path
+  Path of the model to use the vertices of
+*/
+/****************************************************************************/
+void OGL::Benchmark::BoundingVolumes(const std::string& path)
+{
+    Mesh mesh;
+    mesh.Load(path);
+    const std::vector<Vertex>& source = mesh.Vertices();
+    if (source.empty())
+    {
+        return;
+    }
+
+    // as Assimp hands them over
+    std::vector<float> positions;
+    std::vector<float> normals;
+    positions.reserve(source.size() * 3);
+    normals.reserve(source.size() * 3);
+    for (const Vertex& vertex : source)
+    {
+        positions.insert(positions.end(), { vertex.position.x, vertex.position.y, vertex.position.z });
+        normals.insert(normals.end(), { vertex.normal.x, vertex.normal.y, vertex.normal.z });
+    }
+
+    const unsigned runs = 10;
+    Timer timer;
+    Bounds scalarBounds;
+    for (unsigned run = 0; run < runs; ++run)
+    {
+        std::vector<Vertex> vertices;
+        for (std::size_t i = 0; i < source.size(); ++i)
+        {
+            Vertex vertex;
+            vertex.position = glm::vec4(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2], 1);
+            vertex.normal = glm::vec4(glm::normalize(glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2])), 0);
+
+            glm::vec3 position(vertex.position);
+            scalarBounds.min = i == 0 ? position : glm::min(scalarBounds.min, position);
+            scalarBounds.max = i == 0 ? position : glm::max(scalarBounds.max, position);
+            vertices.push_back(vertex);
+        }
+    }
+    double scalar = timer.Milliseconds() / runs;
+
+    timer.Reset();
+    Bounds aabb;
+    BoundingSphere sphere;
+    for (unsigned run = 0; run < runs; ++run)
+    {
+        std::vector<Vertex> vertices(source.size());
+        MeshBounds::Convert(positions.data(), normals.data(), source.size(), vertices.data());
+        MeshBounds::Compute(vertices.data(), vertices.size(), aabb, sphere);
+    }
+    double vectorized = timer.Milliseconds() / runs;
+
+    // the sphere must hold every vertex
+    float overshoot = 0;
+    for (const Vertex& vertex : source)
+    {
+        overshoot = std::max(overshoot, glm::length(glm::vec3(vertex.position) - sphere.center) - sphere.radius);
+    }
+
+    DEBUG::log.Benchmark("BoundingVolumes:", path, source.size(), "vertices");
+    DEBUG::log.Benchmark("  push_back loop, box", scalar, "ms");
+    DEBUG::log.Benchmark("  vectorized, box and sphere", vectorized, "ms");
+    DEBUG::log.Benchmark("  boxes match", scalarBounds.min == aabb.min && scalarBounds.max == aabb.max);
+    DEBUG::log.Benchmark("  sphere radius", sphere.radius, "box diagonal / 2", glm::length(aabb.max - aabb.min) * 0.5f,
+        "largest overshoot", overshoot);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time the multi-threaded normal generator against Assimp's
+  aiProcess_GenSmoothNormals on the same triangles, and measure how far
+  apart their normals are with nothing creased
+
+\param path
+  Path of the model, its own normals are dropped
+*/
+/****************************************************************************/
+void OGL::Benchmark::Normals(const std::string& path)
+{
+    const unsigned flags = Mesh::ImportFlags | aiProcess_DropNormals;
+
+    // Assimp's share is the difference between importing with and without it
+    Assimp::Importer plainImporter;
+    Timer timer;
+    if (!plainImporter.ReadFile(path, flags))
+    {
+        return;
+    }
+    double plain = timer.Milliseconds();
+
+    Assimp::Importer smoothImporter;
+    timer.Reset();
+    const aiScene* scene = smoothImporter.ReadFile(path, flags | aiProcess_GenSmoothNormals);
+    double assimp = timer.Milliseconds() - plain;
+    if (!scene)
+    {
+        return;
+    }
+
+    double generated = 0;
+    double angleSum = 0;
+    float angleMax = 0;
+    std::size_t cornerCount = 0;
+    std::size_t vertexCount = 0;
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<Vertex> outVertices;
+    std::vector<GLuint> outIndices;
+    for (unsigned i = 0; i < scene->mNumMeshes; ++i)
+    {
+        const aiMesh* mesh = scene->mMeshes[i];
+        if (!mesh->mNormals)
+        {
+            continue;
+        }
+
+        vertices.resize(mesh->mNumVertices);
+        MeshBounds::Convert(&mesh->mVertices[0].x, nullptr, mesh->mNumVertices, vertices.data());
+        indices.clear();
+        for (unsigned f = 0; f < mesh->mNumFaces; ++f)
+        {
+            if (mesh->mFaces[f].mNumIndices == 3)
+            {
+                indices.insert(indices.end(), mesh->mFaces[f].mIndices, mesh->mFaces[f].mIndices + 3);
+            }
+        }
+
+        timer.Reset();
+        NormalGenerator::Generate(vertices.data(), vertices.size(), indices.data(), indices.size(),
+            glm::pi<float>(), outVertices, outIndices);
+        generated += timer.Milliseconds();
+        vertexCount += outVertices.size();
+
+        // compared per corner, the two index the vertices differently
+        for (std::size_t c = 0; c < indices.size(); ++c)
+        {
+            const aiVector3D& theirs = mesh->mNormals[indices[c]];
+            glm::vec3 ours(outVertices[outIndices[c]].normal);
+            if (ours == glm::vec3(0) || theirs.Length() == 0)
+            {
+                continue;
+            }
+
+            float cosine = glm::dot(glm::normalize(ours), glm::normalize(glm::vec3(theirs.x, theirs.y, theirs.z)));
+            float angle = glm::degrees(std::acos(glm::clamp(cosine, -1.0f, 1.0f)));
+            angleSum += angle;
+            angleMax = std::max(angleMax, angle);
+            ++cornerCount;
+        }
+    }
+
+    DEBUG::log.Benchmark("Normals:", path, cornerCount / 3, "triangles", vertexCount, "vertices");
+    DEBUG::log.Benchmark("  aiProcess_GenSmoothNormals", assimp, "ms");
+    DEBUG::log.Benchmark("  NormalGenerator", generated, "ms on", ThreadCount(), "threads");
+    DEBUG::log.Benchmark("  angle to Assimp's, mean", cornerCount ? angleSum / cornerCount : 0, "max", angleMax, "degrees");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time the BVH build over every submesh and compare the expected cost of
+  a ray query to the linear triangle scan it replaces
+
+\param path
+  Path of the model to build over
+*/
+/****************************************************************************/
+void OGL::Benchmark::Bvh(const std::string& path)
+{
+    Mesh mesh;
+    mesh.Load(path);
+    const MeshData& data = mesh.Data();
+
+    const unsigned runs = 5;
+    std::vector<BvhNode> nodes;
+    std::vector<GLuint> triangles;
+    std::size_t triangleCount = 0;
+    double cost = 0;
+    Timer timer;
+    for (unsigned run = 0; run < runs; ++run)
+    {
+        nodes.clear();
+        triangles.clear();
+        triangleCount = 0;
+        cost = 0;
+        for (const SubMesh& subMesh : data.subMeshes)
+        {
+            BvhStats stats = BvhBuilder::Build(data.vertices.data() + subMesh.baseVertex, subMesh.vertexCount,
+                data.indices.data() + subMesh.firstIndex, subMesh.indexCount, nodes, triangles);
+            triangleCount += subMesh.indexCount / 3;
+            cost += stats.cost;
+        }
+    }
+    double build = timer.Milliseconds() / runs;
+
+    DEBUG::log.Benchmark("Bvh:", path, triangleCount, "triangles on", ThreadCount(), "threads");
+    DEBUG::log.Benchmark("  build", build, "ms,", triangleCount / std::max(build, 0.001) / 1000, "M triangles / s");
+    DEBUG::log.Benchmark("  ", nodes.size(), "nodes,", nodes.size() * sizeof(BvhNode) + triangles.size() * sizeof(GLuint), "bytes");
+    DEBUG::log.Benchmark("  SAH cost of a ray", cost, "against", triangleCount, "for a linear scan");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Cast a screen of rays at a model one at a time and in packets through
+  its BVH, and a sample of them through the linear triangle scan
+
+\param path
+  Path of the model to cast at
+*/
+/****************************************************************************/
+void OGL::Benchmark::RayCast(const std::string& path)
+{
+    Mesh mesh;
+    mesh.SetResidency(Residency::CpuOnly);
+    mesh.Load(path, true, true);
+
+    // a 512 x 512 view of the whole model
+    const int size = 512;
+    BoundingSphere sphere = mesh.GetSphere();
+    glm::mat4 projection = glm::perspective(0.6f, 1.0f, 0.01f, sphere.radius * 10);
+    glm::mat4 view = glm::lookAt(sphere.center + glm::vec3(0, 0, sphere.radius * 3), sphere.center, glm::vec3(0, 1, 0));
+    std::vector<Ray> rays;
+    rays.reserve(size * size);
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            rays.push_back(RayCaster::ScreenRay(projection, view, glm::vec2(x + 0.5f, y + 0.5f), glm::vec2(size)));
+        }
+    }
+
+    std::vector<RayHit> single(rays.size());
+    Timer timer;
+    for (std::size_t i = 0; i < rays.size(); ++i)
+    {
+        RayCaster::Intersect(mesh, rays[i], single[i]);
+    }
+    double singleMs = timer.Milliseconds();
+
+    std::vector<RayHit> packets(rays.size());
+    timer.Reset();
+    RayCaster::Intersect(mesh, rays.data(), rays.size(), packets.data());
+    double packetMs = timer.Milliseconds();
+
+    const std::size_t sampleStep = 1021;
+    std::size_t sampled = 0;
+    timer.Reset();
+    for (std::size_t i = 0; i < rays.size(); i += sampleStep, ++sampled)
+    {
+        RayHit hit;
+        RayCaster::IntersectLinear(mesh, rays[i], hit);
+    }
+    double linearMs = timer.Milliseconds() / sampled * rays.size();
+
+    std::size_t hits = 0;
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < rays.size(); ++i)
+    {
+        hits += single[i].mesh != nullptr;
+        mismatches += single[i].mesh != packets[i].mesh || single[i].t != packets[i].t;
+    }
+
+    DEBUG::log.Benchmark("RayCast:", path, rays.size(), "rays,", hits, "hits");
+    DEBUG::log.Benchmark("  single rays", singleMs, "ms,", rays.size() / singleMs / 1000, "M rays / s");
+    DEBUG::log.Benchmark("  packets of", RayCaster::PacketSize, "on", ThreadCount(), "threads", packetMs, "ms,",
+        rays.size() / packetMs / 1000, "M rays / s");
+    DEBUG::log.Benchmark("  linear scan, estimated from", sampled, "rays", linearMs, "ms");
+    DEBUG::log.Benchmark("  packet results differing from single rays", mismatches);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Compare how long a full upload takes until the mesh can be drawn
+  against a progressive one, which is drawable after its coarsest LODs
+
+\param path
+  Path of the model to upload
+*/
+/****************************************************************************/
+void OGL::Benchmark::Progressive(const std::string& path)
+{
+    Mesh mesh;
+    mesh.Load(path, true, false, true);
+    const VertexFormat format = { PositionEncoding::Quantized, NormalEncoding::Octahedral };
+
+    Timer timer;
+    mesh.Upload(format);
+    glFinish();
+    double full = timer.Milliseconds();
+
+    timer.Reset();
+    mesh.Upload(format, true);
+    glFinish();
+    double coarse = timer.Milliseconds();
+
+    unsigned steps = 0;
+    double slowest = 0;
+    while (mesh.IsRefining())
+    {
+        Timer step;
+        mesh.Refine();
+        glFinish();
+        slowest = std::max(slowest, step.Milliseconds());
+        ++steps;
+    }
+    double refined = timer.Milliseconds();
+
+    std::size_t coarseVertices = 0;
+    for (const SubMesh& subMesh : mesh.SubMeshes())
+    {
+        coarseVertices += mesh.Lods()[subMesh.firstLod + subMesh.lodCount - 1].vertexCount;
+    }
+
+    DEBUG::log.Benchmark("Progressive:", path, mesh.Vertices().size(), "vertices,", coarseVertices, "in the coarsest LODs");
+    DEBUG::log.Benchmark("  full upload, drawable after", full, "ms");
+    DEBUG::log.Benchmark("  progressive, drawable after", coarse, "ms, refined after", refined, "ms in", steps,
+        "more steps, the slowest", slowest, "ms");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time setting a matrix uniform through a driver lookup of its name, the
+  way SetUniform used to, against a compile time hashed name and a
+  handle looked up once
+
+\param vertexShader
+  Path of the vertex shader
+
+\param fragmentShader
+  Path of the fragment shader
+*/
+/****************************************************************************/
+void OGL::Benchmark::Uniforms(const std::string& vertexShader, const std::string& fragmentShader)
+{
+    Shader shader;
+    shader.Create(vertexShader, fragmentShader);
+    shader.Use();
+
+    const unsigned count = 100000;
+    const glm::mat4 value(1);
+    constexpr UniformName world = "world";
+
+    GLint program = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+
+    Timer timer;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        std::string name = "world";
+        glUniformMatrix4fv(glGetUniformLocation(GLuint(program), name.c_str()), 1, GL_FALSE, &value[0][0]);
+    }
+    glFinish();
+    double lookup = timer.Milliseconds();
+
+    timer.Reset();
+    for (unsigned i = 0; i < count; ++i)
+    {
+        shader.SetUniform(world, value);
+    }
+    glFinish();
+    double hashed = timer.Milliseconds();
+
+    const UniformHandle handle = shader.Uniform(world);
+    timer.Reset();
+    for (unsigned i = 0; i < count; ++i)
+    {
+        shader.SetUniform(handle, value);
+    }
+    glFinish();
+    double handled = timer.Milliseconds();
+
+    DEBUG::log.Benchmark("Uniforms:", shader.Uniforms().size(), "reflected,", count, "mat4 sets");
+    DEBUG::log.Benchmark("  glGetUniformLocation per set", lookup, "ms");
+    DEBUG::log.Benchmark("  hashed name", hashed, "ms");
+    DEBUG::log.Benchmark("  handle", handled, "ms");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time drawing many objects with the camera and per object state set
+  through plain uniforms on every draw, against the camera pushed once
+  and each object's block pushed to the uniform ring
+
+\param vertexShader
+  Path of a vertex shader with both, as Benchmark.vert
+
+\param fragmentShader
+  Path of the fragment shader
+*/
+/****************************************************************************/
+void OGL::Benchmark::UniformBlocks(const std::string& vertexShader, const std::string& fragmentShader)
+{
+    Shader shader;
+    shader.Create(vertexShader, fragmentShader);
+    bool bound = shader.BindBlock<BenchmarkCamera>() && shader.BindBlock<BenchmarkObject>();
+    shader.Use();
+
+    // one point per object, the state is what is measured
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    GLState::BindVertexArray(vao);
+
+    const unsigned count = 10000;
+    const glm::mat4 projection = glm::perspective(0.6f, 1.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 5), glm::vec3(0), glm::vec3(0, 1, 0));
+    const UniformHandle projectionHandle = shader.Uniform("projection");
+    const UniformHandle viewHandle = shader.Uniform("view");
+    const UniformHandle worldHandle = shader.Uniform("world");
+    const UniformHandle tintHandle = shader.Uniform("tint");
+
+    Timer timer;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        shader.SetUniform(projectionHandle, projection);
+        shader.SetUniform(viewHandle, view);
+        shader.SetUniform(worldHandle, glm::translate(glm::mat4(1), glm::vec3(float(i), 0, 0)));
+        shader.SetUniform(tintHandle, glm::vec4(1));
+        glDrawArrays(GL_POINTS, 0, 1);
+    }
+    glFinish();
+    double uniforms = timer.Milliseconds();
+
+    UniformRing ring;
+    ring.Create((count + 1) * 256);
+    std::vector<UniformSlice> slices(count);
+    timer.Reset();
+    {
+        ring.BeginFrame();
+        ring.Bind(BenchmarkCamera::Binding, ring.Push(BenchmarkCamera{ projection, view }));
+        for (unsigned i = 0; i < count; ++i)
+        {
+            slices[i] = ring.Push(BenchmarkObject{ glm::translate(glm::mat4(1), glm::vec3(float(i), 0, 0)), glm::vec4(1) });
+        }
+        for (unsigned i = 0; i < count; ++i)
+        {
+            ring.Bind(BenchmarkObject::Binding, slices[i]);
+            glDrawArrays(GL_POINTS, 0, 1);
+        }
+        ring.EndFrame();
+    }
+    glFinish();
+    double blocks = timer.Milliseconds();
+
+    GLState::DeleteVertexArray(vao);
+
+    DEBUG::log.Benchmark("UniformBlocks:", count, "draws, blocks bound", bound);
+    DEBUG::log.Benchmark("  4 uniforms per draw", uniforms, "ms");
+    DEBUG::log.Benchmark("  camera once, object block per draw", blocks, "ms,", ring.UsedBytes() / 1024.0, "KB pushed");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time creating a program from source against restoring it from the
+  shader cache
+
+\param vertexShader
+  Path of the vertex shader
+
+\param fragmentShader
+  Path of the fragment shader
+*/
+/****************************************************************************/
+void OGL::Benchmark::ProgramBinaries(const std::string& vertexShader, const std::string& fragmentShader)
+{
+    // cold, compiled and linked, this also writes the cache entry
+    Timer timer;
+    {
+        Shader shader;
+        shader.Create(vertexShader, fragmentShader, false);
+        glFinish();
+    }
+    double cold = timer.Milliseconds();
+
+    // warm, from the binary written above
+    timer.Reset();
+    {
+        Shader shader;
+        shader.Create(vertexShader, fragmentShader);
+        glFinish();
+    }
+    double warm = timer.Milliseconds();
+
+    DEBUG::log.Benchmark("ProgramBinaries:", vertexShader, "binaries supported", ShaderCache::IsSupported());
+    DEBUG::log.Benchmark("  from source", cold, "ms");
+    DEBUG::log.Benchmark("  from cache", warm, "ms");
+    DEBUG::log.Benchmark("  speedup", cold / warm, "x");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time building programs one after the other against submitting them
+  as one batch, all from source. Drivers that cache compiled shaders
+  themselves may make the later programs of both runs cheaper.
+
+\param vertexShader
+  Path of the vertex shader
+
+\param fragmentShader
+  Path of the fragment shader
+*/
+/****************************************************************************/
+void OGL::Benchmark::ParallelCompile(const std::string& vertexShader, const std::string& fragmentShader)
+{
+    constexpr int programs = 16;
+
+    // one after the other, each waits on its link status
+    Timer timer;
+    {
+        std::vector<Shader> shaders(programs);
+        for (Shader& shader : shaders)
+        {
+            shader.Create(vertexShader, fragmentShader, false);
+        }
+        glFinish();
+    }
+    double serial = timer.Milliseconds();
+
+    // all submitted, then picked up as they finish
+    std::vector<Shader> shaders(programs);
+    ShaderBatch batch;
+    for (Shader& shader : shaders)
+    {
+        batch.Add(shader, vertexShader, fragmentShader, false);
+    }
+    timer.Reset();
+    batch.Submit();
+    batch.Complete();
+    glFinish();
+    double batched = timer.Milliseconds();
+
+    double slowest = 0;
+    for (const Shader& shader : shaders)
+    {
+        slowest = std::max(slowest, shader.BuildMilliseconds());
+    }
+
+    DEBUG::log.Benchmark("ParallelCompile:", programs, "programs, parallel compile", ShaderBatch::IsParallel(),
+        "with", ShaderBatch::CompilerThreads(), "threads");
+    DEBUG::log.Benchmark("  one after the other", serial, "ms");
+    DEBUG::log.Benchmark("  batched", batched, "ms, slowest program", slowest, "ms");
+    DEBUG::log.Benchmark("  speedup", serial / batched, "x");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Time the state calls of many draws that all share their state, as
+  every draw sets it, made straight to GL against through GLState
+
+\param vertexShader
+  Path of the vertex shader
+
+\param fragmentShader
+  Path of the fragment shader
+*/
+/****************************************************************************/
+void OGL::Benchmark::StateCache(const std::string& vertexShader, const std::string& fragmentShader)
+{
+    Shader shader;
+    shader.Create(vertexShader, fragmentShader);
+    GLint program = 0;
+    shader.Use();
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+
+    // one point per draw, the state is what is measured
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+
+    const unsigned count = 10000;
+
+    // every draw sets its state, as Shader::Use and GeometryArena::Bind did
+    Timer timer;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        glUseProgram(GLuint(program));
+        glBindVertexArray(vao);
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        glDrawArrays(GL_POINTS, 0, 1);
+    }
+    glFinish();
+    double direct = timer.Milliseconds();
+
+    // the calls above went around the cache
+    GLState::Invalidate();
+    GLStateCounters before = GLState::Frame();
+    timer.Reset();
+    for (unsigned i = 0; i < count; ++i)
+    {
+        GLState::UseProgram(GLuint(program));
+        GLState::BindVertexArray(vao);
+        GLState::Enable(GL_DEPTH_TEST);
+        GLState::Enable(GL_CULL_FACE);
+        glDrawArrays(GL_POINTS, 0, 1);
+    }
+    glFinish();
+    double cached = timer.Milliseconds();
+    GLStateCounters after = GLState::Frame();
+
+    GLState::DeleteVertexArray(vao);
+
+    DEBUG::log.Benchmark("StateCache:", count, "draws, 4 state calls each");
+    DEBUG::log.Benchmark("  straight to GL", direct, "ms");
+    DEBUG::log.Benchmark("  through GLState", cached, "ms,", after.issued - before.issued, "issued,",
+        after.elided - before.elided, "elided");
+    DEBUG::log.Benchmark("  speedup", direct / cached, "x");
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,568 @@
+/****************************************************************************/
+/*!
+\file
+   BvhBuilder.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Binned SAH builder (Wald 2007). Every node sorts the centroids of its
+    triangles into BinCount bins per axis and splits at the bin boundary
+    with the lowest surface area heuristic cost.
+
+    The top of the tree, where nodes hold more than SubtreeTriangles
+    triangles, is split breadth first with the binning spread over the
+    worker threads. The subtrees below it are then built whole, one per
+    thread, and stitched into a single depth first array. The cut depends
+    only on the triangle count, so the output does not depend on the
+    number of threads.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "BvhBuilder.hpp"
+#include "Parallel.hpp"
+#include <array>
+#include <limits>
+#include <numeric>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! smallest range worth a thread when binning
+    constexpr std::size_t MinPerThread = 1 << 14;
+
+    constexpr float Infinity = std::numeric_limits<float>::max();
+
+    //! box that starts out empty, unlike Bounds
+    struct Box
+    {
+        glm::vec3 min = glm::vec3(Infinity);
+        glm::vec3 max = glm::vec3(-Infinity);
+    };
+
+    //! the triangles whose centroids fall into one bin
+    struct Bin
+    {
+        Box bounds;
+        std::size_t count = 0;
+    };
+
+    //! BinCount bins for each of the 3 axes
+    using Bins = std::array<Bin, 3 * OGL::BvhBuilder::BinCount>;
+
+    //! per triangle inputs of the build
+    struct Triangles
+    {
+        std::vector<Box> bounds;
+        std::vector<glm::vec3> centroids;
+    };
+
+    //! a node split into two, its triangles partitioned around middle
+    struct Split
+    {
+        std::size_t middle = 0;
+        Box leftBounds;
+        Box leftCentroids;
+        Box rightBounds;
+        Box rightCentroids;
+    };
+
+    //! a node of the top of the tree, which is built breadth first
+    struct TopNode
+    {
+        Box bounds;
+        Box centroids;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        std::size_t left = 0;       //!< 0 for a subtree root, the root is never a child
+        std::size_t right = 0;
+    };
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Grow a box to hold a point
+    */
+    /****************************************************************************/
+    static void Grow(Box& box, const glm::vec3& point)
+    {
+        box.min = glm::min(box.min, point);
+        box.max = glm::max(box.max, point);
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Grow a box to hold another
+    */
+    /****************************************************************************/
+    static void Grow(Box& box, const Box& other)
+    {
+        box.min = glm::min(box.min, other.min);
+        box.max = glm::max(box.max, other.max);
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Half the surface area of a box, only ratios of it are used
+    */
+    /****************************************************************************/
+    static float HalfArea(const Box& box)
+    {
+        glm::vec3 size = glm::max(box.max - box.min, glm::vec3(0));
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      The bin a centroid falls into along one axis
+    */
+    /****************************************************************************/
+    static unsigned BinIndex(const glm::vec3& centroid, int axis, const Box& centroids, const glm::vec3& scale)
+    {
+        float bin = (centroid[axis] - centroids.min[axis]) * scale[axis];
+        return std::min(BvhBuilder::BinCount - 1, unsigned(std::max(bin, 0.0f)));
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Bins per unit of centroid extent, 0 along axes without any extent
+    */
+    /****************************************************************************/
+    static glm::vec3 BinScale(const Box& centroids)
+    {
+        glm::vec3 extent = centroids.max - centroids.min;
+        glm::vec3 scale(0);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            scale[axis] = extent[axis] > 0 ? BvhBuilder::BinCount / extent[axis] : 0;
+        }
+        return scale;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Sort a range of triangles into the bins of all 3 axes
+    */
+    /****************************************************************************/
+    static void BinTriangles(const Triangles& input, const GLuint* triangles, std::size_t count, const Box& centroids, Bins& bins)
+    {
+        glm::vec3 scale = BinScale(centroids);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const glm::vec3& centroid = input.centroids[triangles[i]];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                Bin& bin = bins[axis * BvhBuilder::BinCount + BinIndex(centroid, axis, centroids, scale)];
+                Grow(bin.bounds, input.bounds[triangles[i]]);
+                ++bin.count;
+            }
+        }
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Box and centroid box of a range of triangles
+    */
+    /****************************************************************************/
+    static void ComputeBoxes(const Triangles& input, const GLuint* triangles, std::size_t count, Box& bounds, Box& centroids)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Grow(bounds, input.bounds[triangles[i]]);
+            Grow(centroids, input.centroids[triangles[i]]);
+        }
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Pick the cheapest SAH split of a node and partition its triangles
+
+    \param triangles
+      The node's triangles, reordered so the left child's come first
+
+    \param parallel
+      Bin on the worker threads, for the large nodes at the top
+
+    \return
+      False if the node should be a leaf
+    */
+    /****************************************************************************/
+    static bool SplitNode(const Triangles& input, GLuint* triangles, std::size_t count, const Box& bounds,
+        const Box& centroids, bool parallel, Split& split)
+    {
+        if (count <= 1)
+        {
+            return false;
+        }
+
+        Bins bins;
+        if (parallel)
+        {
+            // merged in range order, min, max and counts come out the same for any thread count
+            std::vector<Bins> partial(ParallelRanges(count, MinPerThread));
+            ParallelFor(count, MinPerThread, [&](std::size_t begin, std::size_t end, unsigned range)
+            {
+                BinTriangles(input, triangles + begin, end - begin, centroids, partial[range]);
+            });
+
+            for (const Bins& part : partial)
+            {
+                for (std::size_t b = 0; b < bins.size(); ++b)
+                {
+                    Grow(bins[b].bounds, part[b].bounds);
+                    bins[b].count += part[b].count;
+                }
+            }
+        }
+        else
+        {
+            BinTriangles(input, triangles, count, centroids, bins);
+        }
+
+        // sweep every axis, a split after bin b puts bins 0..b on the left
+        const float area = HalfArea(bounds);
+        const glm::vec3 scale = BinScale(centroids);
+        float bestCost = Infinity;
+        int bestAxis = -1;
+        unsigned bestBin = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (scale[axis] == 0)
+            {
+                continue;
+            }
+
+            const Bin* axisBins = bins.data() + axis * BvhBuilder::BinCount;
+            float rightArea[BvhBuilder::BinCount] = {};
+            std::size_t rightCount[BvhBuilder::BinCount] = {};
+            Box right;
+            std::size_t rightSum = 0;
+            for (unsigned b = BvhBuilder::BinCount - 1; b > 0; --b)
+            {
+                Grow(right, axisBins[b].bounds);
+                rightSum += axisBins[b].count;
+                rightArea[b] = HalfArea(right);
+                rightCount[b] = rightSum;
+            }
+
+            Box left;
+            std::size_t leftSum = 0;
+            for (unsigned b = 0; b + 1 < BvhBuilder::BinCount; ++b)
+            {
+                Grow(left, axisBins[b].bounds);
+                leftSum += axisBins[b].count;
+                if (leftSum == 0 || rightCount[b + 1] == 0)
+                {
+                    continue;
+                }
+
+                float cost = HalfArea(left) * leftSum + rightArea[b + 1] * rightCount[b + 1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        // a leaf costs one intersection per triangle
+        float splitCost = area > 0 ? BvhBuilder::TraversalCost + bestCost / area : Infinity;
+        if (count <= BvhBuilder::MaxLeafTriangles && (bestAxis < 0 || splitCost >= float(count)))
+        {
+            return false;
+        }
+
+        split = Split();
+        if (bestAxis < 0)
+        {
+            // every centroid in one spot, any halving is as good as another
+            split.middle = count / 2;
+            ComputeBoxes(input, triangles, split.middle, split.leftBounds, split.leftCentroids);
+            ComputeBoxes(input, triangles + split.middle, count - split.middle, split.rightBounds, split.rightCentroids);
+            return true;
+        }
+
+        // the children's boxes are gathered while partitioning
+        GLuint* first = triangles;
+        GLuint* last = triangles + count;
+        while (first != last)
+        {
+            const Box& box = input.bounds[*first];
+            const glm::vec3& centroid = input.centroids[*first];
+            if (BinIndex(centroid, bestAxis, centroids, scale) <= bestBin)
+            {
+                Grow(split.leftBounds, box);
+                Grow(split.leftCentroids, centroid);
+                ++first;
+            }
+            else
+            {
+                Grow(split.rightBounds, box);
+                Grow(split.rightCentroids, centroid);
+                std::swap(*first, *--last);
+            }
+        }
+        split.middle = std::size_t(first - triangles);
+        return true;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Build a whole subtree depth first, on the calling thread
+
+    \param triangles
+      The triangle order of the whole build, leaves index into it
+    */
+    /****************************************************************************/
+    static void BuildSubtree(const Triangles& input, GLuint* triangles, std::size_t begin, std::size_t end,
+        const Box& bounds, const Box& centroids, std::vector<BvhNode>& nodes)
+    {
+        std::size_t index = nodes.size();
+        nodes.emplace_back();
+        nodes[index].min = bounds.min;
+        nodes[index].max = bounds.max;
+
+        Split split;
+        if (!SplitNode(input, triangles + begin, end - begin, bounds, centroids, false, split))
+        {
+            nodes[index].first = GLuint(begin);
+            nodes[index].count = GLuint(end - begin);
+            return;
+        }
+
+        BuildSubtree(input, triangles, begin, begin + split.middle, split.leftBounds, split.leftCentroids, nodes);
+        nodes[index].first = GLuint(nodes.size());
+        BuildSubtree(input, triangles, begin + split.middle, end, split.rightBounds, split.rightCentroids, nodes);
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Write the top of the tree depth first, splicing in the subtrees
+    */
+    /****************************************************************************/
+    static void EmitTop(const std::vector<TopNode>& top, std::size_t index, const std::vector<std::vector<BvhNode>>& subtrees,
+        GLuint triangleBase, std::vector<BvhNode>& nodes)
+    {
+        const TopNode& node = top[index];
+        if (node.left == 0)
+        {
+            // subtree links are relative to the subtree
+            GLuint offset = GLuint(nodes.size());
+            for (BvhNode subNode : subtrees[index])
+            {
+                subNode.first += subNode.count != 0 ? triangleBase : offset;
+                nodes.push_back(subNode);
+            }
+            return;
+        }
+
+        std::size_t emitted = nodes.size();
+        nodes.emplace_back();
+        nodes[emitted].min = node.bounds.min;
+        nodes[emitted].max = node.bounds.max;
+
+        EmitTop(top, node.left, subtrees, triangleBase, nodes);
+        nodes[emitted].first = GLuint(nodes.size());
+        EmitTop(top, node.right, subtrees, triangleBase, nodes);
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Measure a built hierarchy
+
+    \param root
+      Index of the root in nodes
+    */
+    /****************************************************************************/
+    static BvhStats Measure(const std::vector<BvhNode>& nodes, std::size_t root, std::size_t triangleCount)
+    {
+        BvhStats stats;
+        stats.nodeCount = nodes.size() - root;
+
+        Box rootBox = { nodes[root].min, nodes[root].max };
+        float rootArea = HalfArea(rootBox);
+        std::vector<std::pair<std::size_t, std::size_t>> stack = { { root, 1 } };
+        while (!stack.empty())
+        {
+            std::size_t index = stack.back().first;
+            std::size_t depth = stack.back().second;
+            stack.pop_back();
+
+            const BvhNode& node = nodes[index];
+            float probability = rootArea > 0 ? HalfArea({ node.min, node.max }) / rootArea : 1;
+            stats.depth = std::max(stats.depth, depth);
+            if (node.count != 0)
+            {
+                ++stats.leafCount;
+                stats.cost += probability * node.count;
+            }
+            else
+            {
+                stats.cost += probability * BvhBuilder::TraversalCost;
+                stack.push_back({ index + 1, depth + 1 });
+                stack.push_back({ node.first, depth + 1 });
+            }
+        }
+
+        // a flat box is hit as often as its neighbours, its area says nothing
+        if (rootArea == 0)
+        {
+            stats.cost = float(triangleCount);
+        }
+        return stats;
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Build a BVH over a triangle list
+
+\param vertices
+  The vertices the indices refer to
+
+\param vertexCount
+  One past the largest index
+
+\param indices
+  Triangle list
+
+\param indexCount
+  Number of indices
+
+\param nodes
+  The new nodes are appended depth first, the root first, links are
+  indices into nodes
+
+\param triangles
+  The triangles of every leaf are appended, as triangle numbers into
+  indices
+
+\return
+  Shape of the new hierarchy, no nodes are added for an empty list
+*/
+/****************************************************************************/
+OGL::BvhStats OGL::BvhBuilder::Build(const Vertex* vertices, std::size_t vertexCount, const GLuint* indices, std::size_t indexCount,
+    std::vector<BvhNode>& nodes, std::vector<GLuint>& triangles)
+{
+    const std::size_t triangleCount = indexCount / 3;
+    if (vertexCount == 0 || triangleCount == 0)
+    {
+        return BvhStats();
+    }
+
+    /* per triangle boxes and centroids */
+    Triangles input;
+    input.bounds.resize(triangleCount);
+    input.centroids.resize(triangleCount);
+    ParallelFor(triangleCount, MinPerThread, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        for (std::size_t t = begin; t < end; ++t)
+        {
+            Box box;
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                Grow(box, glm::vec3(vertices[indices[t * 3 + k]].position));
+            }
+            input.bounds[t] = box;
+            input.centroids[t] = (box.min + box.max) * 0.5f;
+        }
+    });
+
+    std::vector<GLuint> order(triangleCount);
+    std::iota(order.begin(), order.end(), 0);
+
+    /* split the top breadth first until every node fits a subtree */
+    std::vector<TopNode> top(1);
+    top[0].end = triangleCount;
+    ComputeBoxes(input, order.data(), triangleCount, top[0].bounds, top[0].centroids);
+    for (std::size_t i = 0; i < top.size(); ++i)
+    {
+        TopNode node = top[i];
+        Split split;
+        if (node.end - node.begin <= SubtreeTriangles ||
+            !SplitNode(input, order.data() + node.begin, node.end - node.begin, node.bounds, node.centroids, true, split))
+        {
+            continue;
+        }
+
+        TopNode left;
+        left.bounds = split.leftBounds;
+        left.centroids = split.leftCentroids;
+        left.begin = node.begin;
+        left.end = node.begin + split.middle;
+
+        TopNode right;
+        right.bounds = split.rightBounds;
+        right.centroids = split.rightCentroids;
+        right.begin = left.end;
+        right.end = node.end;
+
+        top[i].left = top.size();
+        top[i].right = top.size() + 1;
+        top.push_back(left);
+        top.push_back(right);
+    }
+
+    /* build the subtrees, one per thread, their links are relative to the subtree */
+    std::vector<std::size_t> roots;
+    for (std::size_t i = 0; i < top.size(); ++i)
+    {
+        if (top[i].left == 0)
+        {
+            roots.push_back(i);
+        }
+    }
+
+    std::vector<std::vector<BvhNode>> subtrees(top.size());
+    ParallelFor(roots.size(), 1, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        for (std::size_t r = begin; r < end; ++r)
+        {
+            const TopNode& node = top[roots[r]];
+            BuildSubtree(input, order.data(), node.begin, node.end, node.bounds, node.centroids, subtrees[roots[r]]);
+        }
+    });
+
+    /* stitch together */
+    std::size_t root = nodes.size();
+    EmitTop(top, 0, subtrees, GLuint(triangles.size()), nodes);
+    triangles.insert(triangles.end(), order.begin(), order.end());
+
+    return Measure(nodes, root, triangleCount);
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -17,6 +17,7 @@
 
 #include "OPENGLPCH.hpp"
 #include "Engine.hpp"
+#include "Benchmark.hpp"
 
 /*============================================================================*\
 || --------------------------- GLOBAL VARIABLES ----------------------------- ||
@@ -53,6 +54,10 @@ OGL::Engine::Engine() :
 void OGL::Engine::Init()
 {
     mWindow = mRenderer.Window(); 
+
+#ifdef OGL_BENCHMARK
+    OGL::Benchmark::Run();
+#endif
 }
 
 /****************************************************************************/
@@ -0,0 +1,266 @@
+/****************************************************************************/
+/*!
+\file
+   FileWatcher.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    On Linux the watcher thread blocks on inotify. It watches the
+    directories of the files rather than the files themselves, editors
+    that save by writing a temporary and renaming it over the original
+    would otherwise drop the watch with the old inode. Elsewhere the
+    thread compares the files' write times every PollMilliseconds.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "FileWatcher.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Absolute form of a path, so two spellings of one file compare equal
+    */
+    /****************************************************************************/
+    static std::filesystem::path Normalize(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(path, error);
+        return (error ? path : absolute).lexically_normal();
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Last write time of a file, the minimum if it can not be read
+    */
+    /****************************************************************************/
+    static std::filesystem::file_time_type WriteTime(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+        return error ? std::filesystem::file_time_type::min() : time;
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Stop and join the watcher thread
+*/
+/****************************************************************************/
+OGL::FileWatcher::~FileWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_all();
+    mThread.join();
+
+#ifdef __linux__
+    if (mNotify >= 0)
+    {
+        close(mNotify);
+    }
+#endif
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Start the watcher thread, it idles until a file is watched
+*/
+/****************************************************************************/
+OGL::FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+    mNotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mNotify < 0)
+    {
+        DEBUG::log.Error("FileWatcher: inotify is not available, changes will not be reported");
+    }
+#endif
+    mThread = std::thread(&FileWatcher::Run, this);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Report changes to a file from now on, watching a file twice is fine
+
+\param path
+  The file, it does not need to exist yet
+*/
+/****************************************************************************/
+void OGL::FileWatcher::Watch(const std::string& path)
+{
+    std::filesystem::path normalized = Normalize(path);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const File& file : mFiles)
+    {
+        if (file.normalized == normalized)
+        {
+            return;
+        }
+    }
+    mFiles.push_back({ path, normalized, WriteTime(normalized) });
+
+#ifdef __linux__
+    // watching a directory twice returns the same watch
+    if (mNotify >= 0)
+    {
+        int watch = inotify_add_watch(mNotify, normalized.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (watch < 0)
+        {
+            DEBUG::log.Error("FileWatcher: can not watch", normalized.parent_path().string());
+        }
+        else
+        {
+            mDirectories[watch] = normalized.parent_path();
+        }
+    }
+#endif
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Take the files that changed since the last call
+
+\return
+  Each changed file once, as it was passed to Watch
+*/
+/****************************************************************************/
+std::vector<std::string> OGL::FileWatcher::Changes()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<std::string> changes;
+    changes.swap(mChanged);
+    return changes;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Watcher thread, waits for changes until the watcher is destroyed
+*/
+/****************************************************************************/
+void OGL::FileWatcher::Run()
+{
+    for (;;)
+    {
+#ifdef __linux__
+        if (mNotify >= 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (mStop)
+                {
+                    return;
+                }
+            }
+
+            pollfd descriptor = { mNotify, POLLIN, 0 };
+            if (poll(&descriptor, 1, int(PollMilliseconds)) <= 0)
+            {
+                continue;
+            }
+
+            // events are packed back to back, each followed by its name
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(mNotify, buffer, sizeof(buffer))) > 0)
+            {
+                for (ssize_t offset = 0; offset < length;)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    offset += sizeof(inotify_event) + event->len;
+                    if (event->len == 0)
+                    {
+                        continue;
+                    }
+
+                    // the name is relative to the directory of the watch
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    auto directory = mDirectories.find(event->wd);
+                    if (directory != mDirectories.end())
+                    {
+                        Changed((directory->second / event->name).lexically_normal());
+                    }
+                }
+            }
+            continue;
+        }
+#endif
+
+        // no change notification, compare write times
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWake.wait_for(lock, std::chrono::milliseconds(PollMilliseconds), [this]() { return mStop; });
+        if (mStop)
+        {
+            return;
+        }
+
+        for (File& file : mFiles)
+        {
+            std::filesystem::file_time_type time = WriteTime(file.normalized);
+            if (time != file.time)
+            {
+                file.time = time;
+                Changed(file.normalized);
+            }
+        }
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Queue a changed file for Changes, with the mutex held
+
+\param normalized
+  The file's normalized path
+*/
+/****************************************************************************/
+void OGL::FileWatcher::Changed(const std::filesystem::path& normalized)
+{
+    for (const File& file : mFiles)
+    {
+        if (file.normalized == normalized && std::find(mChanged.begin(), mChanged.end(), file.path) == mChanged.end())
+        {
+            mChanged.push_back(file.path);
+        }
+    }
+}
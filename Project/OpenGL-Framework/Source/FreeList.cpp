@@ -0,0 +1,224 @@
+/****************************************************************************/
+/*!
+\file
+   FreeList.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    First fit range allocator. Free ranges are kept sorted by offset and
+    merged with their neighbours when freed, so the list only fragments
+    where live ranges really sit between free ones.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "FreeList.hpp"
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Constructor, everything starts free
+
+\param capacity
+  Size of the managed range
+*/
+/****************************************************************************/
+OGL::FreeList::FreeList(std::size_t capacity)
+{
+    Reset(0, capacity);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Take the first free range that fits
+
+\param size
+  Size wanted, 0 always succeeds at offset 0
+
+\param offset
+  Start of the allocation
+
+\return
+  False if no single free range is large enough
+*/
+/****************************************************************************/
+bool OGL::FreeList::Allocate(std::size_t size, std::size_t& offset)
+{
+    if (size == 0)
+    {
+        offset = 0;
+        return true;
+    }
+
+    for (auto it = mFree.begin(); it != mFree.end(); ++it)
+    {
+        if (it->second < size)
+        {
+            continue;
+        }
+
+        offset = it->first;
+        std::size_t rest = it->second - size;
+        mFree.erase(it);
+        if (rest > 0)
+        {
+            mFree.emplace(offset + size, rest);
+        }
+
+        mFreeSize -= size;
+        return true;
+    }
+
+    return false;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Give a range back, merging it with free neighbours
+
+\param offset
+  Start returned by Allocate
+
+\param size
+  Size passed to Allocate
+*/
+/****************************************************************************/
+void OGL::FreeList::Free(std::size_t offset, std::size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    mFreeSize += size;
+    auto next = mFree.lower_bound(offset);
+
+    // merge with the range after
+    if (next != mFree.end() && offset + size == next->first)
+    {
+        size += next->second;
+        next = mFree.erase(next);
+    }
+
+    // and the one before
+    if (next != mFree.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += size;
+            return;
+        }
+    }
+
+    mFree.emplace_hint(next, offset, size);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Start over with one used range at the front, after the owner compacted
+  or grew its buffer
+
+\param used
+  Size of the used range starting at 0
+
+\param capacity
+  New size of the managed range
+*/
+/****************************************************************************/
+void OGL::FreeList::Reset(std::size_t used, std::size_t capacity)
+{
+    mFree.clear();
+    mCapacity = capacity;
+    mFreeSize = capacity - used;
+    if (mFreeSize > 0)
+    {
+        mFree.emplace(used, mFreeSize);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Size of the managed range
+
+\return
+  The capacity
+*/
+/****************************************************************************/
+std::size_t OGL::FreeList::Capacity() const
+{
+    return mCapacity;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Total of every free range
+
+\return
+  The free size
+*/
+/****************************************************************************/
+std::size_t OGL::FreeList::FreeSize() const
+{
+    return mFreeSize;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Largest allocation that would succeed
+
+\return
+  Size of the largest free range
+*/
+/****************************************************************************/
+std::size_t OGL::FreeList::LargestFree() const
+{
+    std::size_t largest = 0;
+    for (const auto& range : mFree)
+    {
+        largest = std::max(largest, range.second);
+    }
+    return largest;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Number of separate free ranges
+
+\return
+  The count, 1 or 0 when nothing is fragmented
+*/
+/****************************************************************************/
+std::size_t OGL::FreeList::FragmentCount() const
+{
+    return mFree.size();
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
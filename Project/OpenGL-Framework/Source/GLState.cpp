@@ -0,0 +1,623 @@
+/****************************************************************************/
+/*!
+\file
+   GLState.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Every state call compares against the last value set through here
+    and only reaches GL when it differs. State starts unknown, so the
+    first call of each kind is always issued, and anything that changes
+    GL state behind the cache's back has to be followed by Invalidate.
+    The element array buffer belongs to the bound vertex array, it is
+    forgotten whenever the vertex array changes. One GL context on one
+    thread, like the rest of the renderer.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "GLState.hpp"
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! a name or enum GL could not have, the state is not known
+    constexpr GLuint Unknown = ~GLuint(0);
+
+    //! a buffer bound to a target, or to one index of it
+    struct BufferBinding
+    {
+        GLenum target;
+        GLuint index;               //!< Unknown for the target's generic binding
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    //! a texture bound to a unit
+    struct TextureBinding
+    {
+        GLuint unit;
+        GLenum target;
+        GLuint texture;
+    };
+
+    //! an Enable/Disable capability
+    struct Capability
+    {
+        GLenum capability;
+        GLuint enabled;             //!< GL_TRUE, GL_FALSE or Unknown
+    };
+
+    GLuint gProgram = Unknown;
+    GLuint gVertexArray = Unknown;
+    GLuint gActiveUnit = Unknown;
+    GLenum gBlendSource = Unknown;
+    GLenum gBlendDestination = Unknown;
+    GLenum gBlendEquation = Unknown;
+    GLenum gDepthFunc = Unknown;
+    GLuint gDepthMask = Unknown;
+    GLenum gCullFace = Unknown;
+    GLenum gFrontFace = Unknown;
+
+    //! only what has been set, anything else is unknown
+    std::vector<BufferBinding> gBuffers;
+    std::vector<TextureBinding> gTextures;
+    std::vector<Capability> gCapabilities;
+
+    OGL::GLStateCounters gFrame;
+    OGL::GLStateCounters gLastFrame;
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Record a new value and count the call
+
+    \param cached
+      The shadowed state
+
+    \param value
+      The value being set
+
+    \return
+      True if GL has to be called
+    */
+    /****************************************************************************/
+    template <typename T>
+    static bool Change(T& cached, T value)
+    {
+        if (cached == value)
+        {
+            ++gFrame.elided;
+            return false;
+        }
+
+        cached = value;
+        ++gFrame.issued;
+        return true;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Find the shadow of a buffer binding point, adding it as unknown
+    */
+    /****************************************************************************/
+    static BufferBinding& FindBuffer(GLenum target, GLuint index)
+    {
+        for (BufferBinding& binding : gBuffers)
+        {
+            if (binding.target == target && binding.index == index)
+            {
+                return binding;
+            }
+        }
+
+        gBuffers.push_back({ target, index, Unknown, 0, 0 });
+        return gBuffers.back();
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Find the shadow of a texture unit's target, adding it as unknown
+    */
+    /****************************************************************************/
+    static TextureBinding& FindTexture(GLuint unit, GLenum target)
+    {
+        for (TextureBinding& binding : gTextures)
+        {
+            if (binding.unit == unit && binding.target == target)
+            {
+                return binding;
+            }
+        }
+
+        gTextures.push_back({ unit, target, Unknown });
+        return gTextures.back();
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Find the shadow of a capability, adding it as unknown
+    */
+    /****************************************************************************/
+    static Capability& FindCapability(GLenum capability)
+    {
+        for (Capability& state : gCapabilities)
+        {
+            if (state.capability == capability)
+            {
+                return state;
+            }
+        }
+
+        gCapabilities.push_back({ capability, Unknown });
+        return gCapabilities.back();
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Forget the element array buffer, it is part of the vertex array
+    */
+    /****************************************************************************/
+    static void ForgetElementBuffer()
+    {
+        gBuffers.erase(std::remove_if(gBuffers.begin(), gBuffers.end(),
+            [](const BufferBinding& binding) { return binding.target == GL_ELEMENT_ARRAY_BUFFER; }), gBuffers.end());
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  glUseProgram, unless the program is already in use
+
+\param program
+  The program, 0 for none
+*/
+/****************************************************************************/
+void OGL::GLState::UseProgram(GLuint program)
+{
+    if (Change(gProgram, program))
+    {
+        glUseProgram(program);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glBindVertexArray, unless the vertex array is already bound
+
+\param vertexArray
+  The vertex array, 0 for none
+*/
+/****************************************************************************/
+void OGL::GLState::BindVertexArray(GLuint vertexArray)
+{
+    if (Change(gVertexArray, vertexArray))
+    {
+        glBindVertexArray(vertexArray);
+        ForgetElementBuffer();
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glBindBuffer, unless the buffer is already bound to the target
+
+\param target
+  The binding target, GL_ELEMENT_ARRAY_BUFFER binds to the current
+  vertex array
+
+\param buffer
+  The buffer, 0 for none
+*/
+/****************************************************************************/
+void OGL::GLState::BindBuffer(GLenum target, GLuint buffer)
+{
+    if (Change(FindBuffer(target, Unknown).buffer, buffer))
+    {
+        glBindBuffer(target, buffer);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glBindBufferRange, unless the same range is already bound to the
+  index. Like GL this also binds the buffer to the generic target.
+
+\param target
+  An indexed target, like GL_UNIFORM_BUFFER
+
+\param index
+  The binding point
+
+\param buffer
+  The buffer
+
+\param offset
+  Start of the range in bytes
+
+\param size
+  Size of the range in bytes
+*/
+/****************************************************************************/
+void OGL::GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    BufferBinding& binding = FindBuffer(target, index);
+    if (binding.buffer == buffer && binding.offset == offset && binding.size == size)
+    {
+        ++gFrame.elided;
+        return;
+    }
+
+    binding.buffer = buffer;
+    binding.offset = offset;
+    binding.size = size;
+    FindBuffer(target, Unknown).buffer = buffer;
+    ++gFrame.issued;
+    glBindBufferRange(target, index, buffer, offset, size);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Bind a texture to a unit, switching the active unit only if the
+  texture is not bound there already
+
+\param unit
+  The texture unit, counted from 0
+
+\param target
+  The texture target, like GL_TEXTURE_2D
+
+\param texture
+  The texture, 0 for none
+*/
+/****************************************************************************/
+void OGL::GLState::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    TextureBinding& binding = FindTexture(unit, target);
+    if (binding.texture == texture)
+    {
+        ++gFrame.elided;
+        return;
+    }
+
+    if (Change(gActiveUnit, unit))
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    binding.texture = texture;
+    ++gFrame.issued;
+    glBindTexture(target, texture);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glEnable, unless the capability is already enabled
+
+\param capability
+  The capability, like GL_DEPTH_TEST
+*/
+/****************************************************************************/
+void OGL::GLState::Enable(GLenum capability)
+{
+    if (Change(FindCapability(capability).enabled, GLuint(GL_TRUE)))
+    {
+        glEnable(capability);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glDisable, unless the capability is already disabled
+
+\param capability
+  The capability, like GL_BLEND
+*/
+/****************************************************************************/
+void OGL::GLState::Disable(GLenum capability)
+{
+    if (Change(FindCapability(capability).enabled, GLuint(GL_FALSE)))
+    {
+        glDisable(capability);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glBlendFunc, unless both factors are already set
+
+\param source
+  Factor of the incoming color
+
+\param destination
+  Factor of the framebuffer color
+*/
+/****************************************************************************/
+void OGL::GLState::BlendFunc(GLenum source, GLenum destination)
+{
+    if (gBlendSource == source && gBlendDestination == destination)
+    {
+        ++gFrame.elided;
+        return;
+    }
+
+    gBlendSource = source;
+    gBlendDestination = destination;
+    ++gFrame.issued;
+    glBlendFunc(source, destination);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glBlendEquation, unless the equation is already set
+
+\param mode
+  The blend equation, like GL_FUNC_ADD
+*/
+/****************************************************************************/
+void OGL::GLState::BlendEquation(GLenum mode)
+{
+    if (Change(gBlendEquation, mode))
+    {
+        glBlendEquation(mode);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glDepthFunc, unless the comparison is already set
+
+\param func
+  The depth comparison, like GL_LESS
+*/
+/****************************************************************************/
+void OGL::GLState::DepthFunc(GLenum func)
+{
+    if (Change(gDepthFunc, func))
+    {
+        glDepthFunc(func);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glDepthMask, unless depth writes are already set so
+
+\param write
+  GL_TRUE to write depth
+*/
+/****************************************************************************/
+void OGL::GLState::DepthMask(GLboolean write)
+{
+    if (Change(gDepthMask, GLuint(write)))
+    {
+        glDepthMask(write);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glCullFace, unless the face is already culled
+
+\param mode
+  GL_BACK, GL_FRONT or GL_FRONT_AND_BACK
+*/
+/****************************************************************************/
+void OGL::GLState::CullFace(GLenum mode)
+{
+    if (Change(gCullFace, mode))
+    {
+        glCullFace(mode);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glFrontFace, unless the winding is already set
+
+\param mode
+  GL_CCW or GL_CW
+*/
+/****************************************************************************/
+void OGL::GLState::FrontFace(GLenum mode)
+{
+    if (Change(gFrontFace, mode))
+    {
+        glFrontFace(mode);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glDeleteProgram. A program in use is only deleted once it is no
+  longer used, the next UseProgram is always issued.
+
+\param program
+  The program, 0 is ignored
+*/
+/****************************************************************************/
+void OGL::GLState::DeleteProgram(GLuint program)
+{
+    if (!program)
+    {
+        return;
+    }
+
+    glDeleteProgram(program);
+    if (gProgram == program)
+    {
+        gProgram = Unknown;
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glDeleteVertexArrays, GL binds 0 if the vertex array was bound
+
+\param vertexArray
+  The vertex array, 0 is ignored
+*/
+/****************************************************************************/
+void OGL::GLState::DeleteVertexArray(GLuint vertexArray)
+{
+    if (!vertexArray)
+    {
+        return;
+    }
+
+    glDeleteVertexArrays(1, &vertexArray);
+    if (gVertexArray == vertexArray)
+    {
+        gVertexArray = 0;
+        ForgetElementBuffer();
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glDeleteBuffers, GL unbinds the buffer from every binding point
+
+\param buffer
+  The buffer, 0 is ignored
+*/
+/****************************************************************************/
+void OGL::GLState::DeleteBuffer(GLuint buffer)
+{
+    if (!buffer)
+    {
+        return;
+    }
+
+    glDeleteBuffers(1, &buffer);
+    gBuffers.erase(std::remove_if(gBuffers.begin(), gBuffers.end(),
+        [buffer](const BufferBinding& binding) { return binding.buffer == buffer; }), gBuffers.end());
+}
+
+/****************************************************************************/
+/*!
+\brief
+  glDeleteTextures, GL unbinds the texture from every unit
+
+\param texture
+  The texture, 0 is ignored
+*/
+/****************************************************************************/
+void OGL::GLState::DeleteTexture(GLuint texture)
+{
+    if (!texture)
+    {
+        return;
+    }
+
+    glDeleteTextures(1, &texture);
+    gTextures.erase(std::remove_if(gTextures.begin(), gTextures.end(),
+        [texture](const TextureBinding& binding) { return binding.texture == texture; }), gTextures.end());
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Forget everything, call after GL state was changed without GLState.
+  The next call of every kind is issued.
+*/
+/****************************************************************************/
+void OGL::GLState::Invalidate()
+{
+    gProgram = Unknown;
+    gVertexArray = Unknown;
+    gActiveUnit = Unknown;
+    gBlendSource = Unknown;
+    gBlendDestination = Unknown;
+    gBlendEquation = Unknown;
+    gDepthFunc = Unknown;
+    gDepthMask = Unknown;
+    gCullFace = Unknown;
+    gFrontFace = Unknown;
+    gBuffers.clear();
+    gTextures.clear();
+    gCapabilities.clear();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Close the frame's counters, call once per frame
+*/
+/****************************************************************************/
+void OGL::GLState::EndFrame()
+{
+    gLastFrame = gFrame;
+    gFrame = GLStateCounters();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the counters of the frame so far
+
+\return
+  Calls issued and elided since the last EndFrame
+*/
+/****************************************************************************/
+OGL::GLStateCounters OGL::GLState::Frame()
+{
+    return gFrame;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the counters of the last whole frame
+
+\return
+  Calls issued and elided between the last two EndFrame calls
+*/
+/****************************************************************************/
+OGL::GLStateCounters OGL::GLState::LastFrame()
+{
+    return gLastFrame;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,581 @@
+/****************************************************************************/
+/*!
+\file
+   GeometryArena.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Every mesh of one vertex format and index type lives in the same pair
+    of GL buffers behind one VAO, so any number of them can be drawn with
+    a single bind and glMultiDrawElementsBaseVertex call.
+
+    Ranges are handed out by a first fit free list. When no free range is
+    large enough but the total free space is, live ranges are compacted
+    into fresh buffers with glCopyBufferSubData, otherwise the buffers
+    double. Indices are relative to the allocation's base vertex, so
+    moving vertex ranges never touches the index data.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "GeometryArena.hpp"
+#include "GLState.hpp"
+#include "MemoryTracker.hpp"
+#include "Mesh.hpp"
+#include <tuple>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! format position, format normal, index type
+    using ArenaKey = std::tuple<int, int, GLenum>;
+    using ArenaMap = std::map<ArenaKey, std::unique_ptr<OGL::GeometryArena>>;
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Every arena, created on first use and alive until DestroyAll. A
+      function static so even a missed DestroyAll is destroyed before the
+      memory tracker it reports to.
+    */
+    /****************************************************************************/
+    static ArenaMap& Arenas()
+    {
+        static ArenaMap arenas;
+        return arenas;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Smallest power of two multiple of start that holds needed
+    */
+    /****************************************************************************/
+    static std::size_t GrowCapacity(std::size_t start, std::size_t needed)
+    {
+        std::size_t capacity = start;
+        while (capacity < needed)
+        {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Destructor, deletes the buffers, every mesh must have freed its range
+*/
+/****************************************************************************/
+OGL::GeometryArena::~GeometryArena()
+{
+    GLState::DeleteVertexArray(mVAO);
+    GLState::DeleteBuffer(mVBO);
+    GLState::DeleteBuffer(mIBO);
+    MemoryTracker::Untrack(this);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Constructor, the buffers are created by the first allocation
+
+\param format
+  Encoding of every vertex in the arena
+
+\param indexType
+  GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+*/
+/****************************************************************************/
+OGL::GeometryArena::GeometryArena(VertexFormat format, GLenum indexType)
+    : mFormat(format), mIndexType(indexType), mStride(format.Stride()),
+      mIndexSize(indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint))
+{
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Copy a mesh into the arena
+
+\param vertices
+  Vertices already encoded in the arena's format
+
+\param vertexCount
+  Number of vertices
+
+\param indices
+  Indices of the arena's index type, relative to the first vertex
+
+\param indexCount
+  Number of indices
+
+\return
+  Handle of the new range, look its offsets up when drawing
+*/
+/****************************************************************************/
+OGL::GeometryArena::Handle OGL::GeometryArena::Allocate(const void* vertices, std::size_t vertexCount, const void* indices, std::size_t indexCount)
+{
+    Handle handle = Allocate(vertexCount, indexCount);
+    Write(handle, 0, vertices, vertexCount, 0, indices, indexCount);
+    return handle;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Take a range without filling it, Write streams the contents in later.
+  Until then the range holds garbage, and so does the unwritten part of
+  a range the arena moves.
+
+\param vertexCount
+  Number of vertices
+
+\param indexCount
+  Number of indices
+
+\return
+  Handle of the new range, look its offsets up when drawing
+*/
+/****************************************************************************/
+OGL::GeometryArena::Handle OGL::GeometryArena::Allocate(std::size_t vertexCount, std::size_t indexCount)
+{
+    Block block;
+    if (!Reserve(vertexCount, indexCount, block.firstVertex, block.firstIndex))
+    {
+        // compact if the space is there but fragmented, grow if it is not
+        std::size_t vertexCapacity = mVertexSpace.Capacity();
+        std::size_t indexCapacity = mIndexSpace.Capacity();
+        if (!mVAO || mVertexSpace.FreeSize() < vertexCount || mIndexSpace.FreeSize() < indexCount)
+        {
+            vertexCapacity = GrowCapacity(std::max(vertexCapacity, MinVertices), vertexCapacity - mVertexSpace.FreeSize() + vertexCount);
+            indexCapacity = GrowCapacity(std::max(indexCapacity, MinIndices), indexCapacity - mIndexSpace.FreeSize() + indexCount);
+        }
+
+        Rebuild(vertexCapacity, indexCapacity);
+        Reserve(vertexCount, indexCount, block.firstVertex, block.firstIndex);
+    }
+
+    block.vertexCount = vertexCount;
+    block.indexCount = indexCount;
+    block.live = true;
+
+    Handle handle;
+    if (mFreeHandles.empty())
+    {
+        handle = Handle(mBlocks.size());
+        mBlocks.push_back(block);
+    }
+    else
+    {
+        handle = mFreeHandles.back();
+        mFreeHandles.pop_back();
+        mBlocks[handle] = block;
+    }
+
+    Track();
+    return handle;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Fill part of a range in place, the range is never reallocated so
+  draws of the parts already written stay valid
+
+\param handle
+  Handle returned by Allocate
+
+\param firstVertex
+  Where the vertices go, relative to the range's first vertex
+
+\param vertices
+  Vertices already encoded in the arena's format
+
+\param vertexCount
+  Number of vertices, may be 0
+
+\param firstIndex
+  Where the indices go, relative to the range's first index
+
+\param indices
+  Indices of the arena's index type, relative to the range's first vertex
+
+\param indexCount
+  Number of indices, may be 0
+*/
+/****************************************************************************/
+void OGL::GeometryArena::Write(Handle handle, std::size_t firstVertex, const void* vertices, std::size_t vertexCount,
+    std::size_t firstIndex, const void* indices, std::size_t indexCount)
+{
+    const Block& block = mBlocks[handle];
+    if (vertexCount > 0)
+    {
+        GLState::BindBuffer(GL_COPY_WRITE_BUFFER, mVBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (block.firstVertex + firstVertex) * mStride, vertexCount * mStride, vertices);
+    }
+    if (indexCount > 0)
+    {
+        GLState::BindBuffer(GL_COPY_WRITE_BUFFER, mIBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (block.firstIndex + firstIndex) * mIndexSize, indexCount * mIndexSize, indices);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Give a range back, the GL buffers are not shrunk
+
+\param handle
+  Handle returned by Allocate
+*/
+/****************************************************************************/
+void OGL::GeometryArena::Free(Handle handle)
+{
+    Block& block = mBlocks[handle];
+    mVertexSpace.Free(block.firstVertex, block.vertexCount);
+    mIndexSpace.Free(block.firstIndex, block.indexCount);
+    block = Block();
+    mFreeHandles.push_back(handle);
+    Track();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Move every live range to the front of the buffers, leaving one free
+  range at the end of each. Handles stay valid, offsets change.
+*/
+/****************************************************************************/
+void OGL::GeometryArena::Defragment()
+{
+    if (mVertexSpace.FragmentCount() > 1 || mIndexSpace.FragmentCount() > 1)
+    {
+        Rebuild(mVertexSpace.Capacity(), mIndexSpace.Capacity());
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Where an allocation's vertices start
+
+\param handle
+  Handle returned by Allocate
+
+\return
+  Base vertex to draw the allocation's indices with
+*/
+/****************************************************************************/
+GLint OGL::GeometryArena::BaseVertex(Handle handle) const
+{
+    return GLint(mBlocks[handle].firstVertex);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Where an allocation's indices start
+
+\param handle
+  Handle returned by Allocate
+
+\return
+  Byte offset into the index buffer
+*/
+/****************************************************************************/
+std::size_t OGL::GeometryArena::IndexOffset(Handle handle) const
+{
+    return mBlocks[handle].firstIndex * mIndexSize;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Bind the shared VAO, its vertex and index buffers come with it
+*/
+/****************************************************************************/
+void OGL::GeometryArena::Bind() const
+{
+    GLState::BindVertexArray(mVAO);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Draw any number of ranges from the arena in one call
+
+\param draws
+  Absolute draws, offsets and base vertices already include the
+  allocations' offsets, see Mesh::GatherDraws
+*/
+/****************************************************************************/
+void OGL::GeometryArena::Draw(const DrawList& draws) const
+{
+    if (draws.Size() == 0)
+    {
+        return;
+    }
+
+    // GLEW declares the arrays non-const, GL only reads them
+    Bind();
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, const_cast<GLsizei*>(draws.counts.data()), mIndexType,
+        const_cast<void**>(draws.offsets.data()), draws.Size(), const_cast<GLint*>(draws.baseVertices.data()));
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the index type of every allocation
+
+\return
+  GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+*/
+/****************************************************************************/
+GLenum OGL::GeometryArena::IndexType() const
+{
+    return mIndexType;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Bytes held by live allocations
+
+\return
+  Vertex and index bytes in use
+*/
+/****************************************************************************/
+std::size_t OGL::GeometryArena::UsedBytes() const
+{
+    return (mVertexSpace.Capacity() - mVertexSpace.FreeSize()) * mStride +
+        (mIndexSpace.Capacity() - mIndexSpace.FreeSize()) * mIndexSize;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Size of the GL buffers
+
+\return
+  Vertex and index buffer bytes
+*/
+/****************************************************************************/
+std::size_t OGL::GeometryArena::CapacityBytes() const
+{
+    return mVertexSpace.Capacity() * mStride + mIndexSpace.Capacity() * mIndexSize;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Number of free ranges, more than 2 means Defragment has work to do
+
+\return
+  Free vertex ranges plus free index ranges
+*/
+/****************************************************************************/
+std::size_t OGL::GeometryArena::FragmentCount() const
+{
+    return mVertexSpace.FragmentCount() + mIndexSpace.FragmentCount();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the arena for a vertex format and index type, on the GL thread
+
+\param format
+  Encoding of the vertices
+
+\param indexType
+  GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+
+\return
+  The arena, created on first use
+*/
+/****************************************************************************/
+OGL::GeometryArena& OGL::GeometryArena::Get(VertexFormat format, GLenum indexType)
+{
+    std::unique_ptr<GeometryArena>& arena = Arenas()[ArenaKey(int(format.position), int(format.normal), indexType)];
+    if (!arena)
+    {
+        arena = std::make_unique<GeometryArena>(format, indexType);
+    }
+    return *arena;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Destroy every arena and its buffers, on the GL thread while the context
+  is still current. Every mesh must have freed its range, the next Get
+  starts a new arena.
+*/
+/****************************************************************************/
+void OGL::GeometryArena::DestroyAll()
+{
+    Arenas().clear();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Write the size and fragmentation of every arena to the info log
+*/
+/****************************************************************************/
+void OGL::GeometryArena::Log()
+{
+    const double kb = 1.0 / 1024.0;
+    for (const auto& arena : Arenas())
+    {
+        DEBUG::log.Info("GeometryArena: stride", arena.second->mStride, "index", arena.second->mIndexSize,
+            "used", arena.second->UsedBytes() * kb, "KB of", arena.second->CapacityBytes() * kb, "KB",
+            arena.second->FragmentCount(), "free ranges");
+    }
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Take a vertex and an index range from the free lists
+
+\return
+  False, with nothing taken, if either does not fit
+*/
+/****************************************************************************/
+bool OGL::GeometryArena::Reserve(std::size_t vertexCount, std::size_t indexCount, std::size_t& firstVertex, std::size_t& firstIndex)
+{
+    if (!mVAO || !mVertexSpace.Allocate(vertexCount, firstVertex))
+    {
+        return false;
+    }
+
+    if (!mIndexSpace.Allocate(indexCount, firstIndex))
+    {
+        mVertexSpace.Free(firstVertex, vertexCount);
+        return false;
+    }
+
+    return true;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Copy every live range, packed in handle order, into new buffers
+
+\param vertexCapacity
+  Size of the new vertex buffer in vertices
+
+\param indexCapacity
+  Size of the new index buffer in indices
+*/
+/****************************************************************************/
+void OGL::GeometryArena::Rebuild(std::size_t vertexCapacity, std::size_t indexCapacity)
+{
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * mStride, nullptr, GL_STATIC_DRAW);
+
+    // vertices
+    std::size_t nextVertex = 0;
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, mVBO);
+    for (Block& block : mBlocks)
+    {
+        if (block.live && block.vertexCount > 0)
+        {
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, block.firstVertex * mStride, nextVertex * mStride, block.vertexCount * mStride);
+        }
+        block.firstVertex = nextVertex;
+        nextVertex += block.vertexCount;
+    }
+
+    // indices
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * mIndexSize, nullptr, GL_STATIC_DRAW);
+
+    std::size_t nextIndex = 0;
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, mIBO);
+    for (Block& block : mBlocks)
+    {
+        if (block.live && block.indexCount > 0)
+        {
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, block.firstIndex * mIndexSize, nextIndex * mIndexSize, block.indexCount * mIndexSize);
+        }
+        block.firstIndex = nextIndex;
+        nextIndex += block.indexCount;
+    }
+
+    GLState::DeleteBuffer(mVBO);
+    GLState::DeleteBuffer(mIBO);
+    mVBO = buffers[0];
+    mIBO = buffers[1];
+
+    mVertexSpace.Reset(nextVertex, vertexCapacity);
+    mIndexSpace.Reset(nextIndex, indexCapacity);
+    SetupVertexArray();
+    Track();
+
+    DEBUG::log.Info("GeometryArena: rebuilt at", CapacityBytes() / 1024.0, "KB,", UsedBytes() / 1024.0, "KB used");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Point the shared VAO at the current buffers
+*/
+/****************************************************************************/
+void OGL::GeometryArena::SetupVertexArray()
+{
+    if (!mVAO)
+    {
+        glGenVertexArrays(1, &mVAO);
+    }
+
+    GLState::BindVertexArray(mVAO);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, mVBO);
+    mFormat.SetAttributes();
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIBO);
+
+    // nothing else may bind an element buffer into the arena's vertex array
+    GLState::BindVertexArray(0);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Report the space no mesh uses to the memory tracker, the meshes report
+  their own ranges
+*/
+/****************************************************************************/
+void OGL::GeometryArena::Track() const
+{
+    MemoryTracker::Track(this, "GeometryArena free space", 0, CapacityBytes() - UsedBytes());
+}
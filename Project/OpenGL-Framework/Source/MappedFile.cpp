@@ -0,0 +1,282 @@
+/****************************************************************************/
+/*!
+\file
+   MappedFile.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Read only memory mapped file
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Unmap the file
+*/
+/****************************************************************************/
+OGL::MappedFile::~MappedFile()
+{
+    Close();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Map a file
+
+\param path
+  The file to map, check IsOpen() for success
+*/
+/****************************************************************************/
+OGL::MappedFile::MappedFile(const std::string& path)
+{
+    Open(path);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Take over another mapping
+*/
+/****************************************************************************/
+OGL::MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    Swap(other);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Take over another mapping, releasing this one
+*/
+/****************************************************************************/
+OGL::MappedFile& OGL::MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        Swap(other);
+    }
+    return *this;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Map a whole file read only
+
+\param path
+  The file to map
+
+\return
+  True on success, an empty file maps to a null pointer of size 0
+*/
+/****************************************************************************/
+bool OGL::MappedFile::Open(const std::string& path)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    mFile = file;
+    mSize = std::size_t(size.QuadPart);
+    mOpen = true;
+
+    // a zero length file can not be mapped
+    if (mSize == 0)
+    {
+        return true;
+    }
+
+    mMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mMapping != nullptr)
+    {
+        mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    mFile = open(path.c_str(), O_RDONLY);
+    if (mFile < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(mFile, &info) != 0)
+    {
+        close(mFile);
+        mFile = -1;
+        return false;
+    }
+
+    mSize = std::size_t(info.st_size);
+    mOpen = true;
+
+    // a zero length file can not be mapped
+    if (mSize == 0)
+    {
+        return true;
+    }
+
+    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+    if (data != MAP_FAILED)
+    {
+        mData = static_cast<const char*>(data);
+        madvise(data, mSize, MADV_SEQUENTIAL);
+    }
+#endif
+
+    if (mData == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Unmap and close the file
+*/
+/****************************************************************************/
+void OGL::MappedFile::Close()
+{
+#ifdef _WIN32
+    if (mData)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping)
+    {
+        CloseHandle(mMapping);
+    }
+    if (mFile)
+    {
+        CloseHandle(mFile);
+    }
+    mMapping = nullptr;
+    mFile = nullptr;
+#else
+    if (mData)
+    {
+        munmap(const_cast<char*>(mData), mSize);
+    }
+    if (mFile >= 0)
+    {
+        close(mFile);
+    }
+    mFile = -1;
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+    mOpen = false;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Is a file mapped
+
+\return
+  True if Open succeeded
+*/
+/****************************************************************************/
+bool OGL::MappedFile::IsOpen() const
+{
+    return mOpen;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the mapped bytes
+
+\return
+  The start of the file, null for an empty file
+*/
+/****************************************************************************/
+const char* OGL::MappedFile::Data() const
+{
+    return mData;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the file size
+
+\return
+  Size in bytes
+*/
+/****************************************************************************/
+std::size_t OGL::MappedFile::Size() const
+{
+    return mSize;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Exchange mappings with another file
+*/
+/****************************************************************************/
+void OGL::MappedFile::Swap(MappedFile& other) noexcept
+{
+    std::swap(mFile, other.mFile);
+#ifdef _WIN32
+    std::swap(mMapping, other.mMapping);
+#endif
+    std::swap(mData, other.mData);
+    std::swap(mSize, other.mSize);
+    std::swap(mOpen, other.mOpen);
+}
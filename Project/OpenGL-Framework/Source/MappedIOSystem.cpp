@@ -0,0 +1,408 @@
+/****************************************************************************/
+/*!
+\file
+   MappedIOSystem.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Assimp's default IO system reads files through buffered stdio, copying
+    the whole file at least once. This one maps the file and lets Assimp
+    read from the mapping, so the page cache is the only copy and repeat
+    loads of the same file are served from it.
+
+    Blobs, such as files held by an archive, can be registered under a path
+    and are then read in place in preference to the file system. The memory
+    is not copied, it must stay valid until the blob is unregistered.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "MappedIOSystem.hpp"
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! a registered in-memory file
+    struct Blob
+    {
+        const char* data;
+        std::size_t size;
+    };
+
+    //! blobs are registered from any thread and read from the loader threads
+    std::mutex gMutex;
+
+    //! registered blobs, by normalized path
+    std::unordered_map<std::string, Blob> gBlobs;
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Use one separator so blobs are found however Assimp builds the path
+    */
+    /****************************************************************************/
+    static std::string NormalizePath(std::string path)
+    {
+        std::replace(path.begin(), path.end(), '\\', '/');
+        return path;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Look up a registered blob
+
+    \return
+      True and the blob if one is registered under path
+    */
+    /****************************************************************************/
+    static bool FindBlob(const std::string& path, Blob& blob)
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        auto found = gBlobs.find(NormalizePath(path));
+        if (found == gBlobs.end())
+        {
+            return false;
+        }
+
+        blob = found->second;
+        return true;
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Stream over a mapped file, the stream keeps the mapping open
+
+\param file
+  An open mapping
+*/
+/****************************************************************************/
+OGL::MappedIOStream::MappedIOStream(MappedFile&& file) : mFile(std::move(file))
+{
+    mData = mFile.Data();
+    mSize = mFile.Size();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Stream over memory owned by someone else
+
+\param data
+  Start of the file, must outlive the stream
+
+\param size
+  Size of the file in bytes
+*/
+/****************************************************************************/
+OGL::MappedIOStream::MappedIOStream(const char* data, std::size_t size) : mData(data), mSize(size)
+{
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Copy whole elements out of the stream
+
+\param buffer
+  Where to copy to
+
+\param size
+  Size of one element
+
+\param count
+  Number of elements wanted
+
+\return
+  Number of whole elements read
+*/
+/****************************************************************************/
+std::size_t OGL::MappedIOStream::Read(void* buffer, std::size_t size, std::size_t count)
+{
+    if (size == 0 || count == 0)
+    {
+        return 0;
+    }
+
+    std::size_t available = (mSize - mPosition) / size;
+    count = std::min(count, available);
+    std::memcpy(buffer, mData + mPosition, size * count);
+    mPosition += size * count;
+    return count;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Streams are read only
+
+\return
+  Always 0
+*/
+/****************************************************************************/
+std::size_t OGL::MappedIOStream::Write(const void*, std::size_t, std::size_t)
+{
+    return 0;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Move the read position
+
+\param offset
+  Bytes from the origin
+
+\param origin
+  Start, current position or end of the file
+
+\return
+  aiReturn_FAILURE if the position would leave the file
+*/
+/****************************************************************************/
+aiReturn OGL::MappedIOStream::Seek(std::size_t offset, aiOrigin origin)
+{
+    std::size_t position = 0;
+    switch (origin)
+    {
+    case aiOrigin_SET:
+        position = offset;
+        break;
+    case aiOrigin_CUR:
+        position = mPosition + offset;
+        break;
+    case aiOrigin_END:
+        // Assimp passes the distance back from the end
+        if (offset > mSize)
+        {
+            return aiReturn_FAILURE;
+        }
+        position = mSize - offset;
+        break;
+    default:
+        return aiReturn_FAILURE;
+    }
+
+    if (position > mSize)
+    {
+        return aiReturn_FAILURE;
+    }
+
+    mPosition = position;
+    return aiReturn_SUCCESS;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the read position
+
+\return
+  Bytes from the start of the file
+*/
+/****************************************************************************/
+std::size_t OGL::MappedIOStream::Tell() const
+{
+    return mPosition;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the size of the file
+
+\return
+  Size in bytes
+*/
+/****************************************************************************/
+std::size_t OGL::MappedIOStream::FileSize() const
+{
+    return mSize;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Nothing is ever written
+*/
+/****************************************************************************/
+void OGL::MappedIOStream::Flush()
+{
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Does a blob or file exist
+
+\param file
+  Path to check
+
+\return
+  True if Open would find something
+*/
+/****************************************************************************/
+bool OGL::MappedIOSystem::Exists(const char* file) const
+{
+    Blob blob;
+    if (FindBlob(file, blob))
+    {
+        return true;
+    }
+
+    std::ifstream stream(file, std::ios::binary);
+    return stream.good();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the path separator of the platform
+
+\return
+  The separator Assimp should use when building paths
+*/
+/****************************************************************************/
+char OGL::MappedIOSystem::getOsSeparator() const
+{
+#ifdef _WIN32
+    return '\\';
+#else
+    return '/';
+#endif
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Open a blob, or map a file, for reading
+
+\param file
+  Path to open, blobs registered under it take precedence
+
+\param mode
+  fopen style mode, anything that writes fails
+
+\return
+  A new stream, nullptr if the file can not be read
+*/
+/****************************************************************************/
+Assimp::IOStream* OGL::MappedIOSystem::Open(const char* file, const char* mode)
+{
+    if (std::strchr(mode, 'w') || std::strchr(mode, 'a') || std::strchr(mode, '+'))
+    {
+        return nullptr;
+    }
+
+    Blob blob;
+    if (FindBlob(file, blob))
+    {
+        return new MappedIOStream(blob.data, blob.size);
+    }
+
+    MappedFile mapped;
+    if (!mapped.Open(file))
+    {
+        return nullptr;
+    }
+
+    return new MappedIOStream(std::move(mapped));
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Close a stream returned by Open
+
+\param file
+  The stream, deleted
+*/
+/****************************************************************************/
+void OGL::MappedIOSystem::Close(Assimp::IOStream* file)
+{
+    delete file;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Serve a file from memory, replaces any blob already under the path
+
+\param path
+  Path the blob is opened as
+
+\param data
+  Contents of the file, not copied, must stay valid until unregistered
+
+\param size
+  Size of the file in bytes
+*/
+/****************************************************************************/
+void OGL::MappedIOSystem::RegisterBlob(const std::string& path, const void* data, std::size_t size)
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    gBlobs[NormalizePath(path)] = { static_cast<const char*>(data), size };
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Stop serving a blob, streams already open on it must be closed first
+
+\param path
+  Path the blob was registered under
+*/
+/****************************************************************************/
+void OGL::MappedIOSystem::UnregisterBlob(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    gBlobs.erase(NormalizePath(path));
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Is a blob registered under a path
+
+\param path
+  Path to check
+
+\return
+  True if opening the path reads the blob instead of the file system
+*/
+/****************************************************************************/
+bool OGL::MappedIOSystem::HasBlob(const std::string& path)
+{
+    Blob blob;
+    return FindBlob(path, blob);
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,159 @@
+/****************************************************************************/
+/*!
+\file
+   MemoryTracker.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Engine wide accounting of the CPU and GPU memory held by each asset.
+    Assets report their own sizes whenever they change, the tracker only
+    keeps the latest numbers per owner.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "MemoryTracker.hpp"
+#include <mutex>
+#include <unordered_map>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! assets are tracked from the loader threads as well as the GL thread
+    std::mutex gMutex;
+
+    //! latest report of every live asset, by owner
+    std::unordered_map<const void*, OGL::AssetMemory> gAssets;
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Record what an asset currently holds, replacing its previous report
+
+\param owner
+  The asset, used as its identity
+
+\param name
+  Shown in reports, usually the source path
+
+\param cpuBytes
+  System memory held
+
+\param gpuBytes
+  Buffer and texture memory held
+*/
+/****************************************************************************/
+void OGL::MemoryTracker::Track(const void* owner, const std::string& name, std::size_t cpuBytes, std::size_t gpuBytes)
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    AssetMemory& asset = gAssets[owner];
+    asset.name = name;
+    asset.cpuBytes = cpuBytes;
+    asset.gpuBytes = gpuBytes;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Forget an asset, call when it is destroyed
+
+\param owner
+  The asset passed to Track
+*/
+/****************************************************************************/
+void OGL::MemoryTracker::Untrack(const void* owner)
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    gAssets.erase(owner);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get every tracked asset
+
+\return
+  A copy of the latest reports, largest total first
+*/
+/****************************************************************************/
+std::vector<OGL::AssetMemory> OGL::MemoryTracker::Report()
+{
+    std::vector<AssetMemory> assets;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        assets.reserve(gAssets.size());
+        for (const auto& asset : gAssets)
+        {
+            assets.push_back(asset.second);
+        }
+    }
+
+    std::sort(assets.begin(), assets.end(), [](const AssetMemory& a, const AssetMemory& b)
+    {
+        std::size_t totalA = a.cpuBytes + a.gpuBytes;
+        std::size_t totalB = b.cpuBytes + b.gpuBytes;
+        return totalA != totalB ? totalA > totalB : a.name < b.name;
+    });
+    return assets;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Sum over every tracked asset
+
+\return
+  Total CPU and GPU bytes, the name is empty
+*/
+/****************************************************************************/
+OGL::AssetMemory OGL::MemoryTracker::Total()
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    AssetMemory total;
+    for (const auto& asset : gAssets)
+    {
+        total.cpuBytes += asset.second.cpuBytes;
+        total.gpuBytes += asset.second.gpuBytes;
+    }
+    return total;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Write the report to the info log
+*/
+/****************************************************************************/
+void OGL::MemoryTracker::Log()
+{
+    const double kb = 1.0 / 1024.0;
+    for (const AssetMemory& asset : Report())
+    {
+        DEBUG::log.Info("Memory:", asset.name, "cpu", asset.cpuBytes * kb, "KB gpu", asset.gpuBytes * kb, "KB");
+    }
+
+    AssetMemory total = Total();
+    DEBUG::log.Info("Memory: total cpu", total.cpuBytes * kb, "KB gpu", total.gpuBytes * kb, "KB");
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -15,6 +15,16 @@
 
 #include "OPENGLPCH.hpp"
 #include "Mesh.hpp"
+#include "Hash.hpp"
+#include "MappedIOSystem.hpp"
+#include "MeshCache.hpp"
+#include "MemoryTracker.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "NormalGenerator.hpp"
+#include "ObjLoader.hpp"
+#include "Timer.hpp"
+#include <limits>
 
 /*============================================================================*\
 || --------------------------- GLOBAL VARIABLES ----------------------------- ||
@@ -24,37 +34,903 @@
 || -------------------------- STATIC FUNCTIONS ------------------------------ ||
 \*============================================================================*/
 
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Pack triangles into 16 bit indices. Triangles are grouped into chunks
+      whose vertices span fewer than 65536 indices, each chunk is drawn
+      with its smallest index as the base vertex.
+
+    \param indices
+      32 bit triangle list
+
+    \param count
+      Number of indices
+
+    \param baseVertex
+      Base vertex the indices are relative to
+
+    \param packed
+      The 16 bit index buffer, appended to
+
+    \param draws
+      One draw per chunk is appended
+
+    \return
+      False if a single triangle spans too many vertices to ever fit,
+      in which case the outputs are meaningless
+    */
+    /****************************************************************************/
+    static bool PackShortIndices(const GLuint* indices, std::size_t count, GLint baseVertex,
+        std::vector<GLushort>& packed, DrawList& draws)
+    {
+        const GLuint range = GLuint(Mesh::ShortIndexRange - 1);
+
+        std::size_t first = 0;
+        while (first < count)
+        {
+            // grow the chunk one triangle at a time until its range overflows
+            GLuint min = indices[first];
+            GLuint max = indices[first];
+            std::size_t last = first;
+            for (; last + 2 < count; last += 3)
+            {
+                GLuint triMin = std::min({ indices[last], indices[last + 1], indices[last + 2] });
+                GLuint triMax = std::max({ indices[last], indices[last + 1], indices[last + 2] });
+                if (std::max(max, triMax) - std::min(min, triMin) > range)
+                {
+                    break;
+                }
+                min = std::min(min, triMin);
+                max = std::max(max, triMax);
+            }
+
+            // a triangle that does not fit on its own
+            if (last == first)
+            {
+                return false;
+            }
+
+            draws.Add(GLsizei(last - first), packed.size() * sizeof(GLushort), baseVertex + GLint(min));
+            for (std::size_t i = first; i < last; ++i)
+            {
+                packed.push_back(GLushort(indices[i] - min));
+            }
+
+            first = last;
+        }
+
+        return true;
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  its a desctructor, it cleans up everything
+*/
+/****************************************************************************/
+OGL::Mesh::~Mesh() 
+{
+    Release();
+    MemoryTracker::Untrack(this);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Constructor, creates a buffer from the device
+
+\param path
+  Path of the file to load
+
+\param format
+  How the vertices are encoded on the GPU
+*/
+/****************************************************************************/
+void OGL::Mesh::Create(std::string path, VertexFormat format)
+{
+    Load(path);
+    Upload(format);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Fill the CPU side vertex and index arrays, from the mesh cache when a
+  matching entry exists, otherwise through Assimp
+
+\param path
+  Path of the file to load
+
+\param useCache
+  False forces a full import, the cache entry is still refreshed.
+  A path served by a MappedIOSystem blob never touches the cache, the
+  cache is keyed on the file the path names on disk.
+
+\param buildBvh
+  Also build a triangle BVH of every submesh, for picking and other
+  queries. A cache entry without one gets it added.
+
+\param progressive
+  Order the vertices coarsest LOD first, so a progressive upload writes
+  only the vertices each level adds. Costs the vertex fetch order of
+  the full detail mesh and can push it to 32 bit indices, so only meshes
+  meant to stream ask for it. Cached apart from the regular order.
+*/
+/****************************************************************************/
+void OGL::Mesh::Load(const std::string& path, bool useCache, bool buildBvh, bool progressive)
+{
+    Timer timer;
+    mData.Clear();
+    mName = path;
+
+    const bool cacheable = !MappedIOSystem::HasBlob(path);
+    MeshCache cache(path, ImportFlags, progressive);
+    if (cacheable && useCache && cache.Load(mData))
+    {
+        if (buildBvh && mData.bvhNodes.empty())
+        {
+            BuildBvh();
+            cache.Save(mData);
+        }
+
+        DEBUG::log.Info("Mesh: loaded", path, "from cache in", timer.Milliseconds(), "ms");
+        mContentKey = mData.Hash();
+        ComputeBounds();
+        Track();
+        return;
+    }
+
+    Import(path);
+    GenerateNormals();
+    Optimize();
+    BuildLods();
+    if (progressive)
+    {
+        OrderProgressive();
+    }
+    BuildMeshlets();
+    if (buildBvh)
+    {
+        BuildBvh();
+    }
+    if (cacheable)
+    {
+        cache.Save(mData);
+    }
+    DEBUG::log.Info("Mesh: imported", path, "in", timer.Milliseconds(), "ms");
+    mContentKey = mData.Hash();
+    ComputeBounds();
+    Track();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Copy the CPU side arrays into the geometry arena of the vertex format.
+  Space for every LOD is taken up front and filled coarsest first, so a
+  progressive upload is drawable as soon as the coarsest level is in and
+  Refine streams the rest into the same range. Unless the mesh was
+  loaded progressive the coarsest level brings every vertex along.
+
+\param format
+  How the vertices are encoded on the GPU
+
+\param progressive
+  Only write the coarsest LOD of every submesh, Refine writes the others
+*/
+/****************************************************************************/
+void OGL::Mesh::Upload(VertexFormat format, bool progressive)
+{
+    if (mResidency == Residency::CpuOnly)
+    {
+        return;
+    }
+
+    if (mData.vertices.empty())
+    {
+        DEBUG::log.Error("Mesh: nothing to upload for", mName, "the CPU side data was released or never loaded");
+        return;
+    }
+
+    Release();
+    mFormat = format;
+    mDecode = VertexDecode();
+
+    if (mFormat.IsPacked())
+    {
+        mDecode = mFormat.Pack(mData.vertices, mStreamVertices);
+    }
+    
+    // 16 bit indices whenever every LOD of every submesh can be chunked to fit them
+    mStreamIndices.reserve(mData.indices.size());
+    mDraws.Clear();
+    mLodDraws.clear();
+    mLodIndices.clear();
+
+    bool fits = true;
+    for (const SubMesh& subMesh : mData.subMeshes)
+    {
+        for (GLuint i = subMesh.firstLod; i < subMesh.firstLod + subMesh.lodCount; ++i)
+        {
+            mLodDraws.push_back(mDraws.Size());
+            mLodIndices.push_back(mStreamIndices.size());
+            fits = fits && PackShortIndices(mData.indices.data() + mData.lods[i].firstIndex, mData.lods[i].indexCount,
+                subMesh.baseVertex, mStreamIndices, mDraws);
+            mLodIndices.push_back(mStreamIndices.size() - mLodIndices.back());
+        }
+    }
+
+    std::size_t indexCount = mStreamIndices.size();
+    if (fits)
+    {
+        mIndexType = GL_UNSIGNED_SHORT;
+    }
+    else
+    {
+        DEBUG::log.Info("Mesh: triangle spans more than", ShortIndexRange, "vertices, using 32 bit indices");
+        mIndexType = GL_UNSIGNED_INT;
+        std::vector<GLushort>().swap(mStreamIndices);
+        mDraws.Clear();
+        mLodDraws.clear();
+        mLodIndices.clear();
+        for (const SubMesh& subMesh : mData.subMeshes)
+        {
+            for (GLuint i = subMesh.firstLod; i < subMesh.firstLod + subMesh.lodCount; ++i)
+            {
+                mLodDraws.push_back(mDraws.Size());
+                mLodIndices.push_back(mData.lods[i].firstIndex);
+                mLodIndices.push_back(mData.lods[i].indexCount);
+                mDraws.Add(GLsizei(mData.lods[i].indexCount), mData.lods[i].firstIndex * sizeof(GLuint), subMesh.baseVertex);
+            }
+        }
+        indexCount = mData.indices.size();
+    }
+    mLodDraws.push_back(mDraws.Size());
+
+    // suballocate from the arena of this format, offsets are relative to
+    // the allocation and rebased when drawing since the arena may move it
+    const std::size_t indexSize = mIndexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    mGpuBytes = mFormat.Stride() * mData.vertices.size() + indexSize * indexCount;
+    mArena = &GeometryArena::Get(mFormat, mIndexType);
+    mAllocation = mArena->Allocate(mData.vertices.size(), indexCount);
+
+    mStreamedLevels = 0;
+    mLevelCount = 1;
+    for (const SubMesh& subMesh : mData.subMeshes)
+    {
+        mLevelCount = std::max(mLevelCount, subMesh.lodCount);
+    }
+    mResident = true;
+
+    Refine();
+    while (!progressive && Refine())
+    {
+    }
+    Track();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Stream the next finer LOD of every submesh into the mesh's range. The
+  vertices are ordered so each level only adds vertices after those of
+  the coarser ones, nothing already written moves.
+
+\return
+  True while finer LODs are left to stream
+*/
+/****************************************************************************/
+bool OGL::Mesh::Refine()
+{
+    if (!IsRefining())
+    {
+        return false;
+    }
+
+    const std::size_t stride = mFormat.Stride();
+    const unsigned char* vertices = mFormat.IsPacked() ? mStreamVertices.data() :
+        reinterpret_cast<const unsigned char*>(mData.vertices.data());
+    const std::size_t indexSize = mIndexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    const unsigned char* indices = mIndexType == GL_UNSIGNED_SHORT ? reinterpret_cast<const unsigned char*>(mStreamIndices.data()) :
+        reinterpret_cast<const unsigned char*>(mData.indices.data());
+
+    for (const SubMesh& subMesh : mData.subMeshes)
+    {
+        if (mStreamedLevels >= subMesh.lodCount)
+        {
+            continue;
+        }
+
+        // the vertices this level adds to the next coarser one, and its indices
+        const GLuint lod = subMesh.firstLod + subMesh.lodCount - 1 - mStreamedLevels;
+        const GLuint coarserVertices = lod + 1 < subMesh.firstLod + subMesh.lodCount ? mData.lods[lod + 1].vertexCount : 0;
+        const std::size_t firstVertex = subMesh.baseVertex + coarserVertices;
+        const std::size_t firstIndex = mLodIndices[lod * 2];
+        mArena->Write(mAllocation, firstVertex, vertices + firstVertex * stride, mData.lods[lod].vertexCount - coarserVertices,
+            firstIndex, indices + firstIndex * indexSize, mLodIndices[lod * 2 + 1]);
+    }
+
+    ++mStreamedLevels;
+    if (IsRefining())
+    {
+        return true;
+    }
+
+    // everything is on the GPU, the staging copies are not needed anymore
+    std::vector<unsigned char>().swap(mStreamVertices);
+    std::vector<GLushort>().swap(mStreamIndices);
+    std::vector<std::size_t>().swap(mLodIndices);
+
+    // Draw only needs the submesh and LOD tables from here on
+    if (mResidency == Residency::GpuOnly)
+    {
+        mData.ReleaseGeometry();
+    }
+    Track();
+    return false;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Render this mesh, every submesh at the coarsest LOD within the error
+
+\param maxError
+  How far the drawn surface may be from the full detail mesh, in model
+  units, 0 always draws the full detail mesh
+*/
+/****************************************************************************/
+void OGL::Mesh::Draw(float maxError) 
+{
+    // still loading
+    if (!mResident)
+    {
+        return;
+    }
+
+    // every submesh and chunk in one call
+    mFrameDraws.Clear();
+    GatherDraws(maxError, mFrameDraws);
+    mArena->Draw(mFrameDraws);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Queue the draws of every submesh at the coarsest LOD within the error.
+  Meshes with the same Arena can gather into one list and be drawn with
+  a single GeometryArena::Draw, as long as they share their uniforms.
+
+\param maxError
+  How far the drawn surface may be from the full detail mesh, in model
+  units, 0 always draws the full detail mesh
+
+\param draws
+  The draws are appended, with offsets into the arena's buffers
+*/
+/****************************************************************************/
+void OGL::Mesh::GatherDraws(float maxError, DrawList& draws) const
+{
+    if (!mResident)
+    {
+        return;
+    }
+
+    const std::size_t indexOffset = mArena->IndexOffset(mAllocation);
+    const GLint baseVertex = mArena->BaseVertex(mAllocation);
+    const GLsizei first = draws.Size();
+
+    // the LOD errors of a submesh only grow along its chain, which starts
+    // at the finest level streamed so far
+    for (const SubMesh& subMesh : mData.subMeshes)
+    {
+        GLuint lod = subMesh.firstLod + (subMesh.lodCount > mStreamedLevels ? subMesh.lodCount - mStreamedLevels : 0);
+        while (lod + 1 < subMesh.firstLod + subMesh.lodCount && mData.lods[lod + 1].error <= maxError)
+        {
+            ++lod;
+        }
+        draws.Append(mDraws, mLodDraws[lod], mLodDraws[lod + 1] - mLodDraws[lod]);
+    }
+
+    for (GLsizei i = first; i < draws.Size(); ++i)
+    {
+        draws.offsets[i] = static_cast<char*>(draws.offsets[i]) + indexOffset;
+        draws.baseVertices[i] += baseVertex;
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the arena the mesh is allocated from
+
+\return
+  The arena, nullptr until the mesh is uploaded
+*/
+/****************************************************************************/
+OGL::GeometryArena* OGL::Mesh::Arena() const
+{
+    return mResident ? mArena : nullptr;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Has the mesh been uploaded, a mesh that is still loading draws nothing
+
+\return
+  True once Upload has run
+*/
+/****************************************************************************/
+bool OGL::Mesh::IsResident() const
+{
+    return mResident;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Is a progressive upload still streaming finer LODs, the mesh draws
+  its coarser levels meanwhile
+
+\return
+  True until Refine has written every LOD
+*/
+/****************************************************************************/
+bool OGL::Mesh::IsRefining() const
+{
+    return mResident && mStreamedLevels < mLevelCount;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Change where the mesh keeps its data. Memory released by a change is
+  only brought back by loading the mesh again.
+
+\param residency
+  The new policy, best set before Load
+*/
+/****************************************************************************/
+void OGL::Mesh::SetResidency(Residency residency)
+{
+    mResidency = residency;
+    if (mResidency == Residency::CpuOnly)
+    {
+        Release();
+    }
+    else if (mResidency == Residency::GpuOnly && mResident && !IsRefining())
+    {
+        mData.ReleaseGeometry();
+    }
+    Track();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get where the mesh keeps its data
+
+\return
+  The residency policy
+*/
+/****************************************************************************/
+OGL::Residency OGL::Mesh::GetResidency() const
+{
+    return mResidency;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  System memory held by the mesh
+
+\return
+  Bytes allocated for the CPU side arrays
+*/
+/****************************************************************************/
+std::size_t OGL::Mesh::CpuBytes() const
+{
+    return mData.Bytes();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  GPU memory held by the mesh
+
+\return
+  Bytes of vertex and index buffer storage, 0 if not resident
+*/
+/****************************************************************************/
+std::size_t OGL::Mesh::GpuBytes() const
+{
+    return mGpuBytes;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Identity of the loaded geometry, equal for equal geometry whatever
+  file it came from
+
+\return
+  The hash, 0 before the first Load
+*/
+/****************************************************************************/
+std::uint64_t OGL::Mesh::ContentKey() const
+{
+    return mContentKey;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the GPU vertex encoding
+
+\return
+  The format the mesh was uploaded with
+*/
+/****************************************************************************/
+const OGL::VertexFormat& OGL::Mesh::Format() const
+{
+    return mFormat;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get what the vertex shader needs to decode this mesh
+
+\return
+  Position scale / bias and the normal encoding
+*/
+/****************************************************************************/
+const OGL::VertexDecode& OGL::Mesh::Decode() const
+{
+    return mDecode;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the CPU side vertices
+
+\return
+  The full precision vertices, empty once a GpuOnly mesh is uploaded
+*/
+/****************************************************************************/
+const std::vector<OGL::Vertex>& OGL::Mesh::Vertices() const
+{
+    return mData.vertices;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the submesh table
+
+\return
+  One entry per Assimp mesh, in import order
+*/
+/****************************************************************************/
+const std::vector<OGL::SubMesh>& OGL::Mesh::SubMeshes() const
+{
+    return mData.subMeshes;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the LOD table
+
+\return
+  Every LOD of every submesh, SubMesh::firstLod indexes into it
+*/
+/****************************************************************************/
+const std::vector<OGL::MeshLod>& OGL::Mesh::Lods() const
+{
+    return mData.lods;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Is there a BVH to query
+
+\return
+  True if the mesh was loaded with one and its geometry is still resident
+*/
+/****************************************************************************/
+bool OGL::Mesh::HasBvh() const
+{
+    return !mData.bvhNodes.empty();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get all of the CPU side data
+
+\return
+  Vertices, indices and the submesh, LOD and meshlet tables
+*/
+/****************************************************************************/
+const OGL::MeshData& OGL::Mesh::Data() const
+{
+    return mData;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the box of the whole mesh
+
+\return
+  Box around every vertex, empty at the origin if nothing is loaded
+*/
+/****************************************************************************/
+OGL::Bounds OGL::Mesh::GetBounds() const
+{
+    return mBounds;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the bounding sphere of the whole mesh
+
+\return
+  Sphere around every vertex, empty at the origin if nothing is loaded
+*/
+/****************************************************************************/
+OGL::BoundingSphere OGL::Mesh::GetSphere() const
+{
+    return mSphere;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Empty every array
+*/
+/****************************************************************************/
+void OGL::MeshData::Clear()
+{
+    vertices.clear();
+    indices.clear();
+    subMeshes.clear();
+    lods.clear();
+    meshlets.clear();
+    meshletVertices.clear();
+    meshletTriangles.clear();
+    bvhNodes.clear();
+    bvhTriangles.clear();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Free the vertex, index, meshlet and BVH arrays, keeping the small
+  submesh and LOD tables that drawing needs
+*/
+/****************************************************************************/
+void OGL::MeshData::ReleaseGeometry()
+{
+    // swap with empties, clear() keeps the capacity
+    std::vector<Vertex>().swap(vertices);
+    std::vector<GLuint>().swap(indices);
+    std::vector<Meshlet>().swap(meshlets);
+    std::vector<GLuint>().swap(meshletVertices);
+    std::vector<std::uint8_t>().swap(meshletTriangles);
+    std::vector<BvhNode>().swap(bvhNodes);
+    std::vector<GLuint>().swap(bvhTriangles);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  System memory held by the arrays
+
+\return
+  Allocated bytes, including unused capacity
+*/
+/****************************************************************************/
+std::size_t OGL::MeshData::Bytes() const
+{
+    return vertices.capacity() * sizeof(Vertex) +
+        indices.capacity() * sizeof(GLuint) +
+        subMeshes.capacity() * sizeof(SubMesh) +
+        lods.capacity() * sizeof(MeshLod) +
+        meshlets.capacity() * sizeof(Meshlet) +
+        meshletVertices.capacity() * sizeof(GLuint) +
+        meshletTriangles.capacity() * sizeof(std::uint8_t) +
+        bvhNodes.capacity() * sizeof(BvhNode) +
+        bvhTriangles.capacity() * sizeof(GLuint);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Hash the geometry, the LODs, meshlets and BVH are built from it so
+  they are left out, a mesh hashes the same with or without a BVH
+
+\return
+  64 bit hash of the vertices, indices and submeshes
+*/
+/****************************************************************************/
+std::uint64_t OGL::MeshData::Hash() const
+{
+    std::uint64_t hash = HashValue(vertices.size());
+    hash = HashValue(indices.size(), hash);
+    hash = HashValue(subMeshes.size(), hash);
+    hash = Hash64(vertices.data(), vertices.size() * sizeof(Vertex), hash);
+    hash = Hash64(indices.data(), indices.size() * sizeof(GLuint), hash);
+    for (SubMesh subMesh : subMeshes)
+    {
+        subMesh.firstBvhNode = 0;
+        subMesh.bvhNodeCount = 0;
+        hash = Hash64(&subMesh, sizeof(SubMesh), hash);
+    }
+    return hash;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Queue one draw
+
+\param count
+  Number of indices
+
+\param offset
+  Byte offset into the index buffer
+
+\param baseVertex
+  Added to every index
+*/
+/****************************************************************************/
+void OGL::DrawList::Add(GLsizei count, std::size_t offset, GLint baseVertex)
+{
+    counts.push_back(count);
+    offsets.push_back(reinterpret_cast<void*>(offset));
+    baseVertices.push_back(baseVertex);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Queue a range of draws from another list
+
+\param other
+  The list to copy from
+
+\param first
+  Index of the first draw to copy
+
+\param count
+  Number of draws to copy
+*/
+/****************************************************************************/
+void OGL::DrawList::Append(const DrawList& other, GLsizei first, GLsizei count)
+{
+    counts.insert(counts.end(), other.counts.begin() + first, other.counts.begin() + first + count);
+    offsets.insert(offsets.end(), other.offsets.begin() + first, other.offsets.begin() + first + count);
+    baseVertices.insert(baseVertices.end(), other.baseVertices.begin() + first, other.baseVertices.begin() + first + count);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Remove every draw
+*/
+/****************************************************************************/
+void OGL::DrawList::Clear()
+{
+    counts.clear();
+    offsets.clear();
+    baseVertices.clear();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Number of draws
+
+\return
+  The draw count
+*/
+/****************************************************************************/
+GLsizei OGL::DrawList::Size() const
+{
+    return GLsizei(counts.size());
+}
+
 /*============================================================================*\
-|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
 \*============================================================================*/
 
 /****************************************************************************/
 /*!
 \brief
-  its a desctructor, it cleans up everything
+  Give the arena range back, the CPU side data is kept
 */
 /****************************************************************************/
-OGL::Mesh::~Mesh() 
+void OGL::Mesh::Release()
 {
-    glDeleteVertexArrays(1, &mVAO);
-    glDeleteBuffers(1, &mVBO);
-    glDeleteBuffers(1, &mIBO);
+    if (mArena)
+    {
+        mArena->Free(mAllocation);
+        mArena = nullptr;
+        mAllocation = GeometryArena::InvalidHandle;
+    }
+    mResident = false;
+    mGpuBytes = 0;
+    mStreamedLevels = 0;
+    mLevelCount = 0;
+    std::vector<unsigned char>().swap(mStreamVertices);
+    std::vector<GLushort>().swap(mStreamIndices);
+    std::vector<std::size_t>().swap(mLodIndices);
 }
 
 /****************************************************************************/
 /*!
 \brief
-  Constructor, creates a buffer from the device
+  Report the current CPU and GPU footprint to the memory tracker
+*/
+/****************************************************************************/
+void OGL::Mesh::Track() const
+{
+    MemoryTracker::Track(this, mName, CpuBytes(), GpuBytes());
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Box and sphere of the whole mesh, the importers fill in the submeshes'
+  own, kept once the vertices are released
+*/
+/****************************************************************************/
+void OGL::Mesh::ComputeBounds()
+{
+    MeshBounds::Compute(mData.vertices.data(), mData.vertices.size(), mBounds, mSphere);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Import a file, OBJ files go through the multi-threaded ObjLoader and
+  fall back to Assimp if it can not read them, everything else goes
+  through Assimp. Assimp reads through a MappedIOSystem, so registered
+  blobs can be loaded by path like any other file.
 
 \param path
   Path of the file to load
 */
 /****************************************************************************/
-void OGL::Mesh::Create(std::string path)
+void OGL::Mesh::Import(const std::string& path)
 {
+    if (ObjLoader::IsObj(path) && !MappedIOSystem::HasBlob(path))
+    {
+        if (ObjLoader::Load(path, mData.vertices, mData.indices, mData.subMeshes))
+        {
+            return;
+        }
+        DEBUG::log.Error("Mesh: ObjLoader failed on", path, "falling back to Assimp");
+    }
+
     // read file via ASSIMP
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals);
+    importer.SetIOHandler(new MappedIOSystem);
+    const aiScene* scene = importer.ReadFile(path, ImportFlags);
 
     // check for errors
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
@@ -62,89 +938,308 @@ void OGL::Mesh::Create(std::string path)
         throw std::runtime_error(importer.GetErrorString());
     }
 
-    // store data
+    // store data, reserved up front so no mesh reallocates the arrays
+    std::size_t vertexCount = 0;
+    std::size_t indexCount = 0;
+    for (unsigned i = 0; i < scene->mNumMeshes; ++i)
+    {
+        vertexCount += scene->mMeshes[i]->mNumVertices;
+        indexCount += std::size_t(scene->mMeshes[i]->mNumFaces) * 3;
+    }
+    mData.vertices.reserve(vertexCount);
+    mData.indices.reserve(indexCount);
+
     for (unsigned i = 0; i < scene->mNumMeshes; ++i)
     {
         aiMesh* mesh = scene->mMeshes[i];
         GetMesh(mesh);
     }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Generate smooth normals for the vertices the importer left without,
+  authored normals, hard edges included, are kept. Submeshes with every
+  normal are copied as they are, in the others the generator may split
+  vertices along creases, so the arrays are rebuilt.
+*/
+/****************************************************************************/
+void OGL::Mesh::GenerateNormals()
+{
+    bool missing = false;
+    for (const SubMesh& subMesh : mData.subMeshes)
+    {
+        missing = missing || !NormalGenerator::HasNormals(mData.vertices.data() + subMesh.baseVertex, subMesh.vertexCount);
+    }
 
-    // VBO / IBO
-    glGenVertexArrays(1, &mVAO);
-    glGenBuffers(1, &mVBO);
-    glGenBuffers(1, &mIBO);
+    if (!missing)
+    {
+        return;
+    }
 
-    glBindVertexArray(mVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mVertices.size(), mVertices.data(), GL_STATIC_DRAW);
-    
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * mIndices.size(), mIndices.data(), GL_STATIC_DRAW);
+    Timer timer;
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    vertices.reserve(mData.vertices.size());
+    indices.reserve(mData.indices.size());
+
+    std::vector<Vertex> generatedVertices;
+    std::vector<GLuint> generatedIndices;
+    for (SubMesh& subMesh : mData.subMeshes)
+    {
+        const Vertex* subVertices = mData.vertices.data() + subMesh.baseVertex;
+        const GLuint* subIndices = mData.indices.data() + subMesh.firstIndex;
+        GLint baseVertex = GLint(vertices.size());
+        GLuint firstIndex = GLuint(indices.size());
+
+        if (NormalGenerator::HasNormals(subVertices, subMesh.vertexCount))
+        {
+            vertices.insert(vertices.end(), subVertices, subVertices + subMesh.vertexCount);
+            indices.insert(indices.end(), subIndices, subIndices + subMesh.indexCount);
+        }
+        else
+        {
+            NormalGenerator::Generate(subVertices, subMesh.vertexCount, subIndices, subMesh.indexCount,
+                glm::radians(NormalCreaseDegrees), generatedVertices, generatedIndices);
+            vertices.insert(vertices.end(), generatedVertices.begin(), generatedVertices.end());
+            indices.insert(indices.end(), generatedIndices.begin(), generatedIndices.end());
 
-    // position
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            // unreferenced vertices are dropped, so the volumes can shrink
+            subMesh.vertexCount = GLuint(generatedVertices.size());
+            MeshBounds::Compute(generatedVertices.data(), generatedVertices.size(), subMesh.bounds, subMesh.sphere);
+        }
 
-    // normal
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+        subMesh.baseVertex = baseVertex;
+        subMesh.firstIndex = firstIndex;
+    }
 
-    glBindVertexArray(0);
+    mData.vertices.swap(vertices);
+    mData.indices.swap(indices);
+    DEBUG::log.Info("Mesh: generated normals in", timer.Milliseconds(), "ms");
 }
 
 /****************************************************************************/
 /*!
 \brief
-  Render this mesh
+  Reorder the imported triangles and vertices for the vertex cache,
+  overdraw and vertex fetch. Runs once per import, the result is cached.
 */
 /****************************************************************************/
-void OGL::Mesh::Draw() 
+void OGL::Mesh::Optimize()
 {
-    glBindVertexArray(mVAO);
-    glDrawElements(GL_TRIANGLES, GLsizei(mIndices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-}
+    // each submesh is optimized on its own, its indices are local
+    for (const SubMesh& subMesh : mData.subMeshes)
+    {
+        VertexCacheStats before;
+        VertexCacheStats after;
+        MeshOptimizer::Optimize(mData.vertices.data() + subMesh.baseVertex, subMesh.vertexCount,
+            mData.indices.data() + subMesh.firstIndex, subMesh.indexCount, &before, &after);
 
-/*============================================================================*\
-|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
-\*============================================================================*/
+        DEBUG::log.Info("Mesh: ACMR", before.acmr, "->", after.acmr, "ATVR", before.atvr, "->", after.atvr);
+    }
+}
 
 /****************************************************************************/
 /*!
 \brief
-  Get the vertex and index data from assimp
+  Build the LOD chain of every submesh. Each level simplifies the one
+  before it and is appended to the index array, the chain stops early
+  once simplification stalls on borders and seams.
+*/
+/****************************************************************************/
+void OGL::Mesh::BuildLods()
+{
+    mData.lods.clear();
 
-\param mesh
-  The ASSIMP type mesh
+    std::vector<GLuint> previous;
+    std::vector<GLuint> lod;
+    std::vector<std::size_t> clusters;
+    for (SubMesh& subMesh : mData.subMeshes)
+    {
+        subMesh.firstLod = GLuint(mData.lods.size());
+        mData.lods.push_back({ subMesh.firstIndex, subMesh.indexCount, 0.0f, subMesh.vertexCount });
+
+        previous.assign(mData.indices.begin() + subMesh.firstIndex, mData.indices.begin() + subMesh.firstIndex + subMesh.indexCount);
+        float error = 0;
+        while (mData.lods.size() - subMesh.firstLod < MaxLods)
+        {
+            std::size_t target = std::size_t(previous.size() / 3 * LodReduction) * 3;
+            if (target < LodMinTriangles * 3)
+            {
+                break;
+            }
+
+            float lodError = MeshSimplifier::Simplify(mData.vertices.data() + subMesh.baseVertex, subMesh.vertexCount,
+                previous.data(), previous.size(), target, std::numeric_limits<float>::max(), lod);
+            if (lod.size() > previous.size() * (1 + LodReduction) / 2)
+            {
+                break;
+            }
+
+            // each level is simplified from the last, so at worst the errors add up
+            error += lodError;
+            MeshOptimizer::OptimizeVertexCache(lod.data(), lod.size(), subMesh.vertexCount, clusters);
+
+            mData.lods.push_back({ GLuint(mData.indices.size()), GLuint(lod.size()), error, subMesh.vertexCount });
+            mData.indices.insert(mData.indices.end(), lod.begin(), lod.end());
+            DEBUG::log.Info("Mesh: LOD", mData.lods.size() - subMesh.firstLod - 1, lod.size() / 3, "triangles, error", error);
+
+            previous.swap(lod);
+        }
+
+        subMesh.lodCount = GLuint(mData.lods.size()) - subMesh.firstLod;
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Reorder the vertices of every submesh coarsest LOD first, each level
+  only adds vertices after those of the coarser ones. A progressive
+  upload then writes one contiguous vertex range per level and never
+  moves what it already wrote. Within a level vertices keep the order
+  that level first uses them in, vertices no level uses go last.
 */
 /****************************************************************************/
-void OGL::Mesh::GetMesh(aiMesh* mesh) 
+void OGL::Mesh::OrderProgressive()
 {
-    // verticies
-    for (unsigned i = 0; i < mesh->mNumVertices; ++i)
+    constexpr GLuint Unassigned = ~0u;
+
+    std::vector<GLuint> remap;
+    std::vector<Vertex> ordered;
+    for (const SubMesh& subMesh : mData.subMeshes)
     {
-        Vertex vertex;
+        remap.assign(subMesh.vertexCount, Unassigned);
+        GLuint next = 0;
+        for (GLuint i = subMesh.firstLod + subMesh.lodCount; i-- > subMesh.firstLod;)
+        {
+            MeshLod& lod = mData.lods[i];
+            for (GLuint j = lod.firstIndex; j < lod.firstIndex + lod.indexCount; ++j)
+            {
+                if (remap[mData.indices[j]] == Unassigned)
+                {
+                    remap[mData.indices[j]] = next++;
+                }
+            }
+            lod.vertexCount = next;
+        }
+
+        for (GLuint& index : remap)
+        {
+            if (index == Unassigned)
+            {
+                index = next++;
+            }
+        }
+        if (subMesh.lodCount > 0)
+        {
+            mData.lods[subMesh.firstLod].vertexCount = next;
+        }
 
-        // position
-        vertex.position = glm::vec4(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z, 1);
+        Vertex* vertices = mData.vertices.data() + subMesh.baseVertex;
+        ordered.resize(subMesh.vertexCount);
+        for (GLuint v = 0; v < subMesh.vertexCount; ++v)
+        {
+            ordered[remap[v]] = vertices[v];
+        }
+        std::copy(ordered.begin(), ordered.end(), vertices);
 
-        // normals
-        if (mesh->mNormals != nullptr)
+        for (GLuint i = subMesh.firstLod; i < subMesh.firstLod + subMesh.lodCount; ++i)
         {
-            vertex.normal = glm::vec4(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z, 1);
-            vertex.normal = glm::normalize(vertex.normal);
+            GLuint* indices = mData.indices.data() + mData.lods[i].firstIndex;
+            for (GLuint j = 0; j < mData.lods[i].indexCount; ++j)
+            {
+                indices[j] = remap[indices[j]];
+            }
         }
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Split the full detail triangles of every submesh into meshlets
+*/
+/****************************************************************************/
+void OGL::Mesh::BuildMeshlets()
+{
+    mData.meshlets.clear();
+    mData.meshletVertices.clear();
+    mData.meshletTriangles.clear();
+
+    for (SubMesh& subMesh : mData.subMeshes)
+    {
+        subMesh.firstMeshlet = GLuint(mData.meshlets.size());
+        MeshletStats stats = MeshletBuilder::Build(mData.vertices.data() + subMesh.baseVertex, subMesh.vertexCount,
+            mData.indices.data() + subMesh.firstIndex, subMesh.indexCount,
+            mData.meshlets, mData.meshletVertices, mData.meshletTriangles);
+        subMesh.meshletCount = GLuint(stats.meshletCount);
+
+        DEBUG::log.Info("Mesh:", stats.meshletCount, "meshlets, vertex fill", stats.vertexFill,
+            "triangle fill", stats.triangleFill, "with cones", stats.coneCount);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Build a triangle BVH over the full detail triangles of every submesh
+*/
+/****************************************************************************/
+void OGL::Mesh::BuildBvh()
+{
+    Timer timer;
+    mData.bvhNodes.clear();
+    mData.bvhTriangles.clear();
+
+    for (SubMesh& subMesh : mData.subMeshes)
+    {
+        subMesh.firstBvhNode = GLuint(mData.bvhNodes.size());
+        BvhStats stats = BvhBuilder::Build(mData.vertices.data() + subMesh.baseVertex, subMesh.vertexCount,
+            mData.indices.data() + subMesh.firstIndex, subMesh.indexCount, mData.bvhNodes, mData.bvhTriangles);
+        subMesh.bvhNodeCount = GLuint(stats.nodeCount);
 
-        mVertices.push_back(vertex);
+        DEBUG::log.Info("Mesh: BVH of", stats.nodeCount, "nodes,", stats.leafCount, "leaves, depth", stats.depth,
+            "SAH cost", stats.cost, "against", subMesh.indexCount / 3, "for a linear scan");
     }
 
-    // indicies
+    DEBUG::log.Info("Mesh: built BVH in", timer.Milliseconds(), "ms");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the vertex and index data from assimp, appended as a new submesh
+
+\param mesh
+  The ASSIMP type mesh
+*/
+/****************************************************************************/
+void OGL::Mesh::GetMesh(aiMesh* mesh) 
+{
+    SubMesh subMesh;
+    subMesh.firstIndex = GLuint(mData.indices.size());
+    subMesh.baseVertex = GLint(mData.vertices.size());
+    subMesh.vertexCount = mesh->mNumVertices;
+
+    // verticies, straight into reserved storage
+    static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "Assimp must be built with float positions");
+    mData.vertices.resize(mData.vertices.size() + mesh->mNumVertices);
+    Vertex* vertices = mData.vertices.data() + subMesh.baseVertex;
+    MeshBounds::Convert(&mesh->mVertices[0].x, mesh->mNormals ? &mesh->mNormals[0].x : nullptr, mesh->mNumVertices, vertices);
+    MeshBounds::Compute(vertices, mesh->mNumVertices, subMesh.bounds, subMesh.sphere);
+
+    // indicies, relative to this submesh, point and line faces are skipped
     for (unsigned i = 0; i < mesh->mNumFaces; ++i)
     {
-        aiFace face = mesh->mFaces[i];
-        for (unsigned j = 0; j < face.mNumIndices; ++j)
+        const aiFace& face = mesh->mFaces[i];
+        if (face.mNumIndices == 3)
         {
-            mIndices.push_back(face.mIndices[j]);
+            mData.indices.insert(mData.indices.end(), face.mIndices, face.mIndices + 3);
         }
     }
+
+    subMesh.indexCount = GLuint(mData.indices.size()) - subMesh.firstIndex;
+    mData.subMeshes.push_back(subMesh);
 }
@@ -0,0 +1,435 @@
+/****************************************************************************/
+/*!
+\file
+   MeshBounds.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Vertex conversion and bounding volumes with SSE2, the x64 baseline,
+    and a scalar fallback for other targets.
+
+    The bounding sphere starts at the box center and repeatedly grows just
+    enough to take in the farthest vertex (Ritter 1990), each step is one
+    vectorized farthest point search. Whatever sphere it settles on has
+    its radius set to the true farthest distance, so it always holds every
+    vertex, and the box center sphere is kept if that is smaller.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "MeshBounds.hpp"
+#include "Parallel.hpp"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OGL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! smallest range worth a thread for the bounds passes
+    constexpr std::size_t MinVerticesPerThread = 1 << 16;
+
+    //! result of a farthest point search
+    struct Farthest
+    {
+        float distance2 = -1;
+        std::size_t index = 0;
+
+        //! ties go to the lower index so the result does not depend on the split
+        bool Beats(const Farthest& other) const
+        {
+            return distance2 > other.distance2 || (distance2 == other.distance2 && index < other.index);
+        }
+    };
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Vertex as glm::vec4(glm::normalize(n), 0) stores it, or 0 without a
+      normal, the convention every importer follows
+    */
+    /****************************************************************************/
+    static void ConvertOne(const float* position, const float* normal, Vertex& vertex)
+    {
+        vertex.position = glm::vec4(position[0], position[1], position[2], 1);
+        glm::vec3 n = normal ? glm::vec3(normal[0], normal[1], normal[2]) : glm::vec3(0);
+        vertex.normal = glm::length(n) > 0 ? glm::vec4(glm::normalize(n), 0) : glm::vec4(0);
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Box of a range of vertices
+    */
+    /****************************************************************************/
+    static Bounds AabbRange(const Vertex* vertices, std::size_t begin, std::size_t end)
+    {
+#ifdef OGL_SSE2
+        // two accumulators so consecutive min / max do not wait on each other
+        __m128 min0 = _mm_loadu_ps(&vertices[begin].position.x);
+        __m128 max0 = min0;
+        __m128 min1 = min0;
+        __m128 max1 = min0;
+
+        std::size_t i = begin;
+        for (; i + 2 <= end; i += 2)
+        {
+            __m128 p0 = _mm_loadu_ps(&vertices[i].position.x);
+            __m128 p1 = _mm_loadu_ps(&vertices[i + 1].position.x);
+            min0 = _mm_min_ps(min0, p0);
+            max0 = _mm_max_ps(max0, p0);
+            min1 = _mm_min_ps(min1, p1);
+            max1 = _mm_max_ps(max1, p1);
+        }
+        for (; i < end; ++i)
+        {
+            __m128 p = _mm_loadu_ps(&vertices[i].position.x);
+            min0 = _mm_min_ps(min0, p);
+            max0 = _mm_max_ps(max0, p);
+        }
+
+        alignas(16) float min[4];
+        alignas(16) float max[4];
+        _mm_store_ps(min, _mm_min_ps(min0, min1));
+        _mm_store_ps(max, _mm_max_ps(max0, max1));
+
+        Bounds bounds;
+        bounds.min = glm::vec3(min[0], min[1], min[2]);
+        bounds.max = glm::vec3(max[0], max[1], max[2]);
+        return bounds;
+#else
+        Bounds bounds;
+        bounds.min = bounds.max = glm::vec3(vertices[begin].position);
+        for (std::size_t i = begin + 1; i < end; ++i)
+        {
+            bounds.min = glm::min(bounds.min, glm::vec3(vertices[i].position));
+            bounds.max = glm::max(bounds.max, glm::vec3(vertices[i].position));
+        }
+        return bounds;
+#endif
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Vertex of a range farthest from a point
+    */
+    /****************************************************************************/
+    static Farthest FarthestRange(const Vertex* vertices, std::size_t begin, std::size_t end, const glm::vec3& point)
+    {
+        Farthest best;
+        std::size_t i = begin;
+
+#ifdef OGL_SSE2
+        // four vertices per step, transposed so each lane is one vertex
+        const __m128 cx = _mm_set1_ps(point.x);
+        const __m128 cy = _mm_set1_ps(point.y);
+        const __m128 cz = _mm_set1_ps(point.z);
+        __m128 bestDistance = _mm_set1_ps(-1);
+        __m128i bestIndex = _mm_setzero_si128();
+        __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i four = _mm_set1_epi32(4);
+
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(&vertices[i + 0].position.x);
+            __m128 y = _mm_loadu_ps(&vertices[i + 1].position.x);
+            __m128 z = _mm_loadu_ps(&vertices[i + 2].position.x);
+            __m128 w = _mm_loadu_ps(&vertices[i + 3].position.x);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+
+            __m128 dx = _mm_sub_ps(x, cx);
+            __m128 dy = _mm_sub_ps(y, cy);
+            __m128 dz = _mm_sub_ps(z, cz);
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+            // strictly greater keeps the first of equal vertices in each lane
+            __m128 greater = _mm_cmpgt_ps(distance, bestDistance);
+            __m128i mask = _mm_castps_si128(greater);
+            bestDistance = _mm_or_ps(_mm_and_ps(greater, distance), _mm_andnot_ps(greater, bestDistance));
+            bestIndex = _mm_or_si128(_mm_and_si128(mask, index), _mm_andnot_si128(mask, bestIndex));
+            index = _mm_add_epi32(index, four);
+        }
+
+        alignas(16) float laneDistance[4];
+        alignas(16) std::int32_t laneIndex[4];
+        _mm_store_ps(laneDistance, bestDistance);
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneIndex), bestIndex);
+        for (unsigned lane = 0; lane < 4; ++lane)
+        {
+            Farthest candidate;
+            candidate.distance2 = laneDistance[lane];
+            candidate.index = begin + std::size_t(laneIndex[lane]);
+            if (candidate.distance2 >= 0 && candidate.Beats(best))
+            {
+                best = candidate;
+            }
+        }
+#endif
+
+        for (; i < end; ++i)
+        {
+            glm::vec3 d = glm::vec3(vertices[i].position) - point;
+            Farthest candidate;
+            candidate.distance2 = glm::dot(d, d);
+            candidate.index = i;
+            if (candidate.Beats(best))
+            {
+                best = candidate;
+            }
+        }
+
+        return best;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Vertex farthest from a point, split over the worker threads
+    */
+    /****************************************************************************/
+    static Farthest FindFarthest(const Vertex* vertices, std::size_t count, const glm::vec3& point)
+    {
+        std::vector<Farthest> results(ParallelRanges(count, MinVerticesPerThread));
+        ParallelFor(count, MinVerticesPerThread, [&](std::size_t begin, std::size_t end, unsigned range)
+        {
+            results[range] = FarthestRange(vertices, begin, end, point);
+        });
+
+        Farthest best = results[0];
+        for (const Farthest& result : results)
+        {
+            best = result.Beats(best) ? result : best;
+        }
+        return best;
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Convert tightly packed float3 positions and normals to vertices
+
+\param positions
+  3 floats per vertex
+
+\param normals
+  3 floats per vertex, or nullptr to leave the normals 0
+
+\param count
+  Number of vertices
+
+\param vertices
+  Receives count vertices, positions get w = 1 and normals are stored
+  as glm::vec4(glm::normalize(n), 0)
+*/
+/****************************************************************************/
+void OGL::MeshBounds::Convert(const float* positions, const float* normals, std::size_t count, Vertex* vertices)
+{
+    ParallelFor(count, MinVerticesPerThread, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        std::size_t i = begin;
+
+#ifdef OGL_SSE2
+        const __m128 keepXyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        const __m128 oneW = _mm_setr_ps(0, 0, 0, 1);
+
+        // 4 float3 in three loads, x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+        auto load4 = [&](const float* source, __m128 w, __m128 out[4])
+        {
+            __m128 a = _mm_loadu_ps(source + 0);
+            __m128 b = _mm_loadu_ps(source + 4);
+            __m128 c = _mm_loadu_ps(source + 8);
+            __m128 t1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 3, 3));
+            out[0] = a;
+            out[1] = _mm_shuffle_ps(t1, t1, _MM_SHUFFLE(3, 3, 2, 1));
+            out[2] = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 0, 3, 2));
+            out[3] = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 2, 1));
+            for (unsigned k = 0; k < 4; ++k)
+            {
+                out[k] = _mm_or_ps(_mm_and_ps(out[k], keepXyz), w);
+            }
+        };
+
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 p[4];
+            load4(positions + i * 3, oneW, p);
+            for (unsigned k = 0; k < 4; ++k)
+            {
+                _mm_storeu_ps(&vertices[i + k].position.x, p[k]);
+            }
+
+            if (!normals)
+            {
+                for (unsigned k = 0; k < 4; ++k)
+                {
+                    _mm_storeu_ps(&vertices[i + k].normal.x, _mm_setzero_ps());
+                }
+                continue;
+            }
+
+            // normalize the directions, w is 0 and stays 0, zero length stays 0
+            __m128 n[4];
+            load4(normals + i * 3, _mm_setzero_ps(), n);
+            _MM_TRANSPOSE4_PS(n[0], n[1], n[2], n[3]);
+            __m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[0], n[0]), _mm_mul_ps(n[1], n[1])), _mm_mul_ps(n[2], n[2]));
+            __m128 scale = _mm_div_ps(_mm_set1_ps(1), _mm_sqrt_ps(length2));
+            scale = _mm_and_ps(scale, _mm_cmpgt_ps(length2, _mm_setzero_ps()));
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                n[k] = _mm_mul_ps(n[k], scale);
+            }
+            _MM_TRANSPOSE4_PS(n[0], n[1], n[2], n[3]);
+            for (unsigned k = 0; k < 4; ++k)
+            {
+                _mm_storeu_ps(&vertices[i + k].normal.x, n[k]);
+            }
+        }
+#endif
+
+        for (; i < end; ++i)
+        {
+            ConvertOne(positions + i * 3, normals ? normals + i * 3 : nullptr, vertices[i]);
+        }
+    });
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Axis aligned box of a set of vertices
+
+\param vertices
+  The vertices
+
+\param count
+  Number of vertices
+
+\return
+  The box, empty at the origin if count is 0
+*/
+/****************************************************************************/
+OGL::Bounds OGL::MeshBounds::ComputeAabb(const Vertex* vertices, std::size_t count)
+{
+    if (count == 0)
+    {
+        return Bounds();
+    }
+
+    std::vector<Bounds> results(ParallelRanges(count, MinVerticesPerThread));
+    ParallelFor(count, MinVerticesPerThread, [&](std::size_t begin, std::size_t end, unsigned range)
+    {
+        results[range] = AabbRange(vertices, begin, end);
+    });
+
+    Bounds bounds = results[0];
+    for (const Bounds& result : results)
+    {
+        bounds.min = glm::min(bounds.min, result.min);
+        bounds.max = glm::max(bounds.max, result.max);
+    }
+    return bounds;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Fit a sphere around a set of vertices
+
+\param vertices
+  The vertices
+
+\param count
+  Number of vertices
+
+\param aabb
+  Their box, from ComputeAabb
+
+\return
+  A sphere holding every vertex, within a few percent of the smallest
+*/
+/****************************************************************************/
+OGL::BoundingSphere OGL::MeshBounds::ComputeSphere(const Vertex* vertices, std::size_t count, const Bounds& aabb)
+{
+    BoundingSphere sphere;
+    if (count == 0)
+    {
+        return sphere;
+    }
+
+    // the box center sphere is the fallback
+    sphere.center = (aabb.min + aabb.max) * 0.5f;
+    Farthest farthest = FindFarthest(vertices, count, sphere.center);
+    BoundingSphere boxSphere = { sphere.center, std::sqrt(farthest.distance2) };
+
+    for (unsigned i = 0;; ++i)
+    {
+        float distance = std::sqrt(farthest.distance2);
+        if (distance <= sphere.radius || i == SphereIterations)
+        {
+            sphere.radius = std::max(sphere.radius, distance);
+            break;
+        }
+
+        // smallest sphere holding the current one and the farthest vertex
+        glm::vec3 point(vertices[farthest.index].position);
+        float radius = (sphere.radius + distance) * 0.5f;
+        sphere.center += (point - sphere.center) * ((radius - sphere.radius) / distance);
+        sphere.radius = radius;
+
+        farthest = FindFarthest(vertices, count, sphere.center);
+    }
+
+    return sphere.radius < boxSphere.radius ? sphere : boxSphere;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Box and sphere of a set of vertices
+
+\param vertices
+  The vertices
+
+\param count
+  Number of vertices
+
+\param aabb
+  Receives the box
+
+\param sphere
+  Receives the sphere
+*/
+/****************************************************************************/
+void OGL::MeshBounds::Compute(const Vertex* vertices, std::size_t count, Bounds& aabb, BoundingSphere& sphere)
+{
+    aabb = ComputeAabb(vertices, count);
+    sphere = ComputeSphere(vertices, count, aabb);
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,286 @@
+/****************************************************************************/
+/*!
+\file
+   MeshCache.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Versioned binary cache of imported, upload-ready mesh data
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "MeshCache.hpp"
+#include "Hash.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! size of the blocks the source file is hashed in
+    constexpr std::size_t HashBlockSize = 1 << 20;
+
+    //! arrays of MeshData, in the order they follow the header
+    enum Section
+    {
+        SubMeshes,
+        Lods,
+        Meshlets,
+        Vertices,
+        Indices,
+        MeshletVertices,
+        MeshletTriangles,
+        BvhNodes,
+        BvhTriangles,
+        SectionCount
+    };
+
+    //! on disk header, followed by every section
+    struct CacheHeader
+    {
+        char magic[4] = { 'O', 'G', 'L', 'M' };
+        std::uint32_t version = OGL::MeshCache::Version;
+        std::uint64_t key = 0;
+        std::uint64_t counts[SectionCount] = {};
+        std::uint32_t sizes[SectionCount] =
+        {
+            sizeof(OGL::SubMesh), sizeof(OGL::MeshLod), sizeof(OGL::Meshlet), sizeof(OGL::Vertex),
+            sizeof(GLuint), sizeof(GLuint), sizeof(std::uint8_t), sizeof(OGL::BvhNode), sizeof(GLuint)
+        };
+        std::uint32_t padding = 0;
+    };
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Call func(section, array) for every array of the mesh data
+    */
+    /****************************************************************************/
+    template <typename Data, typename Func>
+    static void ForEachSection(Data& data, Func&& func)
+    {
+        func(SubMeshes, data.subMeshes);
+        func(Lods, data.lods);
+        func(Meshlets, data.meshlets);
+        func(Vertices, data.vertices);
+        func(Indices, data.indices);
+        func(MeshletVertices, data.meshletVertices);
+        func(MeshletTriangles, data.meshletTriangles);
+        func(BvhNodes, data.bvhNodes);
+        func(BvhTriangles, data.bvhTriangles);
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Hash the source file and work out where its cache entry lives
+
+\param source
+  Path of the model the cache entry is built from
+
+\param importFlags
+  The Assimp post processing flags used for the import
+
+\param progressive
+  The vertices are ordered for progressive uploads, a separate entry
+*/
+/****************************************************************************/
+OGL::MeshCache::MeshCache(const std::string& source, unsigned importFlags, bool progressive)
+{
+    std::ifstream file(source, std::ios::binary);
+    if (!file)
+    {
+        return;
+    }
+
+    // key on the content, not the name or timestamp, of the source
+    std::uint64_t key = HashSeed;
+    std::vector<char> block(HashBlockSize);
+    while (file)
+    {
+        file.read(block.data(), block.size());
+        key = Hash64(block.data(), std::size_t(file.gcount()), key);
+    }
+
+    // and on everything that changes what the import produces
+    key = HashValue(importFlags, key);
+    key = HashValue(progressive, key);
+    key = HashValue(Version, key);
+    key = HashValue(sizeof(Vertex), key);
+    mKey = key;
+
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(mKey));
+    std::string name = std::filesystem::path(source).stem().string();
+    mPath = std::string(Directory) + name + "_" + hex + ".oglmesh";
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Read a cache entry
+
+\param data
+  Filled with the cached arrays
+
+\return
+  True if a valid entry was found, otherwise data is left empty
+*/
+/****************************************************************************/
+bool OGL::MeshCache::Load(MeshData& data) const
+{
+    if (mPath.empty())
+    {
+        return false;
+    }
+
+    std::ifstream file(mPath, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    // reject anything that was not written by this exact build of the importer
+    CacheHeader expected;
+    CacheHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file ||
+        std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+        header.version != expected.version ||
+        header.key != mKey ||
+        std::memcmp(header.sizes, expected.sizes, sizeof(header.sizes)) != 0)
+    {
+        return false;
+    }
+
+    // the arrays are stored exactly as they are kept in memory
+    ForEachSection(data, [&](Section section, auto& array)
+    {
+        array.resize(std::size_t(header.counts[section]));
+        file.read(reinterpret_cast<char*>(array.data()), header.sizes[section] * array.size());
+    });
+
+    if (!file)
+    {
+        DEBUG::log.Error("MeshCache: truncated cache file", mPath);
+        data.Clear();
+        return false;
+    }
+
+    return true;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Write a cache entry, failures are logged but never fatal
+
+\param data
+  The arrays to store
+*/
+/****************************************************************************/
+void OGL::MeshCache::Save(const MeshData& data) const
+{
+    if (mPath.empty())
+    {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(Directory, error);
+
+    // write to a temporary and rename so a reader never sees half a file
+    std::string temp = mPath + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            DEBUG::log.Error("MeshCache: could not write", temp);
+            return;
+        }
+
+        CacheHeader header;
+        header.key = mKey;
+        ForEachSection(data, [&](Section section, const auto& array)
+        {
+            header.counts[section] = array.size();
+        });
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ForEachSection(data, [&](Section section, const auto& array)
+        {
+            file.write(reinterpret_cast<const char*>(array.data()), header.sizes[section] * array.size());
+        });
+
+        if (!file)
+        {
+            DEBUG::log.Error("MeshCache: could not write", temp);
+            file.close();
+            std::filesystem::remove(temp, error);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temp, mPath, error);
+    if (error)
+    {
+        DEBUG::log.Error("MeshCache: could not rename", temp, error.message());
+        std::filesystem::remove(temp, error);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the cache key
+
+\return
+  Hash of the source content and import settings, 0 if the source is missing
+*/
+/****************************************************************************/
+std::uint64_t OGL::MeshCache::Key() const
+{
+    return mKey;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the path of the cache entry
+
+\return
+  The cache file path, empty if the source is missing
+*/
+/****************************************************************************/
+const std::string& OGL::MeshCache::Path() const
+{
+    return mPath;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,304 @@
+/****************************************************************************/
+/*!
+\file
+   MeshLoader.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Asynchronous mesh loading with main thread GPU upload
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "MeshLoader.hpp"
+#include "Timer.hpp"
+#include <limits>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Drop every queued job and join the workers, a load already running
+  is finished but never uploaded
+*/
+/****************************************************************************/
+OGL::MeshLoader::~MeshLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+        mQueued.clear();
+    }
+    mWake.notify_all();
+
+    for (std::thread& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Start the worker threads
+
+\param threads
+  Number of meshes that can load at once, each load is multi-threaded
+  on its own so this rarely needs to be more than 1
+*/
+/****************************************************************************/
+OGL::MeshLoader::MeshLoader(unsigned threads)
+{
+    for (unsigned i = 0; i < std::max(1u, threads); ++i)
+    {
+        mThreads.emplace_back(&MeshLoader::Worker, this);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Queue a mesh load. The mesh is not resident, and draws nothing, until
+  an Update call uploads it.
+
+\param mesh
+  The mesh to fill, it must not be touched until it is resident
+
+\param path
+  Path of the file to load
+
+\param format
+  How the vertices are encoded on the GPU
+
+\param loaded
+  Optional, called before the upload and may replace it, for example by
+  sharing an already resident mesh with the same content. Also called,
+  with nothing to upload, if the load fails.
+
+\param buildBvh
+  Also build the triangle BVH ray queries use, on the loader thread
+
+\param progressive
+  Order the vertices coarsest LOD first, so each refinement only uploads
+  the vertices its level adds
+*/
+/****************************************************************************/
+void OGL::MeshLoader::LoadAsync(Mesh& mesh, const std::string& path, VertexFormat format, Loaded loaded, bool buildBvh,
+    bool progressive)
+{
+    Job job;
+    job.mesh = &mesh;
+    job.path = path;
+    job.format = format;
+    job.loaded = std::move(loaded);
+    job.buildBvh = buildBvh;
+    job.progressive = progressive;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueued.push_back(std::move(job));
+    }
+    mWake.notify_one();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Upload loaded meshes, call once per frame on the GL thread.
+  At least one mesh is uploaded per call so progress is never stalled
+  by a single upload larger than the budget. Uploads are progressive,
+  a mesh draws its coarsest LODs from the frame it is uploaded in and
+  the time left streams finer LODs of earlier uploads.
+
+\param budgetMs
+  Time after which no further upload or refinement is started
+
+\return
+  Number of loads finished, uploaded or resolved by their callback
+*/
+/****************************************************************************/
+unsigned OGL::MeshLoader::Update(double budgetMs)
+{
+    Timer timer;
+    unsigned uploaded = 0;
+
+    for (;;)
+    {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mLoaded.empty() || (uploaded > 0 && timer.Milliseconds() >= budgetMs))
+            {
+                break;
+            }
+            job = std::move(mLoaded.front());
+            mLoaded.pop_front();
+        }
+
+        if (job.failed)
+        {
+            if (job.loaded)
+            {
+                job.loaded(*job.mesh, true);
+            }
+            continue;
+        }
+
+        if (!job.loaded || job.loaded(*job.mesh, false))
+        {
+            job.mesh->Upload(job.format, true);
+            if (job.mesh->IsRefining())
+            {
+                // the job keeps the callback, and whatever it holds on to, until the mesh is refined
+                mRefining.push_back(std::move(job));
+            }
+        }
+        ++uploaded;
+    }
+
+    // one LOD of one mesh at a time, at least one when nothing was uploaded
+    unsigned refined = 0;
+    while (!mRefining.empty() && (uploaded + refined == 0 || timer.Milliseconds() < budgetMs))
+    {
+        if (!mRefining.front().mesh->Refine())
+        {
+            DEBUG::log.Info("MeshLoader: refined", mRefining.front().path);
+            mRefining.pop_front();
+        }
+        ++refined;
+    }
+
+    if (uploaded)
+    {
+        DEBUG::log.Info("MeshLoader: uploaded", uploaded, "meshes in", timer.Milliseconds(), "ms");
+    }
+
+    return uploaded;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Block until every queued mesh is resident and refined, on the GL thread
+*/
+/****************************************************************************/
+void OGL::MeshLoader::Finish()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mDone.wait(lock, [this]() { return !mLoaded.empty() || (mQueued.empty() && mLoading == 0); });
+            if (mLoaded.empty() && mRefining.empty())
+            {
+                return;
+            }
+        }
+
+        Update(std::numeric_limits<double>::max());
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Drop every job that has not started and wait only for the loads already
+  running, on the GL thread. Nothing more is uploaded or refined, a mesh
+  that was uploaded keeps the levels it has and the jobs let go of the
+  meshes they held on to.
+*/
+/****************************************************************************/
+void OGL::MeshLoader::Cancel()
+{
+    std::deque<Job> dropped;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mQueued.clear();
+        mDone.wait(lock, [this]() { return mLoading == 0; });
+        dropped.swap(mLoaded);
+    }
+
+    // destroyed outside the lock, a callback may own the last reference to its mesh
+    dropped.clear();
+    mRefining.clear();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Number of meshes queued, loading, waiting for upload or still being
+  refined, call on the GL thread
+
+\return
+  The count, 0 once everything is resident and refined
+*/
+/****************************************************************************/
+std::size_t OGL::MeshLoader::Pending() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mQueued.size() + mLoading + mLoaded.size() + mRefining.size();
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Worker thread, runs the CPU side of queued loads
+*/
+/****************************************************************************/
+void OGL::MeshLoader::Worker()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [this]() { return mStop || !mQueued.empty(); });
+            if (mStop)
+            {
+                return;
+            }
+            job = std::move(mQueued.front());
+            mQueued.pop_front();
+            ++mLoading;
+        }
+
+        // an import error must not take the thread down, the mesh just never shows up
+        try
+        {
+            job.mesh->Load(job.path, true, job.buildBvh, job.progressive);
+        }
+        catch (const std::exception& e)
+        {
+            DEBUG::log.Error("MeshLoader: failed to load", job.path, ":", e.what());
+            job.failed = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            --mLoading;
+            mLoaded.push_back(std::move(job));
+        }
+        mDone.notify_all();
+    }
+}
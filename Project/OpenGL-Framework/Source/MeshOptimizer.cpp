@@ -0,0 +1,520 @@
+/****************************************************************************/
+/*!
+\file
+   MeshOptimizer.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Offline triangle and vertex reordering for post-transform vertex cache,
+    overdraw and vertex fetch locality.
+
+    The vertex cache pass is Tipsify (Sander, Nehab, Barczak 2007), the
+    overdraw pass splits its output into clusters and sorts them so
+    outward facing clusters are drawn first.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "MeshOptimizer.hpp"
+#include <numeric>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      FIFO post-transform cache model, a vertex is resident while fewer than
+      cacheSize misses have happened since it was last loaded
+    */
+    /****************************************************************************/
+    class CacheModel
+    {
+    public:
+        CacheModel(std::size_t vertexCount, unsigned cacheSize) :
+            mStamps(vertexCount, 0), mSize(cacheSize), mTime(cacheSize + 1) {}
+
+        //! touch a vertex, return 1 on a miss
+        unsigned Touch(GLuint vertex)
+        {
+            if (mTime - mStamps[vertex] > mSize)
+            {
+                mStamps[vertex] = mTime++;
+                return 1;
+            }
+            return 0;
+        }
+
+        //! forget everything, as if the cache had been flushed
+        void Flush()
+        {
+            mTime += mSize + 1;
+        }
+
+    private:
+        std::vector<unsigned> mStamps;
+        unsigned mSize;
+        unsigned mTime;
+    };
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Number of cache misses drawing a range of triangles from a cold cache
+    */
+    /****************************************************************************/
+    static unsigned CountMisses(const GLuint* indices, std::size_t first, std::size_t last, CacheModel& cache)
+    {
+        cache.Flush();
+        unsigned misses = 0;
+        for (std::size_t i = first; i < last; ++i)
+        {
+            misses += cache.Touch(indices[i]);
+        }
+        return misses;
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Simulate a FIFO post-transform cache over an index buffer
+
+\param indices
+  Triangle list
+
+\param indexCount
+  Number of indices
+
+\param vertexCount
+  One past the largest index
+
+\param cacheSize
+  Number of FIFO entries to model
+
+\return
+  ACMR and ATVR of the index buffer
+*/
+/****************************************************************************/
+OGL::VertexCacheStats OGL::MeshOptimizer::Analyze(const GLuint* indices, std::size_t indexCount, std::size_t vertexCount, unsigned cacheSize)
+{
+    VertexCacheStats stats;
+    if (indexCount < 3)
+    {
+        return stats;
+    }
+
+    CacheModel cache(vertexCount, cacheSize);
+    std::vector<char> used(vertexCount, 0);
+    std::size_t unique = 0;
+    unsigned misses = 0;
+
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        misses += cache.Touch(indices[i]);
+        unique += used[indices[i]] == 0;
+        used[indices[i]] = 1;
+    }
+
+    stats.acmr = float(misses) / float(indexCount / 3);
+    stats.atvr = float(misses) / float(unique);
+    return stats;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Reorder triangles for post-transform cache locality with Tipsify
+
+\param indices
+  Triangle list, reordered in place
+
+\param indexCount
+  Number of indices
+
+\param vertexCount
+  One past the largest index
+
+\param clusters
+  Receives the index offsets where the walk hit a dead end and had to jump,
+  these are hard boundaries for OptimizeOverdraw
+
+\param cacheSize
+  Number of FIFO entries to optimize for
+*/
+/****************************************************************************/
+void OGL::MeshOptimizer::OptimizeVertexCache(GLuint* indices, std::size_t indexCount, std::size_t vertexCount,
+    std::vector<std::size_t>& clusters, unsigned cacheSize)
+{
+    clusters.clear();
+    const std::size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // vertex -> triangle adjacency, and the live triangle count per vertex
+    std::vector<unsigned> live(vertexCount, 0);
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        ++live[indices[i]];
+    }
+
+    std::vector<std::size_t> offsets(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        offsets[v + 1] = offsets[v] + live[v];
+    }
+
+    std::vector<unsigned> adjacency(indexCount);
+    {
+        std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (std::size_t i = 0; i < indexCount; ++i)
+        {
+            adjacency[cursor[indices[i]]++] = unsigned(i / 3);
+        }
+    }
+
+    std::vector<unsigned> cacheTime(vertexCount, 0);
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<GLuint> deadEnd;
+    std::vector<GLuint> candidates;
+    std::vector<GLuint> output;
+    deadEnd.reserve(indexCount);
+    output.reserve(indexCount);
+
+    unsigned timestamp = cacheSize + 1;
+    std::size_t scan = 0;
+
+    // start on the first referenced vertex
+    long long fan = -1;
+    while (scan < vertexCount && live[scan] == 0)
+    {
+        ++scan;
+    }
+    fan = scan < vertexCount ? (long long)scan : -1;
+    clusters.push_back(0);
+
+    while (fan >= 0)
+    {
+        // emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (std::size_t a = offsets[fan]; a < offsets[fan + 1]; ++a)
+        {
+            unsigned t = adjacency[a];
+            if (emitted[t])
+            {
+                continue;
+            }
+
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                GLuint v = indices[t * 3 + j];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+
+                if (timestamp - cacheTime[v] > cacheSize)
+                {
+                    cacheTime[v] = timestamp++;
+                }
+            }
+            emitted[t] = 1;
+        }
+
+        // prefer a candidate that will still be in the cache once its fan is done
+        long long next = -1;
+        long long best = -1;
+        for (GLuint v : candidates)
+        {
+            if (live[v] == 0)
+            {
+                continue;
+            }
+
+            long long priority = 0;
+            if (timestamp - cacheTime[v] + 2 * live[v] <= cacheSize)
+            {
+                priority = timestamp - cacheTime[v];
+            }
+
+            if (priority > best)
+            {
+                best = priority;
+                next = v;
+            }
+        }
+
+        // dead end, back track through recent vertices then scan forward
+        if (next < 0)
+        {
+            while (!deadEnd.empty())
+            {
+                GLuint v = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[v] > 0)
+                {
+                    next = v;
+                    break;
+                }
+            }
+
+            while (next < 0 && scan < vertexCount)
+            {
+                if (live[scan] > 0)
+                {
+                    next = (long long)scan;
+                }
+                ++scan;
+            }
+
+            if (next >= 0 && output.size() != clusters.back())
+            {
+                clusters.push_back(output.size());
+            }
+        }
+
+        fan = next;
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Reorder clusters of triangles to reduce overdraw while keeping most of
+  the vertex cache efficiency. Hard clusters are split further wherever the
+  running ACMR is already close to that of the whole cluster, then clusters
+  are sorted so those facing away from the mesh centre are drawn first.
+
+\param indices
+  Triangle list from OptimizeVertexCache, reordered in place
+
+\param indexCount
+  Number of indices
+
+\param vertices
+  Vertex positions
+
+\param vertexCount
+  Number of vertices
+
+\param clusters
+  Hard cluster boundaries from OptimizeVertexCache
+
+\param threshold
+  Allowed ACMR ratio for a split, higher gives more, smaller clusters
+
+\param cacheSize
+  Number of FIFO entries to model
+*/
+/****************************************************************************/
+void OGL::MeshOptimizer::OptimizeOverdraw(GLuint* indices, std::size_t indexCount, const Vertex* vertices, std::size_t vertexCount,
+    const std::vector<std::size_t>& clusters, float threshold, unsigned cacheSize)
+{
+    if (indexCount < 3 || clusters.empty())
+    {
+        return;
+    }
+
+    // split each hard cluster into soft clusters
+    CacheModel cache(vertexCount, cacheSize);
+    std::vector<std::size_t> soft;
+    for (std::size_t c = 0; c < clusters.size(); ++c)
+    {
+        std::size_t first = clusters[c];
+        std::size_t last = c + 1 < clusters.size() ? clusters[c + 1] : indexCount;
+
+        float clusterAcmr = float(CountMisses(indices, first, last, cache)) / float((last - first) / 3);
+        float limit = clusterAcmr * threshold;
+
+        cache.Flush();
+        std::size_t start = first;
+        unsigned misses = 0;
+        soft.push_back(start);
+        for (std::size_t i = first; i < last; i += 3)
+        {
+            misses += cache.Touch(indices[i]) + cache.Touch(indices[i + 1]) + cache.Touch(indices[i + 2]);
+
+            // running ACMR is good enough, start a new cluster here
+            std::size_t end = i + 3;
+            if (end < last && float(misses) / float((end - start) / 3) <= limit)
+            {
+                start = end;
+                misses = 0;
+                cache.Flush();
+                soft.push_back(start);
+            }
+        }
+    }
+
+    // mesh centroid
+    glm::vec3 meshCentroid(0);
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        meshCentroid += glm::vec3(vertices[indices[i]].position);
+    }
+    meshCentroid /= float(indexCount);
+
+    // sort key, how much each cluster faces away from the centre
+    std::vector<float> keys(soft.size());
+    for (std::size_t c = 0; c < soft.size(); ++c)
+    {
+        std::size_t first = soft[c];
+        std::size_t last = c + 1 < soft.size() ? soft[c + 1] : indexCount;
+
+        glm::vec3 centroid(0);
+        glm::vec3 normal(0);
+        float area = 0;
+        for (std::size_t i = first; i < last; i += 3)
+        {
+            glm::vec3 p0(vertices[indices[i + 0]].position);
+            glm::vec3 p1(vertices[indices[i + 1]].position);
+            glm::vec3 p2(vertices[indices[i + 2]].position);
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float a = glm::length(n);
+
+            centroid += (p0 + p1 + p2) * (a / 3.0f);
+            normal += n;
+            area += a;
+        }
+
+        centroid = area > 0 ? centroid / area : glm::vec3(vertices[indices[first]].position);
+        float length = glm::length(normal);
+        normal = length > 0 ? normal / length : glm::vec3(0);
+
+        keys[c] = glm::dot(centroid - meshCentroid, normal);
+    }
+
+    std::vector<std::size_t> order(soft.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&keys](std::size_t a, std::size_t b) { return keys[a] > keys[b]; });
+
+    std::vector<GLuint> output;
+    output.reserve(indexCount);
+    for (std::size_t c : order)
+    {
+        std::size_t first = soft[c];
+        std::size_t last = c + 1 < soft.size() ? soft[c + 1] : indexCount;
+        output.insert(output.end(), indices + first, indices + last);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Reorder vertices into the order the index buffer first references them,
+  unreferenced vertices are kept at the end
+
+\param vertices
+  Vertex array, reordered in place
+
+\param vertexCount
+  Number of vertices
+
+\param indices
+  Triangle list, remapped in place
+
+\param indexCount
+  Number of indices
+*/
+/****************************************************************************/
+void OGL::MeshOptimizer::OptimizeVertexFetch(Vertex* vertices, std::size_t vertexCount, GLuint* indices, std::size_t indexCount)
+{
+    const GLuint unused = ~GLuint(0);
+    std::vector<GLuint> remap(vertexCount, unused);
+    GLuint next = 0;
+
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        GLuint& slot = remap[indices[i]];
+        if (slot == unused)
+        {
+            slot = next++;
+        }
+        indices[i] = slot;
+    }
+
+    for (GLuint& slot : remap)
+    {
+        if (slot == unused)
+        {
+            slot = next++;
+        }
+    }
+
+    std::vector<Vertex> copy(vertices, vertices + vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        vertices[remap[v]] = copy[v];
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Run every pass, vertex cache then overdraw then vertex fetch
+
+\param vertices
+  Vertex array, reordered in place
+
+\param vertexCount
+  Number of vertices
+
+\param indices
+  Triangle list, reordered in place
+
+\param indexCount
+  Number of indices
+
+\param before
+  Optional, receives the cache statistics of the input
+
+\param after
+  Optional, receives the cache statistics of the output
+*/
+/****************************************************************************/
+void OGL::MeshOptimizer::Optimize(Vertex* vertices, std::size_t vertexCount, GLuint* indices, std::size_t indexCount,
+    VertexCacheStats* before, VertexCacheStats* after)
+{
+    if (before)
+    {
+        *before = Analyze(indices, indexCount, vertexCount);
+    }
+
+    std::vector<std::size_t> clusters;
+    OptimizeVertexCache(indices, indexCount, vertexCount, clusters);
+    OptimizeOverdraw(indices, indexCount, vertices, vertexCount, clusters);
+    OptimizeVertexFetch(vertices, vertexCount, indices, indexCount);
+
+    if (after)
+    {
+        *after = Analyze(indices, indexCount, vertexCount);
+    }
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
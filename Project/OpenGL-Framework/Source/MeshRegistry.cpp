@@ -0,0 +1,371 @@
+/****************************************************************************/
+/*!
+\file
+   MeshRegistry.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Meshes are shared at two levels. Loading a path that is already live
+    returns the same handle straight away. Otherwise the path is loaded
+    and, on the GL thread before it is uploaded, its content key is looked
+    up, if a live mesh has the same geometry, vertex format, residency and
+    BVH setting the new copy is dropped and the existing GPU buffers are shared.
+    This catches the same model saved under several names as well as
+    repeated loads of one file.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "MeshRegistry.hpp"
+#include "Hash.hpp"
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Key meshes on everything that changes what ends up on the GPU
+    */
+    /****************************************************************************/
+    static std::uint64_t MeshKey(std::uint64_t contentKey, VertexFormat format, Residency residency, bool bvh)
+    {
+        std::uint64_t key = HashValue(contentKey);
+        key = HashValue(format.position, key);
+        key = HashValue(format.normal, key);
+        key = HashValue(residency, key);
+        return HashValue(bvh, key);
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Get the mesh
+
+\return
+  The mesh, nullptr while it is loading or if the load failed
+*/
+/****************************************************************************/
+OGL::Mesh* OGL::MeshHandle::Get() const
+{
+    return mSlot ? mSlot->mesh.get() : nullptr;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Access the mesh, only valid once IsLoaded
+*/
+/****************************************************************************/
+OGL::Mesh* OGL::MeshHandle::operator->() const
+{
+    return Get();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Access the mesh, only valid once IsLoaded
+*/
+/****************************************************************************/
+OGL::Mesh& OGL::MeshHandle::operator*() const
+{
+    return *Get();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Can the mesh be drawn
+
+\return
+  True once the mesh, or the mesh it shares, is uploaded
+*/
+/****************************************************************************/
+bool OGL::MeshHandle::IsResident() const
+{
+    Mesh* mesh = Get();
+    return mesh && mesh->IsResident();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Has the load finished
+
+\return
+  True once Get returns the mesh
+*/
+/****************************************************************************/
+bool OGL::MeshHandle::IsLoaded() const
+{
+    return Get() != nullptr;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Did the load fail, the handle then never gets a mesh
+
+\return
+  True once the loader gave up on the file
+*/
+/****************************************************************************/
+bool OGL::MeshHandle::IsFailed() const
+{
+    return mSlot && mSlot->failed;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Constructor
+
+\param loader
+  Runs the loads, must outlive every load started through the registry
+*/
+/****************************************************************************/
+OGL::MeshRegistry::MeshRegistry(MeshLoader& loader) : mLoader(loader)
+{
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get a handle to a mesh, starting a load if nothing live matches
+
+\param path
+  Path of the file to load
+
+\param format
+  How the vertices are encoded on the GPU
+
+\param residency
+  Where the mesh keeps its data once uploaded
+
+\param buildBvh
+  Build the triangle BVH ray queries use, only useful with a residency
+  that keeps the CPU side data
+
+\param progressive
+  Order the vertices for streaming, see Mesh::Load. A separate entry
+  from the same file loaded in the regular order.
+
+\return
+  The handle, it is empty until the loader's Update finishes the load
+*/
+/****************************************************************************/
+OGL::MeshHandle OGL::MeshRegistry::Load(const std::string& path, VertexFormat format, Residency residency, bool buildBvh,
+    bool progressive)
+{
+    const PathKey key = { path, format, residency, buildBvh, progressive };
+    std::weak_ptr<MeshHandle::Slot>& entry = mPaths[key];
+    if (std::shared_ptr<MeshHandle::Slot> slot = entry.lock())
+    {
+        ++mSharedLoads;
+        return MeshHandle(slot);
+    }
+
+    auto slot = std::make_shared<MeshHandle::Slot>();
+    entry = slot;
+
+    // the callback owns the mesh until it is resolved, so dropping every
+    // handle while the load is in flight is safe
+    auto mesh = std::make_shared<Mesh>();
+    mesh->SetResidency(residency);
+    std::weak_ptr<MeshHandle::Slot> weakSlot = slot;
+    mLoader.LoadAsync(*mesh, path, format, [this, weakSlot, key, mesh, format, residency](Mesh&, bool failed)
+    {
+        if (failed)
+        {
+            Fail(weakSlot, key);
+            return false;
+        }
+        return Resolve(weakSlot, mesh, format, residency);
+    }, buildBvh, progressive);
+
+    return MeshHandle(slot);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Forget meshes and paths nothing refers to anymore
+*/
+/****************************************************************************/
+void OGL::MeshRegistry::Collect()
+{
+    for (auto it = mPaths.begin(); it != mPaths.end();)
+    {
+        it = it->second.expired() ? mPaths.erase(it) : std::next(it);
+    }
+
+    for (auto it = mMeshes.begin(); it != mMeshes.end();)
+    {
+        it = it->second.expired() ? mMeshes.erase(it) : std::next(it);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Number of distinct live meshes, each holds its own GPU buffers
+
+\return
+  The count
+*/
+/****************************************************************************/
+std::size_t OGL::MeshRegistry::MeshCount() const
+{
+    return std::size_t(std::count_if(mMeshes.begin(), mMeshes.end(), [](const auto& mesh) { return !mesh.second.expired(); }));
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Number of loads that were given an existing mesh instead of a new one
+
+\return
+  The count, by path and by content
+*/
+/****************************************************************************/
+std::size_t OGL::MeshRegistry::SharedLoads() const
+{
+    return mSharedLoads;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Point a finished load's handles at a mesh, on the GL thread before the
+  upload
+
+\param slot
+  The handles' slot, may be gone if every handle was dropped
+
+\param mesh
+  The freshly loaded mesh
+
+\param format
+  Format the mesh is about to be uploaded with
+
+\param residency
+  Residency the mesh was loaded with
+
+\return
+  True if the mesh is new and must be uploaded, false if an existing
+  mesh is shared or nothing wants it
+*/
+/****************************************************************************/
+bool OGL::MeshRegistry::Resolve(const std::weak_ptr<MeshHandle::Slot>& slot, const std::shared_ptr<Mesh>& mesh,
+    VertexFormat format, Residency residency)
+{
+    std::shared_ptr<MeshHandle::Slot> target = slot.lock();
+    if (!target)
+    {
+        return false;
+    }
+
+    std::weak_ptr<Mesh>& entry = mMeshes[MeshKey(mesh->ContentKey(), format, residency, mesh->HasBvh())];
+    if (std::shared_ptr<Mesh> existing = entry.lock())
+    {
+        DEBUG::log.Info("MeshRegistry: sharing a live mesh with the same content,", mesh->CpuBytes() / 1024.0, "KB not uploaded");
+        target->mesh = existing;
+        ++mSharedLoads;
+        return false;
+    }
+
+    entry = mesh;
+    target->mesh = mesh;
+    return true;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Mark a failed load's handles and forget its path, so the next Load of
+  the path tries again instead of sharing the dead slot
+
+\param slot
+  The handles' slot, may be gone if every handle was dropped
+
+\param key
+  The path entry the load was started for
+*/
+/****************************************************************************/
+void OGL::MeshRegistry::Fail(const std::weak_ptr<MeshHandle::Slot>& slot, const PathKey& key)
+{
+    DEBUG::log.Error("MeshRegistry: no mesh for", key.path, "its handles stay empty");
+    if (std::shared_ptr<MeshHandle::Slot> target = slot.lock())
+    {
+        target->failed = true;
+    }
+
+    // a later Load of the path may already have replaced the entry
+    auto entry = mPaths.find(key);
+    if (entry != mPaths.end() && !entry->second.owner_before(slot) && !slot.owner_before(entry->second))
+    {
+        mPaths.erase(entry);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Compare two path keys
+*/
+/****************************************************************************/
+bool OGL::MeshRegistry::PathKey::operator==(const PathKey& other) const
+{
+    return path == other.path && format.position == other.format.position &&
+        format.normal == other.format.normal && residency == other.residency && buildBvh == other.buildBvh &&
+        progressive == other.progressive;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Hash a path key
+*/
+/****************************************************************************/
+std::size_t OGL::MeshRegistry::PathHash::operator()(const PathKey& key) const
+{
+    std::uint64_t hash = Hash64(key.path);
+    hash = HashValue(key.format.position, hash);
+    hash = HashValue(key.format.normal, hash);
+    hash = HashValue(key.residency, hash);
+    hash = HashValue(key.buildBvh, hash);
+    return std::size_t(HashValue(key.progressive, hash));
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Constructor, only the registry makes non-empty handles
+*/
+/****************************************************************************/
+OGL::MeshHandle::MeshHandle(std::shared_ptr<Slot> slot) : mSlot(std::move(slot))
+{
+}
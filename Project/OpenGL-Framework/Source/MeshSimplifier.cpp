@@ -0,0 +1,429 @@
+/****************************************************************************/
+/*!
+\file
+   MeshSimplifier.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Quadric error edge collapse simplification (Garland, Heckbert 1997).
+
+    Vertices only ever collapse onto other existing vertices, so every LOD
+    is just another index list over the same vertex buffer. Each pass
+    collapses the cheapest independent edges, vertices on borders, UV or
+    normal seams and non-manifold edges are never moved.
+
+    The quadrics only order the collapses, their area weighted mean hides
+    how far a single triangle moved. The reported error is the largest
+    distance of a surviving vertex to the planes of the input triangles
+    it absorbed, which is what a LOD switch can pop by.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "MeshSimplifier.hpp"
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Sum of squared distances to a set of area weighted planes
+    */
+    /****************************************************************************/
+    struct Quadric
+    {
+        double a00 = 0, a11 = 0, a22 = 0;
+        double a01 = 0, a02 = 0, a12 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double weight = 0;
+
+        //! add the plane dot(n, p) + d = 0, n must be unit length
+        void AddPlane(const glm::dvec3& n, double d, double w)
+        {
+            a00 += w * n.x * n.x; a11 += w * n.y * n.y; a22 += w * n.z * n.z;
+            a01 += w * n.x * n.y; a02 += w * n.x * n.z; a12 += w * n.y * n.z;
+            b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+            c += w * d * d;
+            weight += w;
+        }
+
+        Quadric& operator+=(const Quadric& q)
+        {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22;
+            a01 += q.a01; a02 += q.a02; a12 += q.a12;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+            weight += q.weight;
+            return *this;
+        }
+
+        //! weighted mean squared distance of p to the planes, no bound on any single plane
+        double Error(const glm::dvec3& p) const
+        {
+            double e = p.x * p.x * a00 + p.y * p.y * a11 + p.z * p.z * a22 +
+                2 * (p.x * p.y * a01 + p.x * p.z * a02 + p.y * p.z * a12) +
+                2 * (p.x * b0 + p.y * b1 + p.z * b2) + c;
+            return weight > 0 ? std::max(0.0, e / weight) : 0.0;
+        }
+    };
+
+    //! a possible collapse of one vertex onto a neighbour
+    struct Collapse
+    {
+        double cost;
+        GLuint from;
+        GLuint to;
+        GLuint wedge;   //!< the vertex of to's position the edge's triangles use, to keeps the others for its seams
+
+        bool operator<(const Collapse& other) const
+        {
+            return std::tie(cost, from, to, wedge) < std::tie(other.cost, other.from, other.to, other.wedge);
+        }
+    };
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Map every vertex to the first vertex sharing its position, so vertices
+      split by normal or UV seams are treated as one point
+    */
+    /****************************************************************************/
+    static std::vector<GLuint> PositionRemap(const Vertex* vertices, std::size_t vertexCount)
+    {
+        std::vector<GLuint> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0);
+
+        auto key = [vertices](GLuint v) { return std::make_tuple(vertices[v].position.x, vertices[v].position.y, vertices[v].position.z, v); };
+        std::sort(order.begin(), order.end(), [&key](GLuint a, GLuint b) { return key(a) < key(b); });
+
+        std::vector<GLuint> remap(vertexCount);
+        for (std::size_t i = 0; i < vertexCount; ++i)
+        {
+            bool same = i > 0 && glm::vec3(vertices[order[i]].position) == glm::vec3(vertices[order[i - 1]].position);
+            remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+        }
+
+        return remap;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Would collapsing from onto to flip or degenerate any triangle that
+      survives the collapse
+    */
+    /****************************************************************************/
+    static bool Flips(const Vertex* vertices, const std::vector<GLuint>& indices, const std::vector<GLuint>& position,
+        const GLuint* adjacency, std::size_t adjacencyCount, GLuint from, GLuint to)
+    {
+        const glm::vec3 target(vertices[to].position);
+        for (std::size_t i = 0; i < adjacencyCount; ++i)
+        {
+            const GLuint* triangle = indices.data() + adjacency[i] * 3;
+            GLuint a = position[triangle[0]];
+            GLuint b = position[triangle[1]];
+            GLuint c = position[triangle[2]];
+
+            // collapses away
+            if (a == to || b == to || c == to)
+            {
+                continue;
+            }
+
+            glm::vec3 p[3] = { glm::vec3(vertices[a].position), glm::vec3(vertices[b].position), glm::vec3(vertices[c].position) };
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+            p[a == from ? 0 : (b == from ? 1 : 2)] = target;
+            glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+            if (glm::dot(before, after) <= 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Reduce a triangle list by collapsing edges in order of quadric error
+
+\param vertices
+  The vertices the indices refer to, never modified
+
+\param vertexCount
+  One past the largest index
+
+\param indices
+  Triangle list to simplify
+
+\param indexCount
+  Number of indices
+
+\param targetIndexCount
+  Stop once the result has this many indices or fewer
+
+\param targetError
+  Skip any collapse that leaves a vertex further than this from one of
+  the input triangles it absorbed, in the same units as the positions
+
+\param result
+  The simplified triangle list, indices into the same vertices
+
+\return
+  The largest distance of a collapsed vertex to the plane of any input
+  triangle it absorbed, 0 if nothing was collapsed
+*/
+/****************************************************************************/
+float OGL::MeshSimplifier::Simplify(const Vertex* vertices, std::size_t vertexCount, const GLuint* indices, std::size_t indexCount,
+    std::size_t targetIndexCount, float targetError, std::vector<GLuint>& result)
+{
+    result.assign(indices, indices + indexCount);
+    if (indexCount <= targetIndexCount || vertexCount == 0)
+    {
+        return 0;
+    }
+
+    std::vector<GLuint> position = PositionRemap(vertices, vertexCount);
+
+    /* vertices that must stay put, tracked per position */
+    std::vector<unsigned char> locked(vertexCount, 0);
+    std::vector<unsigned> wedges(vertexCount, 0);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        if (++wedges[position[v]] > 1)
+        {
+            locked[position[v]] = 1;
+        }
+    }
+
+    // border and non-manifold edges have other than two triangles
+    std::unordered_map<std::uint64_t, unsigned> edges;
+    edges.reserve(indexCount);
+    for (std::size_t i = 0; i < indexCount; i += 3)
+    {
+        for (std::size_t e = 0; e < 3; ++e)
+        {
+            GLuint a = position[indices[i + e]];
+            GLuint b = position[indices[i + (e + 1) % 3]];
+            ++edges[(std::uint64_t(std::min(a, b)) << 32) | std::max(a, b)];
+        }
+    }
+
+    for (const auto& edge : edges)
+    {
+        if (edge.second != 2)
+        {
+            locked[GLuint(edge.first >> 32)] = 1;
+            locked[GLuint(edge.first & 0xffffffff)] = 1;
+        }
+    }
+
+    /* plane quadrics of the input triangles, and the planes each position absorbed */
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<glm::dvec4> planes;
+    planes.reserve(indexCount / 3);
+    std::vector<std::vector<GLuint>> absorbed(vertexCount);
+    for (std::size_t i = 0; i < indexCount; i += 3)
+    {
+        GLuint a = position[indices[i + 0]];
+        GLuint b = position[indices[i + 1]];
+        GLuint c = position[indices[i + 2]];
+
+        glm::dvec3 p0(vertices[a].position);
+        glm::dvec3 p1(vertices[b].position);
+        glm::dvec3 p2(vertices[c].position);
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double length = glm::length(normal);
+        if (length == 0)
+        {
+            continue;
+        }
+
+        normal /= length;
+        Quadric quadric;
+        quadric.AddPlane(normal, -glm::dot(normal, p0), length * 0.5);
+        quadrics[a] += quadric;
+        quadrics[b] += quadric;
+        quadrics[c] += quadric;
+
+        // a position lies on its own planes, they only count once it moves
+        absorbed[a].push_back(GLuint(planes.size()));
+        absorbed[b].push_back(GLuint(planes.size()));
+        absorbed[c].push_back(GLuint(planes.size()));
+        planes.emplace_back(normal, -glm::dot(normal, p0));
+    }
+
+    // largest distance of p to the planes of the given positions
+    auto distance = [&planes, &absorbed](const glm::dvec3& p, GLuint from, GLuint to)
+    {
+        double result = 0;
+        for (GLuint v : { from, to })
+        {
+            for (GLuint plane : absorbed[v])
+            {
+                result = std::max(result, std::abs(glm::dot(glm::dvec3(planes[plane]), p) + planes[plane].w));
+            }
+        }
+        return result;
+    };
+
+    /* collapse passes */
+    const double maxCost = double(targetError) * double(targetError);
+    double error = 0;
+
+    std::vector<GLuint> collapse(vertexCount);
+    std::iota(collapse.begin(), collapse.end(), 0);
+    std::vector<unsigned char> touched(vertexCount);
+    std::vector<GLuint> offsets(vertexCount + 1);
+    std::vector<GLuint> adjacency;
+    std::vector<Collapse> candidates;
+
+    while (result.size() > targetIndexCount)
+    {
+        const std::size_t triangleCount = result.size() / 3;
+
+        // triangles around each position
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (GLuint index : result)
+        {
+            ++offsets[position[index] + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        adjacency.resize(result.size());
+        std::vector<GLuint> fill(offsets.begin(), offsets.end() - 1);
+        for (std::size_t i = 0; i < result.size(); ++i)
+        {
+            adjacency[fill[position[result[i]]]++] = GLuint(i / 3);
+        }
+
+        // every directed edge is a candidate, interior edges show up once in each direction
+        candidates.clear();
+        for (std::size_t i = 0; i < result.size(); i += 3)
+        {
+            for (std::size_t e = 0; e < 3; ++e)
+            {
+                GLuint from = position[result[i + e]];
+                GLuint wedge = result[i + (e + 1) % 3];
+                GLuint to = position[wedge];
+                if (locked[from] || from == to)
+                {
+                    continue;
+                }
+
+                Quadric quadric = quadrics[from];
+                quadric += quadrics[to];
+                candidates.push_back({ quadric.Error(glm::dvec3(vertices[to].position)), from, to, wedge });
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        // each collapse removes about two triangles, only collapse independent
+        // edges so the adjacency stays valid for the whole pass
+        std::size_t limit = std::max<std::size_t>(1, (triangleCount - targetIndexCount / 3) / 2);
+        std::size_t collapses = 0;
+        std::fill(touched.begin(), touched.end(), 0);
+
+        for (const Collapse& candidate : candidates)
+        {
+            // the mean squared distance never exceeds the largest one
+            if (candidate.cost > maxCost || collapses >= limit)
+            {
+                break;
+            }
+
+            if (touched[candidate.from] || touched[candidate.to])
+            {
+                continue;
+            }
+
+            const GLuint* around = adjacency.data() + offsets[candidate.from];
+            std::size_t aroundCount = offsets[candidate.from + 1] - offsets[candidate.from];
+            if (Flips(vertices, result, position, around, aroundCount, candidate.from, candidate.to))
+            {
+                continue;
+            }
+
+            const double moved = distance(glm::dvec3(vertices[candidate.to].position), candidate.from, candidate.to);
+            if (moved > targetError)
+            {
+                continue;
+            }
+
+            // a seam position keeps one vertex per side, the fan of from
+            // lies on the side of the wedge the collapsing edge uses
+            collapse[candidate.from] = candidate.wedge;
+            quadrics[candidate.to] += quadrics[candidate.from];
+            absorbed[candidate.to].insert(absorbed[candidate.to].end(), absorbed[candidate.from].begin(), absorbed[candidate.from].end());
+            absorbed[candidate.from] = std::vector<GLuint>();
+            error = std::max(error, moved);
+            ++collapses;
+
+            touched[candidate.from] = 1;
+            touched[candidate.to] = 1;
+            for (std::size_t i = 0; i < aroundCount; ++i)
+            {
+                for (std::size_t k = 0; k < 3; ++k)
+                {
+                    touched[position[result[around[i] * 3 + k]]] = 1;
+                }
+            }
+        }
+
+        if (collapses == 0)
+        {
+            break;
+        }
+
+        // apply, an unlocked position has a single vertex so collapse can be
+        // indexed by vertex, then drop the triangles that became degenerate
+        std::size_t write = 0;
+        for (std::size_t i = 0; i < result.size(); i += 3)
+        {
+            GLuint a = collapse[result[i + 0]];
+            GLuint b = collapse[result[i + 1]];
+            GLuint c = collapse[result[i + 2]];
+            if (position[a] == position[b] || position[b] == position[c] || position[a] == position[c])
+            {
+                continue;
+            }
+
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    return float(error);
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,340 @@
+/****************************************************************************/
+/*!
+\file
+   MeshletBuilder.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Splits triangle lists into meshlets of at most MaxVertices vertices and
+    MaxTriangles triangles, each with a bounding sphere and a backface cone.
+
+    Triangles are taken greedily in index buffer order, which after the
+    vertex cache optimization is already spatially coherent. The list is
+    cut into fixed size blocks built in parallel and concatenated in order,
+    so the result is the same for any thread count.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "MeshletBuilder.hpp"
+#include "Parallel.hpp"
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! meshlets of one block, offsets relative to the block
+    struct Block
+    {
+        std::vector<OGL::Meshlet> meshlets;
+        std::vector<GLuint> vertices;
+        std::vector<std::uint8_t> triangles;
+    };
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Fill in the bounding sphere and backface cone of a finished meshlet
+    */
+    /****************************************************************************/
+    static void ComputeBounds(Meshlet& meshlet, const Vertex* vertices, const GLuint* meshletVertices,
+        const std::uint8_t* meshletTriangles)
+    {
+        // sphere around the box center, loose but cheap and stable
+        glm::vec3 min(vertices[meshletVertices[0]].position);
+        glm::vec3 max = min;
+        for (GLuint i = 1; i < meshlet.vertexCount; ++i)
+        {
+            glm::vec3 p(vertices[meshletVertices[i]].position);
+            min = glm::min(min, p);
+            max = glm::max(max, p);
+        }
+
+        meshlet.center = (min + max) * 0.5f;
+        meshlet.radius = 0;
+        for (GLuint i = 0; i < meshlet.vertexCount; ++i)
+        {
+            glm::vec3 p(vertices[meshletVertices[i]].position);
+            meshlet.radius = std::max(meshlet.radius, glm::length(p - meshlet.center));
+        }
+
+        // cone around the mean face normal
+        std::vector<glm::vec3> normals;
+        normals.reserve(meshlet.triangleCount);
+        glm::vec3 sum(0);
+        for (GLuint t = 0; t < meshlet.triangleCount; ++t)
+        {
+            const std::uint8_t* triangle = meshletTriangles + t * 3;
+            glm::vec3 p0(vertices[meshletVertices[triangle[0]]].position);
+            glm::vec3 p1(vertices[meshletVertices[triangle[1]]].position);
+            glm::vec3 p2(vertices[meshletVertices[triangle[2]]].position);
+
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(normal);
+            normals.push_back(length > 0 ? normal / length : glm::vec3(0));
+            sum += normals.back();
+        }
+
+        meshlet.coneCutoff = 2;
+        meshlet.coneApex = meshlet.center;
+        float sumLength = glm::length(sum);
+        if (sumLength == 0)
+        {
+            return;
+        }
+
+        meshlet.coneAxis = sum / sumLength;
+        float minDot = 1;
+        for (const glm::vec3& normal : normals)
+        {
+            if (normal != glm::vec3(0))
+            {
+                minDot = std::min(minDot, glm::dot(meshlet.coneAxis, normal));
+            }
+        }
+
+        // wider than a hemisphere, some triangle always faces the camera
+        if (minDot <= 0)
+        {
+            return;
+        }
+
+        // move the apex back until every triangle plane is in front of it
+        float maxT = 0;
+        for (GLuint t = 0; t < meshlet.triangleCount; ++t)
+        {
+            if (normals[t] == glm::vec3(0))
+            {
+                continue;
+            }
+
+            glm::vec3 p0(vertices[meshletVertices[meshletTriangles[t * 3]]].position);
+            float distance = glm::dot(meshlet.center - p0, normals[t]);
+            maxT = std::max(maxT, distance / glm::dot(meshlet.coneAxis, normals[t]));
+        }
+
+        meshlet.coneApex = meshlet.center - meshlet.coneAxis * maxT;
+        meshlet.coneCutoff = std::sqrt(1 - minDot * minDot);
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Greedily build the meshlets of one block of triangles
+
+    \param local
+      Scratch map from vertex to meshlet slot, all ~0u, left that way
+    */
+    /****************************************************************************/
+    static void BuildBlock(const Vertex* vertices, const GLuint* indices, std::size_t triangleCount,
+        std::vector<GLuint>& local, Block& block)
+    {
+        Meshlet meshlet;
+
+        auto flush = [&]()
+        {
+            if (meshlet.triangleCount == 0)
+            {
+                return;
+            }
+
+            ComputeBounds(meshlet, vertices, block.vertices.data() + meshlet.firstVertex,
+                block.triangles.data() + meshlet.firstTriangle * 3);
+            for (GLuint i = 0; i < meshlet.vertexCount; ++i)
+            {
+                local[block.vertices[meshlet.firstVertex + i]] = ~0u;
+            }
+
+            block.meshlets.push_back(meshlet);
+            meshlet = Meshlet();
+            meshlet.firstVertex = GLuint(block.vertices.size());
+            meshlet.firstTriangle = GLuint(block.triangles.size() / 3);
+        };
+
+        for (std::size_t t = 0; t < triangleCount; ++t)
+        {
+            const GLuint* triangle = indices + t * 3;
+
+            unsigned added = 0;
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                bool seen = local[triangle[k]] != ~0u || (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+                added += !seen;
+            }
+
+            if (meshlet.vertexCount + added > MeshletBuilder::MaxVertices || meshlet.triangleCount + 1 > MeshletBuilder::MaxTriangles)
+            {
+                flush();
+            }
+
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                GLuint& slot = local[triangle[k]];
+                if (slot == ~0u)
+                {
+                    slot = meshlet.vertexCount++;
+                    block.vertices.push_back(triangle[k]);
+                }
+                block.triangles.push_back(std::uint8_t(slot));
+            }
+            ++meshlet.triangleCount;
+        }
+
+        flush();
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Split a triangle list into meshlets
+
+\param vertices
+  The vertices the indices refer to
+
+\param vertexCount
+  One past the largest index
+
+\param indices
+  Triangle list, ideally vertex cache optimized
+
+\param indexCount
+  Number of indices
+
+\param meshlets
+  The new meshlets are appended
+
+\param meshletVertices
+  Each meshlet's vertices, as indices into vertices, are appended
+
+\param meshletTriangles
+  Each meshlet's triangles, as 3 indices into its vertices, are appended
+
+\return
+  Fill statistics of the new meshlets
+*/
+/****************************************************************************/
+OGL::MeshletStats OGL::MeshletBuilder::Build(const Vertex* vertices, std::size_t vertexCount, const GLuint* indices, std::size_t indexCount,
+    std::vector<Meshlet>& meshlets, std::vector<GLuint>& meshletVertices, std::vector<std::uint8_t>& meshletTriangles)
+{
+    MeshletStats stats;
+    std::size_t triangleCount = indexCount / 3;
+    std::size_t blockCount = (triangleCount + BlockTriangles - 1) / BlockTriangles;
+    if (blockCount == 0)
+    {
+        return stats;
+    }
+
+    std::vector<Block> blocks(blockCount);
+    ParallelFor(blockCount, 1, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        std::vector<GLuint> local(vertexCount, ~0u);
+        for (std::size_t b = begin; b < end; ++b)
+        {
+            std::size_t first = b * BlockTriangles;
+            std::size_t count = std::min(BlockTriangles, triangleCount - first);
+            BuildBlock(vertices, indices + first * 3, count, local, blocks[b]);
+        }
+    });
+
+    // concatenate in block order
+    std::size_t vertexTotal = 0;
+    std::size_t triangleTotal = 0;
+    for (const Block& block : blocks)
+    {
+        GLuint vertexOffset = GLuint(meshletVertices.size());
+        GLuint triangleOffset = GLuint(meshletTriangles.size() / 3);
+
+        for (Meshlet meshlet : block.meshlets)
+        {
+            meshlet.firstVertex += vertexOffset;
+            meshlet.firstTriangle += triangleOffset;
+            meshlets.push_back(meshlet);
+
+            vertexTotal += meshlet.vertexCount;
+            triangleTotal += meshlet.triangleCount;
+            stats.coneCount += meshlet.coneCutoff <= 1;
+            ++stats.meshletCount;
+        }
+
+        meshletVertices.insert(meshletVertices.end(), block.vertices.begin(), block.vertices.end());
+        meshletTriangles.insert(meshletTriangles.end(), block.triangles.begin(), block.triangles.end());
+    }
+
+    stats.vertexFill = float(vertexTotal) / float(stats.meshletCount * MaxVertices);
+    stats.triangleFill = float(triangleTotal) / float(stats.meshletCount * MaxTriangles);
+    return stats;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Can every triangle of a meshlet be backface culled
+
+\param meshlet
+  The meshlet to test
+
+\param eye
+  Camera position, in the same space as the vertices
+
+\return
+  True if no triangle of the meshlet faces the camera
+*/
+/****************************************************************************/
+bool OGL::MeshletBuilder::IsBackfacing(const Meshlet& meshlet, const glm::vec3& eye)
+{
+    glm::vec3 view = meshlet.coneApex - eye;
+    float length = glm::length(view);
+    return length > 0 && glm::dot(view / length, meshlet.coneAxis) >= meshlet.coneCutoff;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Is a meshlet's bounding sphere outside a frustum
+
+\param meshlet
+  The meshlet to test
+
+\param planes
+  Frustum planes, normalized and pointing inwards, in the same space as
+  the vertices
+
+\return
+  True if the meshlet can be frustum culled
+*/
+/****************************************************************************/
+bool OGL::MeshletBuilder::IsOutside(const Meshlet& meshlet, const glm::vec4 planes[6])
+{
+    for (unsigned i = 0; i < 6; ++i)
+    {
+        if (glm::dot(glm::vec3(planes[i]), meshlet.center) + planes[i].w < -meshlet.radius)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,300 @@
+/****************************************************************************/
+/*!
+\file
+   NormalGenerator.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Smooth normals weighted by the angle each face makes at the vertex
+    (Thuermer, Wuethrich 1998), so the result does not depend on how a
+    surface happens to be triangulated.
+
+    Vertices are grouped by position first, so UV and other seams the
+    importer left split are smoothed across. At every corner only faces
+    within the crease angle of the corner's own face contribute, corners
+    of one position that end up with different normals become separate
+    vertices, which is what makes the crease hard. Corners whose vertex
+    already has a normal keep it, only the missing ones are generated.
+
+    The position sort, face normals, corner angles and the per position
+    sums all run on the worker threads. Only the linear passes that number
+    the positions and bucket corners by them are serial, they keep the
+    summation order, and so the output, independent of the thread count.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "NormalGenerator.hpp"
+#include "Parallel.hpp"
+#include <numeric>
+#include <tuple>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! smallest range worth a thread
+    constexpr std::size_t MinPerThread = 1 << 15;
+
+    //! a vertex's position, sorted to find the vertices sharing one
+    struct PositionKey
+    {
+        glm::vec3 position;
+        GLuint vertex;
+    };
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Smooth normal of one corner from the faces around its position
+
+    \param corner
+      The corner, an index into the index buffer
+
+    \param around
+      Every corner sharing the position, including this one
+
+    \return
+      The unit normal, a corner of a degenerate face takes every face
+      around it, zero if none of them has an area
+    */
+    /****************************************************************************/
+    static glm::vec3 CornerNormal(GLuint corner, const GLuint* around, std::size_t aroundCount,
+        const std::vector<glm::vec3>& faceNormals, const std::vector<float>& angles, float cosCrease)
+    {
+        const glm::vec3& own = faceNormals[corner / 3];
+        glm::vec3 sum(0);
+        for (std::size_t i = 0; i < aroundCount; ++i)
+        {
+            const glm::vec3& other = faceNormals[around[i] / 3];
+            if (own == glm::vec3(0) || glm::dot(own, other) >= cosCrease)
+            {
+                sum += other * angles[around[i]];
+            }
+        }
+
+        float length = glm::length(sum);
+        return length > 0 ? sum / length : own;
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Does every vertex have a normal
+
+\param vertices
+  The vertices to check
+
+\param vertexCount
+  Number of vertices
+
+\return
+  False if any normal is zero, as the importers leave missing ones
+*/
+/****************************************************************************/
+bool OGL::NormalGenerator::HasNormals(const Vertex* vertices, std::size_t vertexCount)
+{
+    for (std::size_t i = 0; i < vertexCount; ++i)
+    {
+        if (glm::vec3(vertices[i].normal) == glm::vec3(0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Generate smooth normals for the vertices without one, normals the
+  vertices have are kept
+
+\param vertices
+  Vertices of the triangle list, a zero normal is generated
+
+\param vertexCount
+  One past the largest index
+
+\param indices
+  Triangle list
+
+\param indexCount
+  Number of indices
+
+\param creaseAngle
+  Faces meeting at a larger angle, in radians, get a hard edge, pi or
+  more smooths everything
+
+\param outVertices
+  Receives one vertex per distinct position and normal, stored as
+  Mesh::GetMesh stores them, unreferenced vertices are dropped
+
+\param outIndices
+  Receives the same triangles over outVertices
+*/
+/****************************************************************************/
+void OGL::NormalGenerator::Generate(const Vertex* vertices, std::size_t vertexCount, const GLuint* indices, std::size_t indexCount,
+    float creaseAngle, std::vector<Vertex>& outVertices, std::vector<GLuint>& outIndices)
+{
+    outVertices.clear();
+    outIndices.assign(indexCount, 0);
+    if (vertexCount == 0 || indexCount == 0)
+    {
+        return;
+    }
+
+    const std::size_t triangleCount = indexCount / 3;
+    const float cosCrease = creaseAngle >= glm::pi<float>() ? -2.0f : std::cos(creaseAngle);
+
+    /* group vertices by position */
+    // the keys are sorted by value, comparing through the indices would
+    // miss the cache on every comparison
+    std::vector<PositionKey> keys(vertexCount);
+    ParallelFor(vertexCount, MinPerThread, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        for (std::size_t v = begin; v < end; ++v)
+        {
+            keys[v] = { glm::vec3(vertices[v].position), GLuint(v) };
+        }
+    });
+    ParallelSort(keys.begin(), keys.end(), [](const PositionKey& a, const PositionKey& b)
+    {
+        return std::tie(a.position.x, a.position.y, a.position.z, a.vertex) < std::tie(b.position.x, b.position.y, b.position.z, b.vertex);
+    });
+
+    std::vector<GLuint> group(vertexCount);
+    std::vector<glm::vec3> groupPositions;
+    for (const PositionKey& key : keys)
+    {
+        if (groupPositions.empty() || key.position != groupPositions.back())
+        {
+            groupPositions.push_back(key.position);
+        }
+        group[key.vertex] = GLuint(groupPositions.size() - 1);
+    }
+    keys = std::vector<PositionKey>();
+    const std::size_t groupCount = groupPositions.size();
+
+    /* unit face normals and the angle at each corner */
+    std::vector<glm::vec3> faceNormals(triangleCount);
+    std::vector<float> angles(indexCount, 0.0f);
+    ParallelFor(triangleCount, MinPerThread, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        for (std::size_t t = begin; t < end; ++t)
+        {
+            const glm::vec3 p[3] = { groupPositions[group[indices[t * 3]]], groupPositions[group[indices[t * 3 + 1]]],
+                groupPositions[group[indices[t * 3 + 2]]] };
+
+            glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+            float length = glm::length(normal);
+            faceNormals[t] = length > 0 ? normal / length : glm::vec3(0);
+            if (length == 0)
+            {
+                continue;
+            }
+
+            // edge k runs from corner k to the next, a triangle with area has no zero length edge
+            const glm::vec3 e[3] = { glm::normalize(p[1] - p[0]), glm::normalize(p[2] - p[1]), glm::normalize(p[0] - p[2]) };
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                angles[t * 3 + k] = std::acos(glm::clamp(-glm::dot(e[k], e[(k + 2) % 3]), -1.0f, 1.0f));
+            }
+        }
+    });
+
+    /* corners around each position, in corner order */
+    std::vector<GLuint> offsets(groupCount + 1, 0);
+    for (std::size_t c = 0; c < indexCount; ++c)
+    {
+        ++offsets[group[indices[c]] + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<GLuint> around(indexCount);
+    {
+        std::vector<GLuint> fill(offsets.begin(), offsets.end() - 1);
+        for (std::size_t c = 0; c < indexCount; ++c)
+        {
+            around[fill[group[indices[c]]]++] = GLuint(c);
+        }
+    }
+
+    /* number the distinct normals of each position, indices are local for now */
+    std::vector<GLuint> firstVertex(groupCount + 1, 0);
+    ParallelFor(groupCount, MinPerThread, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        std::vector<glm::vec3> distinct;
+        for (std::size_t g = begin; g < end; ++g)
+        {
+            distinct.clear();
+            const GLuint* corners = around.data() + offsets[g];
+            const std::size_t cornerCount = offsets[g + 1] - offsets[g];
+            for (std::size_t i = 0; i < cornerCount; ++i)
+            {
+                const glm::vec3 authored(vertices[indices[corners[i]]].normal);
+                glm::vec3 normal = authored != glm::vec3(0) ? authored :
+                    CornerNormal(corners[i], corners, cornerCount, faceNormals, angles, cosCrease);
+                std::size_t local = std::find(distinct.begin(), distinct.end(), normal) - distinct.begin();
+                if (local == distinct.size())
+                {
+                    distinct.push_back(normal);
+                }
+                outIndices[corners[i]] = GLuint(local);
+            }
+            firstVertex[g + 1] = GLuint(distinct.size());
+        }
+    });
+    std::partial_sum(firstVertex.begin(), firstVertex.end(), firstVertex.begin());
+
+    /* write the vertices, each from the first corner that uses it */
+    outVertices.resize(firstVertex[groupCount]);
+    ParallelFor(groupCount, MinPerThread, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        for (std::size_t g = begin; g < end; ++g)
+        {
+            const GLuint* corners = around.data() + offsets[g];
+            const std::size_t cornerCount = offsets[g + 1] - offsets[g];
+            GLuint written = 0;
+            for (std::size_t i = 0; i < cornerCount; ++i)
+            {
+                GLuint local = outIndices[corners[i]];
+                if (local == written)
+                {
+                    const glm::vec3 authored(vertices[indices[corners[i]]].normal);
+                    glm::vec3 normal = authored != glm::vec3(0) ? authored :
+                        CornerNormal(corners[i], corners, cornerCount, faceNormals, angles, cosCrease);
+                    Vertex& vertex = outVertices[firstVertex[g] + local];
+                    vertex.position = glm::vec4(groupPositions[g], 1);
+                    vertex.normal = normal != glm::vec3(0) ? glm::vec4(glm::normalize(normal), 0) : glm::vec4(0);
+                    ++written;
+                }
+                outIndices[corners[i]] = firstVertex[g] + local;
+            }
+        }
+    });
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,881 @@
+/****************************************************************************/
+/*!
+\file
+   ObjLoader.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Multi-threaded, memory mapped Wavefront OBJ loader.
+
+    The mapped file is split into line aligned chunks that are parsed in
+    parallel. Face corners are then welded on their (position, normal)
+    index pair through a lock free hash table, vertices are numbered in
+    order of first use so the output does not depend on thread timing.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "ObjLoader.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! marks a corner without a normal
+    constexpr std::uint32_t NoNormal = ~std::uint32_t(0);
+
+    //! empty slot in the weld table
+    constexpr std::uint64_t EmptyKey = ~std::uint64_t(0);
+
+    //! a face corner, 0 based indices into the file's v and vn lists
+    struct Corner
+    {
+        std::uint32_t position;
+        std::uint32_t normal;
+    };
+
+    //! a negative (relative) index, resolved once every chunk is parsed
+    struct Fixup
+    {
+        std::size_t corner;
+        std::int64_t position;      //!< relative to the start of the chunk
+        std::int64_t normal;        //!< relative to the start of the chunk, or NoNormal
+        bool relativePosition;
+        bool relativeNormal;
+    };
+
+    //! everything parsed out of one line aligned chunk
+    struct Chunk
+    {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<Corner> corners;        //!< 3 per triangle
+        std::vector<Fixup> fixups;
+        std::vector<std::size_t> groups;    //!< corner offsets where o / g / usemtl start a submesh
+        bool error = false;                 //!< a v, vn or f line was malformed
+    };
+
+    //! powers of ten exactly representable as doubles
+    const double Pow10[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Skip spaces and tabs
+    */
+    /****************************************************************************/
+    static const char* SkipBlank(const char* p, const char* end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t'))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Skip past the end of the current line
+    */
+    /****************************************************************************/
+    static const char* SkipLine(const char* p, const char* end)
+    {
+        while (p < end && *p != '\n')
+        {
+            ++p;
+        }
+        return p < end ? p + 1 : end;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Is the character after a keyword whitespace
+    */
+    /****************************************************************************/
+    static bool IsSeparator(const char* p, const char* end)
+    {
+        return p < end && (*p == ' ' || *p == '\t');
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Parse a decimal float without locale or allocation, falls back to
+      strtod for anything unusual (nan, inf, hex)
+
+    \return
+      One past the last character consumed, p if nothing was parsed
+    */
+    /****************************************************************************/
+    static const char* ParseFloat(const char* p, const char* end, float& out)
+    {
+        p = SkipBlank(p, end);
+        const char* start = p;
+
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p++ == '-';
+        }
+
+        std::uint64_t mantissa = 0;
+        int exponent = 0;
+        int digits = 0;
+
+        for (; p < end && unsigned(*p - '0') < 10; ++p, ++digits)
+        {
+            if (mantissa < 1000000000000000000ull)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+            }
+            else
+            {
+                ++exponent;
+            }
+        }
+
+        if (p < end && *p == '.')
+        {
+            for (++p; p < end && unsigned(*p - '0') < 10; ++p, ++digits)
+            {
+                if (mantissa < 1000000000000000000ull)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    --exponent;
+                }
+            }
+        }
+
+        if (digits == 0)
+        {
+            // let the C library deal with the odd cases, it needs a terminator
+            char buffer[64];
+            std::size_t length = std::min<std::size_t>(sizeof(buffer) - 1, std::size_t(end - start));
+            std::memcpy(buffer, start, length);
+            buffer[length] = 0;
+
+            char* stop = nullptr;
+            out = std::strtof(buffer, &stop);
+            return start + (stop - buffer);
+        }
+
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char* e = p + 1;
+            bool negativeExponent = false;
+            if (e < end && (*e == '-' || *e == '+'))
+            {
+                negativeExponent = *e++ == '-';
+            }
+
+            int value = 0;
+            const char* firstDigit = e;
+            for (; e < end && unsigned(*e - '0') < 10; ++e)
+            {
+                value = std::min(value * 10 + (*e - '0'), 10000);
+            }
+
+            if (e != firstDigit)
+            {
+                exponent += negativeExponent ? -value : value;
+                p = e;
+            }
+        }
+
+        double value = double(mantissa);
+        if (exponent < 0)
+        {
+            value = -exponent <= 22 ? value / Pow10[-exponent] : value * std::pow(10.0, exponent);
+        }
+        else if (exponent > 0)
+        {
+            value = exponent <= 22 ? value * Pow10[exponent] : value * std::pow(10.0, exponent);
+        }
+
+        out = float(negative ? -value : value);
+        return p;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Parse the x, y and z of a v or vn line, anything after them is ignored
+
+    \return
+      False if any of the three is missing
+    */
+    /****************************************************************************/
+    static bool ParseVector(const char* p, const char* end, glm::vec3& out)
+    {
+        for (glm::vec3::length_type k = 0; k < 3; ++k)
+        {
+            p = SkipBlank(p, end);
+            const char* next = ParseFloat(p, end, out[k]);
+            if (next == p)
+            {
+                return false;
+            }
+            p = next;
+        }
+        return true;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Parse a signed decimal integer
+
+    \return
+      One past the last character consumed, p if nothing was parsed
+    */
+    /****************************************************************************/
+    static const char* ParseInt(const char* p, const char* end, std::int64_t& out)
+    {
+        const char* start = p;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p++ == '-';
+        }
+
+        const char* digits = p;
+        std::int64_t value = 0;
+        for (; p < end && unsigned(*p - '0') < 10; ++p)
+        {
+            value = value * 10 + (*p - '0');
+        }
+
+        if (p == digits)
+        {
+            return start;
+        }
+
+        out = negative ? -value : value;
+        return p;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Parse one face corner, v, v/vt, v//vn or v/vt/vn
+
+    \return
+      One past the corner, p if there is no corner
+    */
+    /****************************************************************************/
+    static const char* ParseCorner(const char* p, const char* end, std::int64_t& position, std::int64_t& normal)
+    {
+        p = SkipBlank(p, end);
+        const char* next = ParseInt(p, end, position);
+        if (next == p)
+        {
+            return p;
+        }
+        p = next;
+        normal = 0;
+
+        // texture coordinate, unused
+        if (p < end && *p == '/')
+        {
+            std::int64_t unused;
+            p = ParseInt(p + 1, end, unused);
+        }
+
+        // normal
+        if (p < end && *p == '/')
+        {
+            p = ParseInt(p + 1, end, normal);
+        }
+
+        // skip anything else glued to the corner
+        while (p < end && !std::isspace(static_cast<unsigned char>(*p)))
+        {
+            ++p;
+        }
+
+        return p;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Parse every line of one chunk
+    */
+    /****************************************************************************/
+    static void ParseChunk(Chunk& chunk)
+    {
+        const char* p = chunk.begin;
+        const char* end = chunk.end;
+
+        // rough reservation, a typical OBJ line is 20 - 40 bytes
+        std::size_t estimate = std::size_t(end - p) / 32;
+        chunk.positions.reserve(estimate / 2);
+        chunk.corners.reserve(estimate * 3);
+
+        std::vector<Corner> face;
+        std::vector<Fixup> faceFixups;
+
+        while (p < end)
+        {
+            p = SkipBlank(p, end);
+            if (p >= end)
+            {
+                break;
+            }
+
+            const char c = *p;
+            if (c == 'v' && IsSeparator(p + 1, end))
+            {
+                glm::vec3 v(0);
+                chunk.error = !ParseVector(p + 1, end, v) || chunk.error;
+                chunk.positions.push_back(v);
+            }
+            else if (c == 'v' && p + 1 < end && p[1] == 'n' && IsSeparator(p + 2, end))
+            {
+                glm::vec3 n(0);
+                chunk.error = !ParseVector(p + 2, end, n) || chunk.error;
+                chunk.normals.push_back(n);
+            }
+            else if (c == 'f' && IsSeparator(p + 1, end))
+            {
+                face.clear();
+                faceFixups.clear();
+
+                const char* q = p + 1;
+                for (;;)
+                {
+                    std::int64_t position = 0;
+                    std::int64_t normal = 0;
+                    const char* next = ParseCorner(q, end, position, normal);
+                    if (next == q || position == 0)
+                    {
+                        break;
+                    }
+                    q = next;
+
+                    // positive indices are absolute, negative ones are relative to
+                    // what has been read so far and need the chunk's global offset
+                    Corner corner;
+                    Fixup fixup = { face.size(), 0, 0, false, false };
+                    if (position > 0)
+                    {
+                        corner.position = std::uint32_t(position - 1);
+                    }
+                    else
+                    {
+                        corner.position = 0;
+                        fixup.position = std::int64_t(chunk.positions.size()) + position;
+                        fixup.relativePosition = true;
+                    }
+
+                    if (normal > 0)
+                    {
+                        corner.normal = std::uint32_t(normal - 1);
+                    }
+                    else if (normal < 0)
+                    {
+                        corner.normal = 0;
+                        fixup.normal = std::int64_t(chunk.normals.size()) + normal;
+                        fixup.relativeNormal = true;
+                    }
+                    else
+                    {
+                        corner.normal = NoNormal;
+                    }
+
+                    if (fixup.relativePosition || fixup.relativeNormal)
+                    {
+                        faceFixups.push_back(fixup);
+                    }
+                    face.push_back(corner);
+                }
+
+                // fewer than 3 corners, or a corner that did not parse before the end of the line
+                const char* rest = SkipBlank(q, end);
+                if (face.size() < 3 || (rest < end && *rest != '\n' && *rest != '\r' && *rest != '#'))
+                {
+                    chunk.error = true;
+                }
+
+                // triangle fan, same as aiProcess_Triangulate for convex polygons
+                for (std::size_t i = 2; i < face.size(); ++i)
+                {
+                    const std::size_t fan[3] = { 0, i - 1, i };
+                    for (std::size_t k : fan)
+                    {
+                        for (const Fixup& fixup : faceFixups)
+                        {
+                            if (fixup.corner == k)
+                            {
+                                Fixup global = fixup;
+                                global.corner = chunk.corners.size();
+                                chunk.fixups.push_back(global);
+                            }
+                        }
+                        chunk.corners.push_back(face[k]);
+                    }
+                }
+            }
+            else if (((c == 'o' || c == 'g') && IsSeparator(p + 1, end)) ||
+                (end - p > 6 && std::strncmp(p, "usemtl", 6) == 0 && IsSeparator(p + 6, end)))
+            {
+                chunk.groups.push_back(chunk.corners.size());
+            }
+
+            p = SkipLine(p, end);
+        }
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Spread the bits of a weld key over the table
+    */
+    /****************************************************************************/
+    static std::uint64_t MixKey(std::uint64_t key)
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Open addressing hash table from a corner's (position, normal) pair to
+      the first corner that used it, safe for concurrent inserts
+    */
+    /****************************************************************************/
+    class WeldTable
+    {
+    public:
+        //! count is an upper bound on the number of distinct keys
+        explicit WeldTable(std::size_t count)
+        {
+            std::size_t capacity = 1;
+            while (capacity < count * 2)
+            {
+                capacity <<= 1;
+            }
+            mMask = capacity - 1;
+            mSlots.reset(new Slot[capacity]);
+
+            ParallelFor(capacity, 1 << 16, [this](std::size_t begin, std::size_t end, unsigned)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    mSlots[i].key.store(EmptyKey, std::memory_order_relaxed);
+                    mSlots[i].first.store(~std::uint32_t(0), std::memory_order_relaxed);
+                }
+            });
+        }
+
+        //! find or claim the slot for key, keeping the smallest corner seen
+        std::uint32_t Insert(std::uint64_t key, std::uint32_t corner)
+        {
+            std::size_t index = std::size_t(MixKey(key)) & mMask;
+            for (;;)
+            {
+                Slot& slot = mSlots[index];
+                std::uint64_t current = slot.key.load(std::memory_order_relaxed);
+                if (current == EmptyKey &&
+                    slot.key.compare_exchange_strong(current, key, std::memory_order_relaxed))
+                {
+                    current = key;
+                }
+
+                if (current == key)
+                {
+                    std::uint32_t first = slot.first.load(std::memory_order_relaxed);
+                    while (corner < first &&
+                        !slot.first.compare_exchange_weak(first, corner, std::memory_order_relaxed))
+                    {
+                    }
+                    return std::uint32_t(index);
+                }
+
+                index = (index + 1) & mMask;
+            }
+        }
+
+        std::uint32_t First(std::uint32_t slot) const
+        {
+            return mSlots[slot].first.load(std::memory_order_relaxed);
+        }
+
+        std::uint32_t& Id(std::uint32_t slot)
+        {
+            return mSlots[slot].id;
+        }
+
+    private:
+        //! key, first corner and vertex id share a cache line
+        struct Slot
+        {
+            std::atomic<std::uint64_t> key;
+            std::atomic<std::uint32_t> first;
+            std::uint32_t id;
+        };
+
+        std::unique_ptr<Slot[]> mSlots;
+        std::size_t mMask = 0;
+    };
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Should a file go through this loader
+
+\param path
+  Path of the model
+
+\return
+  True for a .obj extension, in any case
+*/
+/****************************************************************************/
+bool OGL::ObjLoader::IsObj(const std::string& path)
+{
+    if (path.size() < 4)
+    {
+        return false;
+    }
+
+    std::string extension = path.substr(path.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](char c) { return char(std::tolower(static_cast<unsigned char>(c))); });
+    return extension == ".obj";
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Load an OBJ file
+
+\param path
+  Path of the model
+
+\param vertices
+  Receives the welded vertices, normals as Mesh::GetMesh stores them,
+  corners without one get a zero normal for Mesh to generate
+
+\param indices
+  Receives the triangle list, relative to each submesh's base vertex
+
+\param subMeshes
+  Receives one submesh per o / g / usemtl section that has faces
+
+\return
+  False if the file can not be read, has a malformed v, vn or f line or
+  references missing data, the outputs are then left empty
+*/
+/****************************************************************************/
+bool OGL::ObjLoader::Load(const std::string& path, std::vector<Vertex>& vertices,
+    std::vector<GLuint>& indices, std::vector<SubMesh>& subMeshes)
+{
+    vertices.clear();
+    indices.clear();
+    subMeshes.clear();
+
+    MappedFile file(path);
+    if (!file.IsOpen())
+    {
+        return false;
+    }
+
+    const char* data = file.Data();
+    const char* end = data + file.Size();
+
+    /* split into line aligned chunks */
+    std::size_t chunkCount = ParallelRanges(file.Size(), MinChunkSize);
+    std::vector<Chunk> chunks(chunkCount);
+    const char* cursor = data;
+    for (std::size_t i = 0; i < chunkCount; ++i)
+    {
+        const char* split = i + 1 == chunkCount ? end : std::max(cursor, data + file.Size() * (i + 1) / chunkCount);
+        while (split < end && split[-1] != '\n')
+        {
+            ++split;
+        }
+        chunks[i].begin = cursor;
+        chunks[i].end = split;
+        cursor = split;
+    }
+
+    /* parse */
+    ParallelFor(chunkCount, 1, [&chunks](std::size_t begin, std::size_t last, unsigned)
+    {
+        for (std::size_t i = begin; i < last; ++i)
+        {
+            ParseChunk(chunks[i]);
+        }
+    });
+
+    for (const Chunk& chunk : chunks)
+    {
+        if (chunk.error)
+        {
+            DEBUG::log.Error("ObjLoader: malformed line in", path);
+            return false;
+        }
+    }
+
+    /* offsets of each chunk in the concatenated arrays */
+    std::vector<std::size_t> positionStart(chunkCount + 1, 0);
+    std::vector<std::size_t> normalStart(chunkCount + 1, 0);
+    std::vector<std::size_t> cornerStart(chunkCount + 1, 0);
+    for (std::size_t i = 0; i < chunkCount; ++i)
+    {
+        positionStart[i + 1] = positionStart[i] + chunks[i].positions.size();
+        normalStart[i + 1] = normalStart[i] + chunks[i].normals.size();
+        cornerStart[i + 1] = cornerStart[i] + chunks[i].corners.size();
+    }
+
+    const std::size_t positionCount = positionStart[chunkCount];
+    const std::size_t normalCount = normalStart[chunkCount];
+    const std::size_t cornerCount = cornerStart[chunkCount];
+    if (cornerCount == 0 || cornerCount > std::size_t(~std::uint32_t(0) >> 1))
+    {
+        return false;
+    }
+
+    /* resolve relative indices, concatenate and validate */
+    std::vector<glm::vec3> positions(positionCount);
+    std::vector<glm::vec3> normals(normalCount);
+    std::vector<Corner> corners(cornerCount);
+    std::atomic<bool> invalid(false);
+
+    ParallelFor(chunkCount, 1, [&](std::size_t begin, std::size_t last, unsigned)
+    {
+        for (std::size_t i = begin; i < last; ++i)
+        {
+            Chunk& chunk = chunks[i];
+            for (const Fixup& fixup : chunk.fixups)
+            {
+                Corner& corner = chunk.corners[fixup.corner];
+                if (fixup.relativePosition)
+                {
+                    corner.position = std::uint32_t(std::int64_t(positionStart[i]) + fixup.position);
+                }
+                if (fixup.relativeNormal)
+                {
+                    corner.normal = std::uint32_t(std::int64_t(normalStart[i]) + fixup.normal);
+                }
+            }
+
+            for (const Corner& corner : chunk.corners)
+            {
+                if (corner.position >= positionCount || (corner.normal != NoNormal && corner.normal >= normalCount))
+                {
+                    invalid = true;
+                    break;
+                }
+            }
+
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + positionStart[i]);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + normalStart[i]);
+            std::copy(chunk.corners.begin(), chunk.corners.end(), corners.begin() + cornerStart[i]);
+
+            chunk.positions = std::vector<glm::vec3>();
+            chunk.normals = std::vector<glm::vec3>();
+            chunk.corners = std::vector<Corner>();
+        }
+    });
+
+    if (invalid)
+    {
+        DEBUG::log.Error("ObjLoader: index out of range in", path);
+        return false;
+    }
+
+    /* submesh boundaries, in corners */
+    std::vector<std::size_t> groups(1, 0);
+    for (std::size_t i = 0; i < chunkCount; ++i)
+    {
+        for (std::size_t group : chunks[i].groups)
+        {
+            std::size_t start = cornerStart[i] + group;
+            if (start > groups.back() && start < cornerCount)
+            {
+                groups.push_back(start);
+            }
+        }
+    }
+    groups.push_back(cornerCount);
+
+    /* weld corners on (position, normal) */
+    // a key is a (position, normal) pair, there can be no more keys than
+    // pairs, which keeps the table small when normals are shared
+    std::size_t keyBound = std::size_t(std::min<std::uint64_t>(cornerCount, std::uint64_t(positionCount) * (normalCount + 1)));
+    WeldTable table(keyBound);
+    std::vector<std::uint32_t> slots(cornerCount);
+    ParallelFor(cornerCount, 1 << 16, [&](std::size_t begin, std::size_t last, unsigned)
+    {
+        for (std::size_t c = begin; c < last; ++c)
+        {
+            std::uint64_t key = (std::uint64_t(corners[c].position) << 32) | corners[c].normal;
+            slots[c] = table.Insert(key, std::uint32_t(c));
+        }
+    });
+
+    // number vertices in order of first use, per range then prefix summed
+    unsigned ranges = ParallelRanges(cornerCount, 1 << 16);
+    std::vector<std::size_t> firstCounts(ranges + 1, 0);
+    ParallelFor(cornerCount, 1 << 16, [&](std::size_t begin, std::size_t last, unsigned range)
+    {
+        std::size_t count = 0;
+        for (std::size_t c = begin; c < last; ++c)
+        {
+            count += table.First(slots[c]) == c;
+        }
+        firstCounts[range + 1] = count;
+    });
+
+    for (unsigned r = 0; r < ranges; ++r)
+    {
+        firstCounts[r + 1] += firstCounts[r];
+    }
+
+    std::vector<Corner> unique(firstCounts[ranges]);
+    ParallelFor(cornerCount, 1 << 16, [&](std::size_t begin, std::size_t last, unsigned range)
+    {
+        std::uint32_t id = std::uint32_t(firstCounts[range]);
+        for (std::size_t c = begin; c < last; ++c)
+        {
+            if (table.First(slots[c]) == c)
+            {
+                unique[id] = corners[c];
+                table.Id(slots[c]) = id++;
+            }
+        }
+    });
+
+    std::vector<GLuint> welded(cornerCount);
+    ParallelFor(cornerCount, 1 << 16, [&](std::size_t begin, std::size_t last, unsigned)
+    {
+        for (std::size_t c = begin; c < last; ++c)
+        {
+            welded[c] = table.Id(slots[c]);
+        }
+    });
+
+    /* build the vertices */
+    std::vector<Vertex> allVertices(unique.size());
+    ParallelFor(unique.size(), 1 << 16, [&](std::size_t begin, std::size_t last, unsigned)
+    {
+        for (std::size_t v = begin; v < last; ++v)
+        {
+            const Corner& corner = unique[v];
+            glm::vec3 n = corner.normal != NoNormal ? normals[corner.normal] : glm::vec3(0);
+
+            Vertex& vertex = allVertices[v];
+            vertex.position = glm::vec4(positions[corner.position], 1);
+            vertex.normal = glm::length(n) > 0 ? glm::vec4(glm::normalize(n), 0) : glm::vec4(0);
+        }
+    });
+
+    /* a single group can be used directly */
+    if (groups.size() == 2)
+    {
+        SubMesh subMesh;
+        subMesh.indexCount = GLuint(cornerCount);
+        subMesh.vertexCount = GLuint(allVertices.size());
+        MeshBounds::Compute(allVertices.data(), allVertices.size(), subMesh.bounds, subMesh.sphere);
+
+        vertices = std::move(allVertices);
+        indices = std::move(welded);
+        subMeshes.push_back(subMesh);
+        return true;
+    }
+
+    /* otherwise give every group its own contiguous vertex range */
+    std::size_t groupCount = groups.size() - 1;
+    std::vector<std::vector<GLuint>> groupVertices(groupCount);
+    ParallelFor(groupCount, 1, [&](std::size_t begin, std::size_t last, unsigned)
+    {
+        std::unordered_map<GLuint, GLuint> local;
+        for (std::size_t g = begin; g < last; ++g)
+        {
+            local.clear();
+            for (std::size_t c = groups[g]; c < groups[g + 1]; ++c)
+            {
+                auto inserted = local.emplace(welded[c], GLuint(groupVertices[g].size()));
+                if (inserted.second)
+                {
+                    groupVertices[g].push_back(welded[c]);
+                }
+                welded[c] = inserted.first->second;
+            }
+        }
+    });
+
+    subMeshes.resize(groupCount);
+    std::size_t vertexTotal = 0;
+    for (std::size_t g = 0; g < groupCount; ++g)
+    {
+        subMeshes[g].firstIndex = GLuint(groups[g]);
+        subMeshes[g].indexCount = GLuint(groups[g + 1] - groups[g]);
+        subMeshes[g].baseVertex = GLint(vertexTotal);
+        subMeshes[g].vertexCount = GLuint(groupVertices[g].size());
+        vertexTotal += groupVertices[g].size();
+    }
+
+    vertices.resize(vertexTotal);
+    ParallelFor(groupCount, 1, [&](std::size_t begin, std::size_t last, unsigned)
+    {
+        for (std::size_t g = begin; g < last; ++g)
+        {
+            SubMesh& subMesh = subMeshes[g];
+            for (std::size_t v = 0; v < groupVertices[g].size(); ++v)
+            {
+                vertices[subMesh.baseVertex + v] = allVertices[groupVertices[g][v]];
+            }
+            MeshBounds::Compute(vertices.data() + subMesh.baseVertex, subMesh.vertexCount, subMesh.bounds, subMesh.sphere);
+        }
+    });
+
+    indices = std::move(welded);
+    return true;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
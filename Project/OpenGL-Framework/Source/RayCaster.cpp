@@ -0,0 +1,601 @@
+/****************************************************************************/
+/*!
+\file
+   RayCaster.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Ray queries through the triangle BVH of each submesh, Moeller-Trumbore
+    triangle tests, both faces of a triangle count.
+
+    Single rays walk the BVH on their own. Batches are traced in packets
+    of 4 rays with SSE2, a node is entered when any ray of the packet hits
+    it, which pays off for the coherent rays of a screen or a bake. The
+    packets are spread over the worker threads.
+
+    The queries only read the mesh, any number may run at once as long as
+    nothing loads or releases the mesh meanwhile. Meshes loaded without a
+    BVH fall back to testing every triangle, meshes whose CPU side data
+    was released after upload can not be queried.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "RayCaster.hpp"
+#include "Parallel.hpp"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OGL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! determinant below which a ray counts as parallel to a triangle
+    constexpr float ParallelEpsilon = 1e-12f;
+
+#ifdef OGL_SSE2
+    //! 4 rays, one per lane
+    struct Packet
+    {
+        __m128 origin[3];
+        __m128 direction[3];
+        __m128 inverse[3];
+        __m128 tMin;
+        __m128 tMax;        //!< shrinks to the closest hit of each ray
+    };
+#endif
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Positions of a submesh triangle
+    */
+    /****************************************************************************/
+    static void TrianglePositions(const MeshData& data, const SubMesh& subMesh, GLuint triangle, glm::vec3 positions[3])
+    {
+        const GLuint* indices = data.indices.data() + subMesh.firstIndex + std::size_t(triangle) * 3;
+        const Vertex* vertices = data.vertices.data() + subMesh.baseVertex;
+        for (unsigned k = 0; k < 3; ++k)
+        {
+            positions[k] = glm::vec3(vertices[indices[k]].position);
+        }
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Intersect one ray with one triangle
+
+    \return
+      True for a hit between tMin and tMax, t, u and v are then set
+    */
+    /****************************************************************************/
+    static bool HitTriangle(const glm::vec3 positions[3], const Ray& ray, float tMin, float tMax, float& t, float& u, float& v)
+    {
+        glm::vec3 e1 = positions[1] - positions[0];
+        glm::vec3 e2 = positions[2] - positions[0];
+        glm::vec3 p = glm::cross(ray.direction, e2);
+        float determinant = glm::dot(e1, p);
+        if (std::abs(determinant) < ParallelEpsilon)
+        {
+            return false;
+        }
+
+        float inverse = 1.0f / determinant;
+        glm::vec3 s = ray.origin - positions[0];
+        u = glm::dot(s, p) * inverse;
+        glm::vec3 q = glm::cross(s, e1);
+        v = glm::dot(ray.direction, q) * inverse;
+        t = glm::dot(e2, q) * inverse;
+        return u >= 0 && v >= 0 && u + v <= 1 && t >= tMin && t < tMax;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Does a ray pass through a node's box within [tMin, tMax]
+    */
+    /****************************************************************************/
+    static bool HitBox(const BvhNode& node, const glm::vec3& origin, const glm::vec3& inverse, float tMin, float tMax)
+    {
+        glm::vec3 t1 = (node.min - origin) * inverse;
+        glm::vec3 t2 = (node.max - origin) * inverse;
+        glm::vec3 entry = glm::min(t1, t2);
+        glm::vec3 exit = glm::max(t1, t2);
+        float tNear = std::max(std::max(entry.x, entry.y), std::max(entry.z, tMin));
+        float tFar = std::min(std::min(exit.x, exit.y), std::min(exit.z, tMax));
+        return tNear <= tFar;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Children of an interior node, the one nearer along direction first
+    */
+    /****************************************************************************/
+    static void OrderChildren(const std::vector<BvhNode>& nodes, GLuint index, const glm::vec3& direction, GLuint& first, GLuint& second)
+    {
+        first = index + 1;
+        second = nodes[index].first;
+        glm::vec3 firstCenter = nodes[first].min + nodes[first].max;
+        glm::vec3 secondCenter = nodes[second].min + nodes[second].max;
+        if (glm::dot(firstCenter - secondCenter, direction) > 0)
+        {
+            std::swap(first, second);
+        }
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Trace one ray through the BVH of one submesh
+
+    \param stack
+      Scratch space, reused between calls
+    */
+    /****************************************************************************/
+    static bool TraceRay(const Mesh& mesh, GLuint subIndex, const Ray& ray, RayHit& hit, std::vector<GLuint>& stack)
+    {
+        const MeshData& data = mesh.Data();
+        const SubMesh& subMesh = data.subMeshes[subIndex];
+        const glm::vec3 inverse = 1.0f / ray.direction;
+
+        bool found = false;
+        stack.clear();
+        stack.push_back(subMesh.firstBvhNode);
+        while (!stack.empty())
+        {
+            GLuint index = stack.back();
+            stack.pop_back();
+
+            const BvhNode& node = data.bvhNodes[index];
+            float tMax = std::min(ray.tMax, hit.t);
+            if (!HitBox(node, ray.origin, inverse, ray.tMin, tMax))
+            {
+                continue;
+            }
+
+            if (node.count == 0)
+            {
+                GLuint first;
+                GLuint second;
+                OrderChildren(data.bvhNodes, index, ray.direction, first, second);
+                stack.push_back(second);
+                stack.push_back(first);
+                continue;
+            }
+
+            for (GLuint i = node.first; i < node.first + node.count; ++i)
+            {
+                glm::vec3 positions[3];
+                GLuint triangle = data.bvhTriangles[i];
+                TrianglePositions(data, subMesh, triangle, positions);
+
+                float t, u, v;
+                if (HitTriangle(positions, ray, ray.tMin, std::min(ray.tMax, hit.t), t, u, v))
+                {
+                    hit = { &mesh, subIndex, triangle, t, glm::vec2(u, v) };
+                    found = true;
+                }
+            }
+        }
+
+        return found;
+    }
+
+#ifdef OGL_SSE2
+    /****************************************************************************/
+    /*!
+    \brief
+      Lanes of the packet that pass through a node's box
+
+    \return
+      Mask with one bit per lane
+    */
+    /****************************************************************************/
+    static int HitBoxes(const BvhNode& node, const Packet& packet)
+    {
+        const float* min = &node.min.x;
+        const float* max = &node.max.x;
+        __m128 tNear = packet.tMin;
+        __m128 tFar = packet.tMax;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(min[axis]), packet.origin[axis]), packet.inverse[axis]);
+            __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max[axis]), packet.origin[axis]), packet.inverse[axis]);
+            tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+            tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+        }
+        return _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Intersect the 4 rays of a packet with one triangle, closer hits are
+      written to hits
+    */
+    /****************************************************************************/
+    static void HitTriangles(const glm::vec3 positions[3], Packet& packet, const Mesh& mesh, GLuint subIndex, GLuint triangle, RayHit hits[4])
+    {
+        glm::vec3 edge1 = positions[1] - positions[0];
+        glm::vec3 edge2 = positions[2] - positions[0];
+        const __m128 e1[3] = { _mm_set1_ps(edge1.x), _mm_set1_ps(edge1.y), _mm_set1_ps(edge1.z) };
+        const __m128 e2[3] = { _mm_set1_ps(edge2.x), _mm_set1_ps(edge2.y), _mm_set1_ps(edge2.z) };
+        const __m128* d = packet.direction;
+
+        auto cross = [](const __m128 a[3], const __m128 b[3], __m128 out[3])
+        {
+            out[0] = _mm_sub_ps(_mm_mul_ps(a[1], b[2]), _mm_mul_ps(a[2], b[1]));
+            out[1] = _mm_sub_ps(_mm_mul_ps(a[2], b[0]), _mm_mul_ps(a[0], b[2]));
+            out[2] = _mm_sub_ps(_mm_mul_ps(a[0], b[1]), _mm_mul_ps(a[1], b[0]));
+        };
+        auto dot = [](const __m128 a[3], const __m128 b[3])
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])), _mm_mul_ps(a[2], b[2]));
+        };
+
+        __m128 p[3];
+        cross(d, e2, p);
+        __m128 determinant = dot(e1, p);
+        __m128 inverse = _mm_div_ps(_mm_set1_ps(1), determinant);
+
+        const __m128 s[3] = { _mm_sub_ps(packet.origin[0], _mm_set1_ps(positions[0].x)),
+            _mm_sub_ps(packet.origin[1], _mm_set1_ps(positions[0].y)), _mm_sub_ps(packet.origin[2], _mm_set1_ps(positions[0].z)) };
+        __m128 u = _mm_mul_ps(dot(s, p), inverse);
+        __m128 q[3];
+        cross(s, e1, q);
+        __m128 v = _mm_mul_ps(dot(d, q), inverse);
+        __m128 t = _mm_mul_ps(dot(e2, q), inverse);
+
+        // |determinant| through clearing the sign bit
+        __m128 absolute = _mm_and_ps(determinant, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+        __m128 mask = _mm_cmpge_ps(absolute, _mm_set1_ps(ParallelEpsilon));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(u, _mm_setzero_ps()));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(v, _mm_setzero_ps()));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1)));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(t, packet.tMin));
+        mask = _mm_and_ps(mask, _mm_cmplt_ps(t, packet.tMax));
+
+        int lanes = _mm_movemask_ps(mask);
+        if (lanes == 0)
+        {
+            return;
+        }
+
+        packet.tMax = _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, packet.tMax));
+
+        float ts[4], us[4], vs[4];
+        _mm_storeu_ps(ts, t);
+        _mm_storeu_ps(us, u);
+        _mm_storeu_ps(vs, v);
+        for (unsigned lane = 0; lane < 4; ++lane)
+        {
+            if (lanes & (1 << lane))
+            {
+                hits[lane] = { &mesh, subIndex, triangle, ts[lane], glm::vec2(us[lane], vs[lane]) };
+            }
+        }
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Trace a packet through the BVH of one submesh, a node is entered
+      when any ray of the packet hits it
+
+    \param direction
+      Leading direction of the packet, orders the children
+    */
+    /****************************************************************************/
+    static void TracePacket(const Mesh& mesh, GLuint subIndex, Packet& packet, const glm::vec3& direction, RayHit hits[4],
+        std::vector<GLuint>& stack)
+    {
+        const MeshData& data = mesh.Data();
+        const SubMesh& subMesh = data.subMeshes[subIndex];
+
+        stack.clear();
+        stack.push_back(subMesh.firstBvhNode);
+        while (!stack.empty())
+        {
+            GLuint index = stack.back();
+            stack.pop_back();
+
+            const BvhNode& node = data.bvhNodes[index];
+            if (HitBoxes(node, packet) == 0)
+            {
+                continue;
+            }
+
+            if (node.count == 0)
+            {
+                GLuint first;
+                GLuint second;
+                OrderChildren(data.bvhNodes, index, direction, first, second);
+                stack.push_back(second);
+                stack.push_back(first);
+                continue;
+            }
+
+            for (GLuint i = node.first; i < node.first + node.count; ++i)
+            {
+                glm::vec3 positions[3];
+                GLuint triangle = data.bvhTriangles[i];
+                TrianglePositions(data, subMesh, triangle, positions);
+                HitTriangles(positions, packet, mesh, subIndex, triangle, hits);
+            }
+        }
+    }
+#endif
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Find the closest triangle of a mesh along a ray
+
+\param mesh
+  The mesh, its CPU side data must be resident, it is queried in its
+  own space
+
+\param ray
+  The ray, see Transform to bring it into the mesh's space
+
+\param hit
+  Only hits closer than it are reported, and written to it
+
+\return
+  True if the mesh was hit closer than hit was before
+*/
+/****************************************************************************/
+bool OGL::RayCaster::Intersect(const Mesh& mesh, const Ray& ray, RayHit& hit)
+{
+    if (!mesh.HasBvh())
+    {
+        return IntersectLinear(mesh, ray, hit);
+    }
+
+    std::vector<GLuint> stack;
+    bool found = false;
+    const std::vector<SubMesh>& subMeshes = mesh.SubMeshes();
+    for (GLuint i = 0; i < GLuint(subMeshes.size()); ++i)
+    {
+        if (subMeshes[i].bvhNodeCount != 0)
+        {
+            found = TraceRay(mesh, i, ray, hit, stack) || found;
+        }
+    }
+    return found;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Find the closest triangle of a mesh along each of a batch of rays,
+  traced in packets spread over the worker threads
+
+\param mesh
+  The mesh, its CPU side data must be resident
+
+\param rays
+  The rays, neighbours should point roughly the same way
+
+\param count
+  Number of rays
+
+\param hits
+  One per ray, only closer hits are written
+*/
+/****************************************************************************/
+void OGL::RayCaster::Intersect(const Mesh& mesh, const Ray* rays, std::size_t count, RayHit* hits)
+{
+#ifdef OGL_SSE2
+    if (!mesh.HasBvh())
+#endif
+    {
+        ParallelFor(count, MinPacketsPerThread * PacketSize, [&](std::size_t begin, std::size_t end, unsigned)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                Intersect(mesh, rays[i], hits[i]);
+            }
+        });
+        return;
+    }
+
+#ifdef OGL_SSE2
+    const std::size_t packetCount = (count + PacketSize - 1) / PacketSize;
+    const std::vector<SubMesh>& subMeshes = mesh.SubMeshes();
+    ParallelFor(packetCount, MinPacketsPerThread, [&](std::size_t begin, std::size_t end, unsigned)
+    {
+        std::vector<GLuint> stack;
+        for (std::size_t p = begin; p < end; ++p)
+        {
+            const std::size_t first = p * PacketSize;
+            const std::size_t lanes = std::min<std::size_t>(PacketSize, count - first);
+
+            // missing lanes of the last packet get an empty interval
+            alignas(16) float lane[12][4] = {};
+            RayHit packetHits[4];
+            for (std::size_t k = 0; k < 4; ++k)
+            {
+                Ray ray;
+                ray.tMax = -1;
+                if (k < lanes)
+                {
+                    ray = rays[first + k];
+                    packetHits[k] = hits[first + k];
+                    ray.tMax = std::min(ray.tMax, packetHits[k].t);
+                }
+
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    lane[axis][k] = ray.origin[axis];
+                    lane[3 + axis][k] = ray.direction[axis];
+                    lane[6 + axis][k] = 1.0f / ray.direction[axis];
+                }
+                lane[9][k] = ray.tMin;
+                lane[10][k] = ray.tMax;
+            }
+
+            Packet packet;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                packet.origin[axis] = _mm_load_ps(lane[axis]);
+                packet.direction[axis] = _mm_load_ps(lane[3 + axis]);
+                packet.inverse[axis] = _mm_load_ps(lane[6 + axis]);
+            }
+            packet.tMin = _mm_load_ps(lane[9]);
+            packet.tMax = _mm_load_ps(lane[10]);
+
+            for (GLuint i = 0; i < GLuint(subMeshes.size()); ++i)
+            {
+                if (subMeshes[i].bvhNodeCount != 0)
+                {
+                    TracePacket(mesh, i, packet, rays[first].direction, packetHits, stack);
+                }
+            }
+
+            std::copy(packetHits, packetHits + lanes, hits + first);
+        }
+    });
+#endif
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Find the closest triangle of a mesh along a ray by testing every full
+  detail triangle, the fallback without a BVH and the reference to test
+  it against
+
+\param mesh
+  The mesh, its CPU side data must be resident
+
+\param ray
+  The ray, in the mesh's space
+
+\param hit
+  Only hits closer than it are reported, and written to it
+
+\return
+  True if the mesh was hit closer than hit was before
+*/
+/****************************************************************************/
+bool OGL::RayCaster::IntersectLinear(const Mesh& mesh, const Ray& ray, RayHit& hit)
+{
+    const MeshData& data = mesh.Data();
+    if (data.vertices.empty())
+    {
+        return false;
+    }
+
+    bool found = false;
+    for (GLuint i = 0; i < GLuint(data.subMeshes.size()); ++i)
+    {
+        const SubMesh& subMesh = data.subMeshes[i];
+        for (GLuint triangle = 0; triangle < subMesh.indexCount / 3; ++triangle)
+        {
+            glm::vec3 positions[3];
+            TrianglePositions(data, subMesh, triangle, positions);
+
+            float t, u, v;
+            if (HitTriangle(positions, ray, ray.tMin, std::min(ray.tMax, hit.t), t, u, v))
+            {
+                hit = { &mesh, i, triangle, t, glm::vec2(u, v) };
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Move a ray into another space, the direction is not renormalized so
+  distances along it stay comparable between spaces
+
+\param ray
+  The ray
+
+\param transform
+  Into the new space, the inverse of a mesh's world matrix brings a
+  world space ray into the mesh's space
+
+\return
+  The transformed ray
+*/
+/****************************************************************************/
+OGL::Ray OGL::RayCaster::Transform(const Ray& ray, const glm::mat4& transform)
+{
+    Ray result = ray;
+    result.origin = glm::vec3(transform * glm::vec4(ray.origin, 1));
+    result.direction = glm::vec3(transform * glm::vec4(ray.direction, 0));
+    return result;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  World space ray through a point of the window, from the near plane to
+  the far plane
+
+\param projection
+  Projection matrix of the camera
+
+\param view
+  View matrix of the camera
+
+\param cursor
+  Window position in pixels, from the top left as GLFW reports it
+
+\param viewport
+  Window size in pixels
+
+\return
+  The ray, with a unit direction so t is a distance
+*/
+/****************************************************************************/
+OGL::Ray OGL::RayCaster::ScreenRay(const glm::mat4& projection, const glm::mat4& view, const glm::vec2& cursor, const glm::vec2& viewport)
+{
+    glm::vec2 ndc(2 * cursor.x / viewport.x - 1, 1 - 2 * cursor.y / viewport.y);
+    glm::mat4 inverse = glm::inverse(projection * view);
+    // windows.h defines near and far away
+    glm::vec4 nearPoint = inverse * glm::vec4(ndc, -1, 1);
+    glm::vec4 farPoint = inverse * glm::vec4(ndc, 1, 1);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 end = glm::vec3(farPoint) / farPoint.w;
+
+    Ray ray;
+    ray.origin = origin;
+    ray.direction = glm::normalize(end - origin);
+    ray.tMax = glm::length(end - origin);
+    return ray;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
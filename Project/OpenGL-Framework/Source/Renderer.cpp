@@ -17,11 +17,49 @@
 
 #include "OPENGLPCH.hpp"
 #include "Renderer.hpp"
+#include "GLState.hpp"
+#include "MemoryTracker.hpp"
+#include "RayCaster.hpp"
 
 /*============================================================================*\
 || --------------------------- GLOBAL VARIABLES ----------------------------- ||
 \*============================================================================*/
 
+namespace
+{
+    //! the Camera block, pushed once per frame and shared by every program
+    struct CameraBlock
+    {
+        glm::mat4 projection;
+        glm::mat4 view;
+
+        using Layout = OGL::Std140Layout<glm::mat4, glm::mat4>;
+        static constexpr const char* Name = "Camera";
+        static constexpr GLuint Binding = 0;
+    };
+    static_assert(CameraBlock::Layout::Matches({ offsetof(CameraBlock, projection), offsetof(CameraBlock, view) },
+        sizeof(CameraBlock)), "CameraBlock does not match std140");
+
+    //! the Object block of Simple.vert, pushed per draw
+    struct ObjectBlock
+    {
+        glm::mat4 world;
+        glm::vec3 positionScale;
+        float padding;              //!< std140 aligns a vec3 to 16 bytes
+        glm::vec3 positionBias;
+        float tail;                 //!< std140 rounds a block up to 16 bytes
+
+        using Layout = OGL::Std140Layout<glm::mat4, glm::vec3, glm::vec3>;
+        static constexpr const char* Name = "Object";
+        static constexpr GLuint Binding = 1;
+    };
+    static_assert(ObjectBlock::Layout::Matches({ offsetof(ObjectBlock, world), offsetof(ObjectBlock, positionScale),
+        offsetof(ObjectBlock, positionBias) }, sizeof(ObjectBlock)),
+        "ObjectBlock does not match std140");
+
+    //! feature bits of mShaders, in the order of its feature defines
+    constexpr OGL::ShaderFeatures OctahedralNormals = 1 << 0;
+}
 
 /*============================================================================*\
 || -------------------------- STATIC FUNCTIONS ------------------------------ ||
@@ -111,8 +149,8 @@ OGL::Renderer::Renderer()
 /****************************************************************************/
 OGL::Renderer::~Renderer()
 {
-    ShutdownGLFW();
     ShutdownOGL();
+    ShutdownGLFW();
 }
 
 /****************************************************************************/
@@ -126,20 +164,61 @@ OGL::Renderer::~Renderer()
 /****************************************************************************/
 void OGL::Renderer::Draw(float dt)
 {
+    // finish any mesh the loader threads are done with
+    if (mLoader.Update(UploadBudget) && mMesh.IsResident())
+    {
+        DEBUG::log.Info("Renderer: mesh resident after", mStartup.Milliseconds(), "ms");
+        MemoryTracker::Log();
+    }
+
+    // swap in shaders edited on disk once they link
+    mShaderWatcher.Update();
+
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     mAngle -= dt;
     glm::mat4 mWorld = glm::mat4(1);
     mWorld = glm::rotate(mWorld, mAngle, { 0, 1, 0 } );
+    Pick(mWorld);
+
+    // the camera once per frame, whatever program draws with it
+    mUniforms.BeginFrame();
+    mUniforms.Bind(CameraBlock::Binding, mUniforms.Push(CameraBlock{ mProj, mView }));
 
-    mShader.Use();
-    mShader.SetUniform("projection", mProj);
-    mShader.SetUniform("view", mView);
-    mShader.SetUniform("world", mWorld);
-    mMesh.Draw();
+    // nothing to draw until the mesh is resident
+    if (mMesh.IsResident())
+    {
+        const VertexDecode& decode = mMesh->Decode();
+        ObjectBlock object = {};
+        object.world = mWorld;
+        object.positionScale = decode.positionScale;
+        object.positionBias = decode.positionBias;
+        mUniforms.Bind(ObjectBlock::Binding, mUniforms.Push(object));
+        mShaders.Get(decode.octahedralNormals ? OctahedralNormals : 0).Use();
+
+        // coarsest LOD whose error projects to at most LodPixelError pixels,
+        // measured at the point of the bounding sphere nearest the camera
+        BoundingSphere sphere = mMesh->GetSphere();
+        glm::vec3 center = glm::vec3(mWorld * glm::vec4(sphere.center, 1));
+        float radius = sphere.radius;
+        glm::vec3 eye = glm::vec3(glm::inverse(mView)[3]);
+        float distance = std::max(glm::length(eye - center) - radius, mNearPlane);
+        float pixelsPerUnit = mWindowHeight / (2 * distance * std::tan(mFov * 0.5f));
+        mMesh->Draw(LodPixelError / pixelsPerUnit);
+    }
 
+    mUniforms.EndFrame();
+    GLState::EndFrame();
     Present();
+
+    if (mFirstFrame)
+    {
+        GLStateCounters state = GLState::LastFrame();
+        DEBUG::log.Info("Renderer: first frame after", mStartup.Milliseconds(), "ms,", state.issued, "state calls issued,",
+            state.elided, "elided");
+        mFirstFrame = false;
+    }
 }
 
 /****************************************************************************/
@@ -224,26 +303,33 @@ void OGL::Renderer::InitWindow()
 void OGL::Renderer::InitOGL()
 {
    glewInit();
-   glEnable(GL_CULL_FACE);
-   glEnable(GL_DEPTH_TEST);
+   GLState::Enable(GL_CULL_FACE);
+   GLState::Enable(GL_DEPTH_TEST);
 
 #ifdef _DEBUG
-   glEnable(GL_DEBUG_OUTPUT);
+   GLState::Enable(GL_DEBUG_OUTPUT);
    glDebugMessageCallback(GLMessageCallback, 0);
 #endif
 
-   mMesh.Create("../Resource/Models/StanfordBunny.obj");
-   mShader.Create("../Resource/Shaders/Simple.vert", "../Resource/Shaders/Simple.frag");
+   // loads on the loader thread, Draw uploads it once it is ready, the CPU
+   // side copy and its BVH stay around for picking
+   mMesh = mMeshes.Load("../Resource/Models/StanfordBunny.obj", { PositionEncoding::Quantized, NormalEncoding::Octahedral },
+       Residency::CpuAndGpu, true);
+   mUniforms.Create();
+   mShaders.BindBlock<CameraBlock>();
+   mShaders.BindBlock<ObjectBlock>();
+   mShaders.Watch(mShaderWatcher);
+
+   // both normal encodings, as one batch, any other variant is built on first use
+   mShaders.Preload({ 0, OctahedralNormals });
 
    float y = 0.1f;
    glm::vec3 position = { 0, y, 1 };
    glm::vec3 up = { 0, 1, 0 };
-   float fov = 0.42173f;
    float aspectRatio = float(mWindowWidth) / mWindowHeight;
-   float nearPlane = 0.1f;
    float farPlane = 250.f;
 
-   mProj = glm::perspective(fov, aspectRatio, nearPlane, farPlane);
+   mProj = glm::perspective(mFov, aspectRatio, mNearPlane, farPlane);
    mView = glm::lookAt(position, glm::vec3(0.0f, y, 0.0f), up);
 }
 
@@ -278,7 +364,53 @@ void OGL::Renderer::ShutdownWindow()
 /****************************************************************************/
 void OGL::Renderer::ShutdownOGL()
 {
+    // every mesh gives its range back before the arenas go, the loader
+    // holds on to meshes until they are uploaded and refined, so its jobs
+    // are dropped first, only loads already running are waited for
+    mLoader.Cancel();
+    mMesh = MeshHandle();
+    mMeshes.Collect();
+    GeometryArena::DestroyAll();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Log what is under the cursor when the left mouse button goes down
+
+\param world
+  World matrix the mesh is drawn with this frame
+*/
+/****************************************************************************/
+void OGL::Renderer::Pick(const glm::mat4& world)
+{
+    // on the press, not for as long as the button is held
+    bool down = glfwGetMouseButton(mWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    bool pressed = down && !mMouseDown;
+    mMouseDown = down;
+    if (!pressed || !mMesh.IsResident())
+    {
+        return;
+    }
+
+    // the cursor is in screen coordinates, which need not be pixels
+    double x, y;
+    int width, height;
+    glfwGetCursorPos(mWindow, &x, &y);
+    glfwGetWindowSize(mWindow, &width, &height);
 
+    Timer timer;
+    Ray ray = RayCaster::ScreenRay(mProj, mView, glm::vec2(x, y), glm::vec2(width, height));
+    RayHit hit;
+    if (RayCaster::Intersect(*mMesh, RayCaster::Transform(ray, glm::inverse(world)), hit))
+    {
+        DEBUG::log.Info("Renderer: picked submesh", hit.subMesh, "triangle", hit.triangle, "at distance", hit.t,
+            "barycentrics", hit.barycentrics.x, hit.barycentrics.y, "in", timer.Milliseconds(), "ms");
+    }
+    else
+    {
+        DEBUG::log.Info("Renderer: picked nothing in", timer.Milliseconds(), "ms");
+    }
 }
 
 /****************************************************************************/
@@ -16,15 +16,15 @@
 
 #include "OPENGLPCH.hpp"
 #include "Shader.hpp"
-#include <fstream>
-#include <streambuf>
+#include "GLState.hpp"
+#include "ShaderCache.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "Timer.hpp"
 
 /*============================================================================*\
 || --------------------------- GLOBAL VARIABLES ----------------------------- ||
 \*============================================================================*/
 
-#define INFOLOGSIZE 512
-
 /*============================================================================*\
 || -------------------------- STATIC FUNCTIONS ------------------------------ ||
 \*============================================================================*/
@@ -36,50 +36,127 @@
 /****************************************************************************/
 /*!
 \brief
-  Clean up
+  Clean up, a reload still in flight is dropped
 */
 /****************************************************************************/
 OGL::Shader::~Shader()
 {
-    glDeleteProgram(mID);
+    if (mPending)
+    {
+        Finish(mPending, mPendingStages);
+        glDeleteProgram(mPending);
+    }
+    GLState::DeleteProgram(mID);
 }
 
 /****************************************************************************/
 /*!
 \brief
-  Load, compile, and link the shaders
+  Load, compile, and link the shaders, or restore the linked program
+  from the shader cache when the driver has seen the same sources.
+  Blocks until the program is linked, see ShaderBatch to build many
+  programs side by side.
 
 \param vertexShader
   The path to the vertex shader
 
 \param fragmentShader
   The path to the fragment shader
+
+\param useCache
+  False always compiles from source, the cache entry is still refreshed
+
+\param defines
+  Defines for both stages, "NAME" or "NAME VALUE"
 */
 /****************************************************************************/
-void OGL::Shader::Create(const std::string vertexShader, const std::string fragmentShader)
+void OGL::Shader::Create(const std::string vertexShader, const std::string fragmentShader, bool useCache,
+    const std::vector<std::string>& defines)
 { 
-    /* vertex shader */
-    GLuint vertexShaderID = LoadShader(vertexShader, GL_VERTEX_SHADER);
-
-    /* fragment shader */
-    GLuint fragmentShaderID = LoadShader(fragmentShader, GL_FRAGMENT_SHADER);
-
-    /* create program */
-    mID = glCreateProgram();
-    glAttachShader(mID, vertexShaderID);
-    glAttachShader(mID, fragmentShaderID);
-    glLinkProgram(mID);
-    int  success;
-    glGetProgramiv(mID, GL_LINK_STATUS, &success);
-    if (!success)
+    Submit(vertexShader, fragmentShader, useCache, defines);
+    Complete();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Start building the program without waiting for it. A cache hit is
+  linked straight away, otherwise compiling and linking are submitted
+  and Complete picks the result up.
+
+\param vertexShader
+  The path to the vertex shader
+
+\param fragmentShader
+  The path to the fragment shader
+
+\param useCache
+  False always compiles from source, the cache entry is still refreshed
+
+\param defines
+  Defines for both stages, "NAME" or "NAME VALUE"
+
+\exception std::runtime_error
+  If a source file or one it includes can not be read
+*/
+/****************************************************************************/
+void OGL::Shader::Submit(const std::string vertexShader, const std::string fragmentShader, bool useCache,
+    const std::vector<std::string>& defines)
+{
+    mVertexPath = vertexShader;
+    mFragmentPath = fragmentShader;
+    mDefines = defines;
+
+    std::string vertexSource;
+    std::string fragmentSource;
+    Preprocess(vertexSource, fragmentSource);
+    Start(vertexSource, fragmentSource, useCache);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Has the driver finished the submitted program, never blocks. Without
+  parallel shader compile there is no way to ask, it reports finished
+  and Complete waits for the driver.
+
+\return
+  True if Complete will not wait on the compiler
+*/
+/****************************************************************************/
+bool OGL::Shader::IsCompiled() const
+{
+    if (!mPending || !(GLEW_ARB_parallel_shader_compile || GLEW_KHR_parallel_shader_compile))
+    {
+        return true;
+    }
+
+    GLint complete = GL_FALSE;
+    glGetProgramiv(mPending, GL_COMPLETION_STATUS_ARB, &complete);
+    return complete == GL_TRUE;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Wait for the submitted program and start drawing with it
+
+\exception std::runtime_error
+  With the compile or link log if the program failed to build
+*/
+/****************************************************************************/
+void OGL::Shader::Complete()
+{
+    if (!mPending)
     {
-        char infoLog[INFOLOGSIZE];
-        glGetProgramInfoLog(mID, INFOLOGSIZE, NULL, infoLog);
-        throw std::runtime_error("shader linkage failed! " + std::string(infoLog));
+        return;
     }
 
-    glDeleteShader(vertexShaderID);
-    glDeleteShader(fragmentShaderID);
+    const std::string errors = Resolve();
+    if (!errors.empty())
+    {
+        throw std::runtime_error("shader build failed! " + errors);
+    }
 }
 
 /****************************************************************************/
@@ -90,24 +167,249 @@ void OGL::Shader::Create(const std::string vertexShader, const std::string fragm
 /****************************************************************************/
 void OGL::Shader::Use()
 {
-    glUseProgram(mID);
+    GLState::UseProgram(mID);
 }
 
 /****************************************************************************/
 /*!
 \brief
-  Set a uniform bool
+  Start rebuilding the program from its source files. Compiling and
+  linking are only submitted, UpdateReload picks the result up on a
+  later frame and the current program keeps drawing until then. A
+  reload already in flight is dropped for the newer sources.
+
+\return
+  True if a reload was started, false if the sources can not be read
+*/
+/****************************************************************************/
+bool OGL::Shader::BeginReload()
+{
+    if (mVertexPath.empty())
+    {
+        return false;
+    }
+
+    std::string vertexSource;
+    std::string fragmentSource;
+    try
+    {
+        Preprocess(vertexSource, fragmentSource);
+    }
+    catch (const std::runtime_error& error)
+    {
+        // an editor may still be writing the file, the next change retries
+        DEBUG::log.Error("Shader: reloading", mVertexPath, "failed,", error.what());
+        return false;
+    }
+
+    Start(vertexSource, fragmentSource, true);
+    return true;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Finish a reload once the driver is done with it, call once a frame.
+  A program that links replaces the current one between draws, on
+  errors the current program is kept and the errors are logged.
+
+\return
+  True if a reload finished this call, whether it succeeded or not
+*/
+/****************************************************************************/
+bool OGL::Shader::UpdateReload()
+{
+    // without parallel compile Resolve may block, the reload has had at
+    // least a frame to finish by then
+    if (!mPending || !IsCompiled())
+    {
+        return false;
+    }
+
+    const std::string errors = Resolve();
+    if (!errors.empty())
+    {
+        DEBUG::log.Error("Shader: reloading", mVertexPath, "failed, keeping the previous program\n" + errors);
+    }
+    return true;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Is a submitted program or a reload still waiting to be picked up
+
+\return
+  True while a build is in flight
+*/
+/****************************************************************************/
+bool OGL::Shader::IsReloading() const
+{
+    return mPending != 0;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Does the shader have a program to draw with
+
+\return
+  True once a program has linked
+*/
+/****************************************************************************/
+bool OGL::Shader::IsLinked() const
+{
+    return mID != 0;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get how long the last program took, from submitting it until it was
+  picked up linked
+
+\return
+  Milliseconds, 0 before the first program
+*/
+/****************************************************************************/
+double OGL::Shader::BuildMilliseconds() const
+{
+    return mBuildMilliseconds;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Was the last program restored from the shader cache
+
+\return
+  True for a cache hit, false if it was compiled
+*/
+/****************************************************************************/
+bool OGL::Shader::IsFromCache() const
+{
+    return mFromCache;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the vertex shader path
+
+\return
+  The path passed to Create
+*/
+/****************************************************************************/
+const std::string& OGL::Shader::VertexPath() const
+{
+    return mVertexPath;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the fragment shader path
+
+\return
+  The path passed to Create
+*/
+/****************************************************************************/
+const std::string& OGL::Shader::FragmentPath() const
+{
+    return mFragmentPath;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the defines the program is built with
+
+\return
+  The defines passed to Create
+*/
+/****************************************************************************/
+const std::vector<std::string>& OGL::Shader::Defines() const
+{
+    return mDefines;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get every file the program's source was made of
+
+\return
+  Both stages and everything they include, as of the last build
+*/
+/****************************************************************************/
+const std::vector<std::string>& OGL::Shader::Files() const
+{
+    return mFiles;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Find a uniform in the table reflected at link time
 
 \param name
-  Name of the uniform in the shader
+  Name of the uniform in the shader, an array's elements can be named
+  with or without the index of the first one
+
+\return
+  Handle to set the uniform with, -1 if the program has no such uniform
+*/
+/****************************************************************************/
+OGL::UniformHandle OGL::Shader::Uniform(UniformName name) const
+{
+    auto it = std::lower_bound(mUniforms.begin(), mUniforms.end(), name.hash,
+        [](const ShaderUniform& uniform, std::uint64_t hash) { return uniform.hash < hash; });
+    return it != mUniforms.end() && it->hash == name.hash ? it->location : -1;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get every active uniform outside of a uniform block
+
+\return
+  The reflected table, sorted by name hash
+*/
+/****************************************************************************/
+const std::vector<OGL::ShaderUniform>& OGL::Shader::Uniforms() const
+{
+    return mUniforms;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get every active uniform block
+
+\return
+  The reflected blocks
+*/
+/****************************************************************************/
+const std::vector<OGL::ShaderBlock>& OGL::Shader::Blocks() const
+{
+    return mBlocks;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Set a uniform bool
+
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, bool value) const
+void OGL::Shader::SetUniform(UniformHandle handle, bool value) const
 {
-    glUniform1i(glGetUniformLocation(mID, name.c_str()), (int)value);
+    glUniform1i(handle, (int)value);
 }
 
 /****************************************************************************/
@@ -115,16 +417,16 @@ void OGL::Shader::SetUniform(const std::string name, bool value) const
 \brief
   Set a uniform int
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, int value) const
+void OGL::Shader::SetUniform(UniformHandle handle, int value) const
 {
-    glUniform1i(glGetUniformLocation(mID, name.c_str()), value);
+    glUniform1i(handle, value);
 }
 
 /****************************************************************************/
@@ -132,16 +434,16 @@ void OGL::Shader::SetUniform(const std::string name, int value) const
 \brief
   Set a uniform float
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, float value) const
+void OGL::Shader::SetUniform(UniformHandle handle, float value) const
 {
-    glUniform1f(glGetUniformLocation(mID, name.c_str()), value);
+    glUniform1f(handle, value);
 }
 
 /****************************************************************************/
@@ -149,16 +451,16 @@ void OGL::Shader::SetUniform(const std::string name, float value) const
 \brief
   Set a uniform vec2
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, const glm::vec2 value) const
+void OGL::Shader::SetUniform(UniformHandle handle, const glm::vec2 value) const
 {
-    glUniform2fv(glGetUniformLocation(mID, name.c_str()), 1, &value[0]);
+    glUniform2fv(handle, 1, &value[0]);
 }
 
 /****************************************************************************/
@@ -166,16 +468,16 @@ void OGL::Shader::SetUniform(const std::string name, const glm::vec2 value) cons
 \brief
   Set a uniform vec2
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, float x, float y) const
+void OGL::Shader::SetUniform(UniformHandle handle, float x, float y) const
 {
-    glUniform2f(glGetUniformLocation(mID, name.c_str()), x, y);
+    glUniform2f(handle, x, y);
 }
 
 /****************************************************************************/
@@ -183,16 +485,16 @@ void OGL::Shader::SetUniform(const std::string name, float x, float y) const
 \brief
   Set a uniform vec3
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, const glm::vec3 value) const
+void OGL::Shader::SetUniform(UniformHandle handle, const glm::vec3 value) const
 {
-    glUniform3fv(glGetUniformLocation(mID, name.c_str()), 1, &value[0]);
+    glUniform3fv(handle, 1, &value[0]);
 }
 
 /****************************************************************************/
@@ -200,16 +502,16 @@ void OGL::Shader::SetUniform(const std::string name, const glm::vec3 value) cons
 \brief
   Set a uniform vec3
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, float x, float y, float z) const
+void OGL::Shader::SetUniform(UniformHandle handle, float x, float y, float z) const
 {
-    glUniform3f(glGetUniformLocation(mID, name.c_str()), x, y, z);
+    glUniform3f(handle, x, y, z);
 }
 
 /****************************************************************************/
@@ -217,16 +519,16 @@ void OGL::Shader::SetUniform(const std::string name, float x, float y, float z)
 \brief
   Set a uniform vec4
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, const glm::vec4 value) const
+void OGL::Shader::SetUniform(UniformHandle handle, const glm::vec4 value) const
 {
-    glUniform4fv(glGetUniformLocation(mID, name.c_str()), 1, &value[0]);
+    glUniform4fv(handle, 1, &value[0]);
 }
 
 /****************************************************************************/
@@ -234,16 +536,16 @@ void OGL::Shader::SetUniform(const std::string name, const glm::vec4 value) cons
 \brief
   Set a uniform vec4
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, float x, float y, float z, float w)
+void OGL::Shader::SetUniform(UniformHandle handle, float x, float y, float z, float w) const
 {
-    glUniform4f(glGetUniformLocation(mID, name.c_str()), x, y, z, w);
+    glUniform4f(handle, x, y, z, w);
 }
 
 /****************************************************************************/
@@ -251,16 +553,16 @@ void OGL::Shader::SetUniform(const std::string name, float x, float y, float z,
 \brief
   Set a uniform mat2
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, const glm::mat2 mat) const
+void OGL::Shader::SetUniform(UniformHandle handle, const glm::mat2 mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(mID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix2fv(handle, 1, GL_FALSE, &mat[0][0]);
 }
 
 /****************************************************************************/
@@ -268,16 +570,16 @@ void OGL::Shader::SetUniform(const std::string name, const glm::mat2 mat) const
 \brief
   Set a uniform mat3
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, const glm::mat3 mat) const
+void OGL::Shader::SetUniform(UniformHandle handle, const glm::mat3 mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(mID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(handle, 1, GL_FALSE, &mat[0][0]);
 }
 
 /****************************************************************************/
@@ -285,16 +587,16 @@ void OGL::Shader::SetUniform(const std::string name, const glm::mat3 mat) const
 \brief
   Set a uniform mat4
 
-\param name
-  Name of the uniform in the shader
+\param handle
+  Location of the uniform, from Uniform
 
 \param value
   The value we want to send to the shader
 */
 /****************************************************************************/
-void OGL::Shader::SetUniform(const std::string name, const glm::mat4 mat) const
+void OGL::Shader::SetUniform(UniformHandle handle, const glm::mat4 mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(mID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(handle, 1, GL_FALSE, &mat[0][0]);
 }
 
 /*============================================================================*\
@@ -304,34 +606,416 @@ void OGL::Shader::SetUniform(const std::string name, const glm::mat4 mat) const
 /****************************************************************************/
 /*!
 \brief
-  Load and compile a shader
+  Run both stages through the preprocessor and remember which files
+  they were made of
+
+\param vertexSource
+  Receives the vertex shader source
+
+\param fragmentSource
+  Receives the fragment shader source
+
+\exception std::runtime_error
+  If a source file or one it includes can not be read
+*/
+/****************************************************************************/
+void OGL::Shader::Preprocess(std::string& vertexSource, std::string& fragmentSource)
+{
+    ShaderSource vertex = ShaderPreprocessor::Process(mVertexPath, mDefines);
+    ShaderSource fragment = ShaderPreprocessor::Process(mFragmentPath, mDefines);
+
+    mFiles = vertex.files;
+    for (const std::string& file : fragment.files)
+    {
+        if (std::find(mFiles.begin(), mFiles.end(), file) == mFiles.end())
+        {
+            mFiles.push_back(file);
+        }
+    }
+
+    vertexSource = std::move(vertex.code);
+    fragmentSource = std::move(fragment.code);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Restore the program from the cache or submit building it, dropping
+  any build still in flight
+
+\param vertexSource
+  The vertex shader GLSL source
+
+\param fragmentSource
+  The fragment shader GLSL source
+
+\param useCache
+  False always compiles from source
+*/
+/****************************************************************************/
+void OGL::Shader::Start(const std::string& vertexSource, const std::string& fragmentSource, bool useCache)
+{
+    if (mPending)
+    {
+        Finish(mPending, mPendingStages);
+        glDeleteProgram(mPending);
+        mPending = 0;
+    }
+    mPendingTimer.Reset();
+
+    /* from the cache */
+    ShaderCache cache({ vertexSource, fragmentSource });
+    GLuint program = glCreateProgram();
+    if (useCache && cache.Load(program))
+    {
+        mBuildMilliseconds = mPendingTimer.Milliseconds();
+        mFromCache = true;
+        DEBUG::log.Info("Shader: loaded", mVertexPath, "from cache in", mBuildMilliseconds, "ms");
+        Adopt(program);
+        return;
+    }
+
+    // a rejected binary can leave the program in any state, start over
+    glDeleteProgram(program);
+
+    /* compile and link */
+    mPendingSources = { vertexSource, fragmentSource };
+    mPending = Build(vertexSource, fragmentSource, mPendingStages);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Pick up the submitted program, waiting for the driver if it is not
+  done, and draw with it if it linked
+
+\return
+  The compile and link logs, empty if the program is now in use
+*/
+/****************************************************************************/
+std::string OGL::Shader::Resolve()
+{
+    GLuint program = mPending;
+    mPending = 0;
+    const std::string errors = Finish(program, mPendingStages);
+    if (!errors.empty())
+    {
+        glDeleteProgram(program);
+        return errors;
+    }
+
+    ShaderCache(mPendingSources).Save(program);
+    mPendingSources.clear();
+    mBuildMilliseconds = mPendingTimer.Milliseconds();
+    mFromCache = false;
+    DEBUG::log.Info("Shader: compiled", mVertexPath, "in", mBuildMilliseconds, "ms");
+    Adopt(program);
+    return errors;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Submit compiling and linking a program without asking GL for any
+  result, so a driver that compiles on its own threads does not block
+
+\param vertexSource
+  The vertex shader GLSL source
+
+\param fragmentSource
+  The fragment shader GLSL source
+
+\param stages
+  Receives the two shader objects, pass them to Finish
+
+\return
+  The program, check it with Finish
+*/
+/****************************************************************************/
+GLuint OGL::Shader::Build(const std::string& vertexSource, const std::string& fragmentSource, GLuint* stages)
+{
+    const std::string* sources[2] = { &vertexSource, &fragmentSource };
+    const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+
+    GLuint program = glCreateProgram();
+    for (int i = 0; i < 2; ++i)
+    {
+        const char* code = sources[i]->c_str();
+        stages[i] = glCreateShader(types[i]);
+        glShaderSource(stages[i], 1, &code, NULL);
+        glCompileShader(stages[i]);
+        glAttachShader(program, stages[i]);
+    }
+
+    if (ShaderCache::IsSupported())
+    {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+    return program;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Check a program submitted by Build and free its shader objects
+
+\param program
+  The program
+
+\param stages
+  The shader objects Build returned, zeroed
+
+\return
+  The compile and link logs of whatever failed, empty if it linked
+*/
+/****************************************************************************/
+std::string OGL::Shader::Finish(GLuint program, GLuint* stages)
+{
+    const char* names[2] = { "vertex", "fragment" };
+
+    std::string errors;
+    std::vector<GLchar> log;
+    for (int i = 0; i < 2; ++i)
+    {
+        GLint success = GL_FALSE;
+        glGetShaderiv(stages[i], GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            GLint length = 0;
+            glGetShaderiv(stages[i], GL_INFO_LOG_LENGTH, &length);
+            log.assign(std::max(length, 1), '\0');
+            glGetShaderInfoLog(stages[i], GLsizei(log.size()), NULL, log.data());
+            errors += std::string(names[i]) + " shader compilation failed: " + log.data() + "\n";
+        }
+    }
+
+    // a stage that failed to compile fails the link too, its log says nothing new
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success && errors.empty())
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        log.assign(std::max(length, 1), '\0');
+        glGetProgramInfoLog(program, GLsizei(log.size()), NULL, log.data());
+        errors = "shader linkage failed: " + std::string(log.data()) + "\n";
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        glDetachShader(program, stages[i]);
+        glDeleteShader(stages[i]);
+        stages[i] = 0;
+    }
+    return errors;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Make a linked program the one this shader draws with, the previous
+  one is deleted and every bound block is bound again
+
+\param program
+  The linked program
+*/
+/****************************************************************************/
+void OGL::Shader::Adopt(GLuint program)
+{
+    GLState::DeleteProgram(mID);
+    mID = program;
+    Reflect();
+
+    for (const BlockBinding& binding : mBlockBindings)
+    {
+        ApplyBlock(binding);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Build the uniform table of the linked program, the only place that
+  asks GL for uniform names and locations
+*/
+/****************************************************************************/
+void OGL::Shader::Reflect()
+{
+    mUniforms.clear();
+    mBlocks.clear();
+
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(mID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(mID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<GLchar> buffer(std::max(maxLength, 1));
+    for (GLint i = 0; i < count; ++i)
+    {
+        ShaderUniform uniform;
+        GLsizei length = 0;
+        glGetActiveUniform(mID, GLuint(i), GLsizei(buffer.size()), &length, &uniform.size, &uniform.type, buffer.data());
+        uniform.name.assign(buffer.data(), length);
+
+        // members of uniform blocks have no location
+        uniform.location = glGetUniformLocation(mID, uniform.name.c_str());
+        if (uniform.location < 0)
+        {
+            continue;
+        }
+
+        uniform.hash = HashName(uniform.name.c_str());
+        mUniforms.push_back(uniform);
+
+        // arrays are reported as "name[0]", let "name" find them too
+        std::size_t bracket = uniform.name.find('[');
+        if (bracket != std::string::npos)
+        {
+            uniform.name.resize(bracket);
+            uniform.hash = HashName(uniform.name.c_str());
+            mUniforms.push_back(uniform);
+        }
+    }
+
+    std::sort(mUniforms.begin(), mUniforms.end(), [](const ShaderUniform& a, const ShaderUniform& b) { return a.hash < b.hash; });
+    for (std::size_t i = 1; i < mUniforms.size(); ++i)
+    {
+        if (mUniforms[i].hash == mUniforms[i - 1].hash)
+        {
+            DEBUG::log.Error("Shader: uniforms", mUniforms[i - 1].name, "and", mUniforms[i].name, "have the same hash");
+        }
+    }
+
+    /* uniform blocks */
+    GLint blockCount = 0;
+    glGetProgramiv(mID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    for (GLint i = 0; i < blockCount; ++i)
+    {
+        ShaderBlock block;
+        block.index = GLuint(i);
+
+        GLint nameLength = 0;
+        GLint memberCount = 0;
+        glGetActiveUniformBlockiv(mID, block.index, GL_UNIFORM_BLOCK_NAME_LENGTH, &nameLength);
+        glGetActiveUniformBlockiv(mID, block.index, GL_UNIFORM_BLOCK_DATA_SIZE, &block.size);
+        glGetActiveUniformBlockiv(mID, block.index, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+
+        std::vector<GLchar> name(std::max(nameLength, 1));
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(mID, block.index, GLsizei(name.size()), &length, name.data());
+        block.name.assign(name.data(), length);
+        block.hash = HashName(block.name.c_str());
+
+        std::vector<GLint> indices(memberCount);
+        if (memberCount > 0)
+        {
+            glGetActiveUniformBlockiv(mID, block.index, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data());
+        }
+        for (GLint index : indices)
+        {
+            ShaderBlockMember member;
+            const GLuint uniform = GLuint(index);
+            GLint arraySize = 0;
+            glGetActiveUniformsiv(mID, 1, &uniform, GL_UNIFORM_OFFSET, &member.offset);
+            glGetActiveUniform(mID, uniform, GLsizei(buffer.size()), &length, &arraySize, &member.type, buffer.data());
+            member.name.assign(buffer.data(), length);
+            block.members.push_back(member);
+        }
+
+        std::sort(block.members.begin(), block.members.end(),
+            [](const ShaderBlockMember& a, const ShaderBlockMember& b) { return a.offset < b.offset; });
+        mBlocks.push_back(block);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Check a C++ block layout against the program's block and bind it.
+  Members the compiler dropped as unused are not reported, so only the
+  reported ones are checked. The binding is remembered and applied
+  again to every program a reload swaps in.
+
+\param name
+  Name of the block in the shader
+
+\param binding
+  Binding point to read the block from
+
+\param offsets
+  Offset of every member of the C++ struct
 
-\param path
-  The path to the shader
+\param types
+  GL type of every member of the C++ struct
 
-\param type
-  What kind of shader to compile. IE: vertex or fragment
+\param count
+  Number of members
 
+\param size
+  sizeof the C++ struct
+
+\return
+  True if the block was bound, false if the program has no such block
+  or the layouts differ
 */
 /****************************************************************************/
-GLuint OGL::Shader::LoadShader(const std::string path, const int type)
+bool OGL::Shader::BindBlock(UniformName name, GLuint binding, const std::size_t* offsets, const GLenum* types, std::size_t count, std::size_t size)
 {
-    /* load */
-    std::ifstream file(path);
-    std::string temp((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    const char* code = temp.c_str();
+    BlockBinding record = { name, binding, offsets, types, count, size };
+    auto previous = std::find_if(mBlockBindings.begin(), mBlockBindings.end(),
+        [&](const BlockBinding& other) { return other.name.hash == name.hash; });
+    if (previous != mBlockBindings.end())
+    {
+        *previous = record;
+    }
+    else
+    {
+        mBlockBindings.push_back(record);
+    }
+
+    return ApplyBlock(record);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Check a recorded block binding against the current program and bind it
+
+\param binding
+  The binding, as recorded by BindBlock
 
-    /* compile */
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &code, NULL);
-    glCompileShader(shader);
-    int  success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success)
+\return
+  True if the block was bound
+*/
+/****************************************************************************/
+bool OGL::Shader::ApplyBlock(const BlockBinding& binding)
+{
+    auto block = std::find_if(mBlocks.begin(), mBlocks.end(), [&](const ShaderBlock& block) { return block.hash == binding.name.hash; });
+    if (block == mBlocks.end())
+    {
+        return false;
+    }
+
+    if (std::size_t(block->size) > binding.size)
     {
-        char infoLog[INFOLOGSIZE];
-        glGetShaderInfoLog(shader, INFOLOGSIZE, NULL, infoLog);
-        throw std::runtime_error("shader compilation failed! " + std::string(infoLog));
+        DEBUG::log.Error("Shader: block", block->name, "reads", block->size, "bytes, the C++ struct has", binding.size);
+        return false;
     }
-    return shader;
+
+    const std::size_t* offsets = binding.offsets;
+    const std::size_t count = binding.count;
+    for (const ShaderBlockMember& member : block->members)
+    {
+        const std::size_t* offset = std::find(offsets, offsets + count, std::size_t(member.offset));
+        if (offset == offsets + count || binding.types[offset - offsets] != member.type)
+        {
+            DEBUG::log.Error("Shader: block", block->name, "member", member.name, "at offset", member.offset,
+                "does not match the C++ struct");
+            return false;
+        }
+    }
+
+    glUniformBlockBinding(mID, block->index, binding.binding);
+    return true;
 }
@@ -0,0 +1,282 @@
+/****************************************************************************/
+/*!
+\file
+   ShaderBatch.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Every program of a batch is submitted before any of them is asked
+    for its status, a status query waits for that program and would
+    keep the driver's compiler threads from working ahead. With
+    KHR_parallel_shader_compile, or the ARB version of it, programs are
+    picked up as GL_COMPLETION_STATUS reports them done and the driver
+    is allowed as many compiler threads as it likes. Without it the
+    programs are picked up in order, the driver may still have compiled
+    some of them on its own threads meanwhile.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "ShaderBatch.hpp"
+#include <thread>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Add a program to build with the next Submit
+
+\param shader
+  The shader to build, it must outlive the batch's Complete
+
+\param vertexShader
+  The path to the vertex shader
+
+\param fragmentShader
+  The path to the fragment shader
+
+\param useCache
+  False always compiles from source
+
+\param defines
+  Defines for both stages
+*/
+/****************************************************************************/
+void OGL::ShaderBatch::Add(Shader& shader, const std::string& vertexShader, const std::string& fragmentShader, bool useCache,
+    const std::vector<std::string>& defines)
+{
+    mEntries.push_back({ &shader, vertexShader, fragmentShader, useCache, defines, false, false, std::string() });
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Submit every program added since the last Submit to the driver
+  without waiting for any of them, cache hits are linked straight away
+*/
+/****************************************************************************/
+void OGL::ShaderBatch::Submit()
+{
+    // let the driver use as many threads as it has, the default is its own choice
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    }
+    else if (GLEW_ARB_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+
+    mTimer.Reset();
+    for (Entry& entry : mEntries)
+    {
+        if (!entry.submitted)
+        {
+            entry.submitted = true;
+            entry.shader->Submit(entry.vertexShader, entry.fragmentShader, entry.useCache, entry.defines);
+            ++mPending;
+        }
+    }
+
+    // cache hits are already linked
+    Update();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Pick up every program the driver has finished. Never waits with
+  parallel shader compile, without it every program counts as finished
+  and this waits for them all.
+
+\return
+  True once every program of the batch is picked up
+*/
+/****************************************************************************/
+bool OGL::ShaderBatch::Update()
+{
+    for (Entry& entry : mEntries)
+    {
+        if (entry.submitted && !entry.done && entry.shader->IsCompiled())
+        {
+            Resolve(entry);
+        }
+    }
+    return mPending == 0;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Wait for every program of the batch, picking each up as soon as it
+  is done so the timings are not held up by slower ones
+
+\exception std::runtime_error
+  With the logs of every program that failed to build, once all of the
+  others are picked up
+*/
+/****************************************************************************/
+void OGL::ShaderBatch::Complete()
+{
+    while (!Update())
+    {
+        std::this_thread::yield();
+    }
+
+    // every message already says the build failed
+    std::string errors;
+    for (const Entry& entry : mEntries)
+    {
+        if (!entry.errors.empty())
+        {
+            errors += entry.vertexShader + ": " + entry.errors;
+        }
+    }
+    if (!errors.empty())
+    {
+        throw std::runtime_error(errors);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Log how long every program took and how much of the batch ran in
+  parallel, the sum of the programs' times over the batch's wall time
+*/
+/****************************************************************************/
+void OGL::ShaderBatch::Report() const
+{
+    double sum = 0;
+    for (const Entry& entry : mEntries)
+    {
+        if (entry.done)
+        {
+            std::string defines;
+            for (const std::string& define : entry.defines)
+            {
+                defines += " " + define;
+            }
+
+            const char* source = !entry.errors.empty() ? "failed" : entry.shader->IsFromCache() ? "cache" : "compiled";
+            DEBUG::log.Info("ShaderBatch:", entry.vertexShader + defines, source, "in", entry.shader->BuildMilliseconds(), "ms");
+            sum += entry.shader->BuildMilliseconds();
+        }
+    }
+
+    DEBUG::log.Info("ShaderBatch:", mEntries.size(), "programs in", mMilliseconds, "ms, parallel compile", IsParallel(),
+        "with", CompilerThreads(), "threads, overlap", mMilliseconds > 0 ? sum / mMilliseconds : 0, "x");
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get how many programs are submitted but not picked up yet
+
+\return
+  Programs in flight
+*/
+/****************************************************************************/
+std::size_t OGL::ShaderBatch::Pending() const
+{
+    return mPending;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the wall time of the batch
+
+\return
+  Milliseconds from Submit until the last program was picked up
+*/
+/****************************************************************************/
+double OGL::ShaderBatch::Milliseconds() const
+{
+    return mMilliseconds;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Can the driver be asked whether a program is done without waiting
+
+\return
+  True with KHR_parallel_shader_compile or ARB_parallel_shader_compile
+*/
+/****************************************************************************/
+bool OGL::ShaderBatch::IsParallel()
+{
+    return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get how many compiler threads the driver was allowed
+
+\return
+  The thread limit, 0 without parallel shader compile
+*/
+/****************************************************************************/
+GLint OGL::ShaderBatch::CompilerThreads()
+{
+    if (!IsParallel())
+    {
+        return 0;
+    }
+
+    GLint threads = 0;
+    glGetIntegerv(GL_MAX_SHADER_COMPILER_THREADS_ARB, &threads);
+    return threads;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Pick up one finished program, keeping its errors for Complete
+
+\param entry
+  The program
+
+\return
+  True if it linked
+*/
+/****************************************************************************/
+bool OGL::ShaderBatch::Resolve(Entry& entry)
+{
+    try
+    {
+        entry.shader->Complete();
+    }
+    catch (const std::runtime_error& error)
+    {
+        entry.errors = error.what();
+    }
+
+    entry.done = true;
+    --mPending;
+    mMilliseconds = mTimer.Milliseconds();
+    return entry.errors.empty();
+}
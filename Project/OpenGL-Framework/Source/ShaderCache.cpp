@@ -0,0 +1,288 @@
+/****************************************************************************/
+/*!
+\file
+   ShaderCache.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Linked programs are saved with glGetProgramBinary and restored with
+    glProgramBinary. Entries are keyed on the shader sources, the defines
+    and the GL vendor, renderer and version strings, a binary is only
+    ever valid for the driver that wrote it. A driver may still reject a
+    binary, Load then reports a miss and the caller compiles the source.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "ShaderCache.hpp"
+#include "Hash.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! on disk header, followed by the binary
+    struct CacheHeader
+    {
+        char magic[4] = { 'O', 'G', 'L', 'P' };
+        std::uint32_t version = OGL::ShaderCache::Version;
+        std::uint64_t key = 0;
+        std::uint32_t format = 0;       //!< binary format the driver reported
+        std::uint32_t length = 0;       //!< bytes of binary
+    };
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Hash a GL string, a missing one hashes as empty
+    */
+    /****************************************************************************/
+    static std::uint64_t HashGLString(GLenum name, std::uint64_t seed)
+    {
+        const GLubyte* value = glGetString(name);
+        return Hash64(value ? reinterpret_cast<const char*>(value) : "", seed);
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Hash the sources and the driver and work out where the cache entry
+  lives, needs a current GL context
+
+\param sources
+  Source of every stage, in the order they are attached
+
+\param defines
+  Anything else that changes the compiled program
+*/
+/****************************************************************************/
+OGL::ShaderCache::ShaderCache(const std::vector<std::string>& sources, const std::string& defines)
+{
+    if (!IsSupported())
+    {
+        return;
+    }
+
+    std::uint64_t key = HashValue(sources.size());
+    for (const std::string& source : sources)
+    {
+        key = HashValue(source.size(), key);
+        key = Hash64(source, key);
+    }
+    key = Hash64(defines, key);
+
+    // a binary only loads on the driver that wrote it
+    key = HashGLString(GL_VENDOR, key);
+    key = HashGLString(GL_RENDERER, key);
+    key = HashGLString(GL_VERSION, key);
+    key = HashValue(Version, key);
+    mKey = key;
+
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(mKey));
+    mPath = std::string(Directory) + "program_" + hex + ".oglprog";
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Restore a program from its cache entry
+
+\param program
+  A program with nothing attached, linked on success
+
+\return
+  True if the program is linked, false on a miss or when the driver
+  rejects the binary, the program must then be linked from source
+*/
+/****************************************************************************/
+bool OGL::ShaderCache::Load(GLuint program) const
+{
+    if (mPath.empty())
+    {
+        return false;
+    }
+
+    std::ifstream file(mPath, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    CacheHeader expected;
+    CacheHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file ||
+        std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+        header.version != expected.version ||
+        header.key != mKey)
+    {
+        return false;
+    }
+
+    std::vector<char> binary(header.length);
+    file.read(binary.data(), binary.size());
+    if (!file)
+    {
+        DEBUG::log.Error("ShaderCache: truncated cache file", mPath);
+        return false;
+    }
+
+    // drivers reject binaries after an update or for any reason of their own
+    glProgramBinary(program, GLenum(header.format), binary.data(), GLsizei(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        DEBUG::log.Info("ShaderCache: the driver rejected", mPath, "compiling from source");
+        return false;
+    }
+
+    return true;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Write a cache entry, failures are logged but never fatal
+
+\param program
+  A linked program, created with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+*/
+/****************************************************************************/
+void OGL::ShaderCache::Save(GLuint program) const
+{
+    if (mPath.empty())
+    {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    CacheHeader header;
+    header.key = mKey;
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    header.format = format;
+    header.length = std::uint32_t(written);
+    if (written <= 0)
+    {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(Directory, error);
+
+    // write to a temporary and rename so a reader never sees half a file
+    std::string temp = mPath + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            DEBUG::log.Error("ShaderCache: could not write", temp);
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), header.length);
+        if (!file)
+        {
+            DEBUG::log.Error("ShaderCache: could not write", temp);
+            file.close();
+            std::filesystem::remove(temp, error);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temp, mPath, error);
+    if (error)
+    {
+        DEBUG::log.Error("ShaderCache: could not rename", temp, error.message());
+        std::filesystem::remove(temp, error);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the cache key
+
+\return
+  Hash of the sources, defines and driver, 0 without binary support
+*/
+/****************************************************************************/
+std::uint64_t OGL::ShaderCache::Key() const
+{
+    return mKey;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the path of the cache entry
+
+\return
+  The cache file path, empty without binary support
+*/
+/****************************************************************************/
+const std::string& OGL::ShaderCache::Path() const
+{
+    return mPath;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Can the driver save and load program binaries, core since GL 4.1 and
+  an extension before
+
+\return
+  True if it supports at least one binary format
+*/
+/****************************************************************************/
+bool OGL::ShaderCache::IsSupported()
+{
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+    {
+        return false;
+    }
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
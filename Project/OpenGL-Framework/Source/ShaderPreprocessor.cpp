@@ -0,0 +1,197 @@
+/****************************************************************************/
+/*!
+\file
+   ShaderPreprocessor.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    GLSL has no #include, so included files are pasted in place, each
+    at most once per stage so shared files need no include guards. A
+    #line directive follows every switch between files, compile errors
+    then report the line in the file it came from, with the file's
+    index in ShaderSource::files as the source string number. Defines
+    are inserted after the #version line, which must stay first.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "ShaderPreprocessor.hpp"
+#include <filesystem>
+#include <fstream>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Get the file named by an #include line
+
+    \param line
+      A line of GLSL
+
+    \param name
+      Receives the name between the quotes or angle brackets
+
+    \return
+      True if the line is an #include
+    */
+    /****************************************************************************/
+    static bool ParseInclude(const std::string& line, std::string& name)
+    {
+        std::size_t hash = line.find_first_not_of(" \t");
+        if (hash == std::string::npos || line[hash] != '#')
+        {
+            return false;
+        }
+
+        std::size_t directive = line.find_first_not_of(" \t", hash + 1);
+        if (directive == std::string::npos || line.compare(directive, 7, "include") != 0)
+        {
+            return false;
+        }
+
+        std::size_t open = line.find_first_of("\"<", directive + 7);
+        std::size_t close = open == std::string::npos ? open : line.find_first_of("\">", open + 1);
+        if (close == std::string::npos)
+        {
+            throw std::runtime_error("ShaderPreprocessor: malformed #include: " + line);
+        }
+
+        name = line.substr(open + 1, close - open - 1);
+        return true;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Is a line the #version directive
+    */
+    /****************************************************************************/
+    static bool IsVersion(const std::string& line)
+    {
+        std::size_t hash = line.find_first_not_of(" \t");
+        if (hash == std::string::npos || line[hash] != '#')
+        {
+            return false;
+        }
+
+        std::size_t directive = line.find_first_not_of(" \t", hash + 1);
+        return directive != std::string::npos && line.compare(directive, 7, "version") == 0;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Paste a file and everything it includes into the output
+
+    \param path
+      The file, already normalized
+
+    \param depth
+      How many includes deep the file is
+
+    \param defines
+      Defines to insert after the #version line, only the stage file has one
+
+    \param source
+      The output
+    */
+    /****************************************************************************/
+    static void Append(const std::filesystem::path& path, unsigned depth, const std::vector<std::string>& defines, ShaderSource& source)
+    {
+        if (depth > ShaderPreprocessor::MaxIncludeDepth)
+        {
+            throw std::runtime_error("ShaderPreprocessor: includes nest deeper than " +
+                std::to_string(ShaderPreprocessor::MaxIncludeDepth) + " at " + path.string());
+        }
+
+        std::ifstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("ShaderPreprocessor: could not read " + path.string());
+        }
+
+        const std::size_t index = source.files.size();
+        source.files.push_back(path.string());
+
+        std::string line;
+        unsigned number = 0;
+        while (std::getline(file, line))
+        {
+            ++number;
+
+            std::string name;
+            if (ParseInclude(line, name))
+            {
+                std::filesystem::path included = (path.parent_path() / name).lexically_normal();
+                if (std::find(source.files.begin(), source.files.end(), included.string()) == source.files.end())
+                {
+                    source.code += "#line 1 " + std::to_string(source.files.size()) + "\n";
+                    Append(included, depth + 1, {}, source);
+                }
+                source.code += "#line " + std::to_string(number + 1) + " " + std::to_string(index) + "\n";
+                continue;
+            }
+
+            source.code += line;
+            source.code += '\n';
+
+            if (!defines.empty() && IsVersion(line))
+            {
+                for (const std::string& define : defines)
+                {
+                    source.code += "#define " + define + "\n";
+                }
+                source.code += "#line " + std::to_string(number + 1) + " " + std::to_string(index) + "\n";
+            }
+        }
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Read a shader stage and resolve its includes, relative to the file
+  that includes them
+
+\param path
+  The path to the stage
+
+\param defines
+  Defines for the stage, "NAME" or "NAME VALUE"
+
+\return
+  The source to compile and the files it was made of
+
+\exception std::runtime_error
+  If a file can not be read or includes nest too deep
+*/
+/****************************************************************************/
+OGL::ShaderSource OGL::ShaderPreprocessor::Process(const std::string& path, const std::vector<std::string>& defines)
+{
+    ShaderSource source;
+    Append(std::filesystem::path(path).lexically_normal(), 0, defines, source);
+    return source;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
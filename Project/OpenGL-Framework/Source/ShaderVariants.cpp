@@ -0,0 +1,268 @@
+/****************************************************************************/
+/*!
+\file
+   ShaderVariants.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Instead of one program branching on uniforms, every combination of
+    features a renderer asks for is its own program, compiled with the
+    features' defines so the disabled paths are never in it. Variants
+    are keyed by their feature bits and built the first time Get asks
+    for them, which waits on the compiler. Variants known up front go
+    through Preload, which builds them as one parallel batch.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "ShaderVariants.hpp"
+#include "ShaderBatch.hpp"
+#include "ShaderWatcher.hpp"
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Stop the watcher from reloading the variants
+*/
+/****************************************************************************/
+OGL::ShaderVariants::~ShaderVariants()
+{
+    if (mWatcher)
+    {
+        for (auto& variant : mVariants)
+        {
+            mWatcher->Unwatch(*variant.second);
+        }
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Describe the variants, nothing is built until they are asked for
+
+\param vertexShader
+  The path to the vertex shader
+
+\param fragmentShader
+  The path to the fragment shader
+
+\param features
+  Define of every feature, the i-th is enabled by bit i
+*/
+/****************************************************************************/
+OGL::ShaderVariants::ShaderVariants(const std::string& vertexShader, const std::string& fragmentShader,
+    const std::vector<std::string>& features)
+    : mVertexShader(vertexShader), mFragmentShader(fragmentShader), mFeatures(features)
+{
+    if (mFeatures.size() > MaxFeatures)
+    {
+        throw std::runtime_error("ShaderVariants: " + std::to_string(mFeatures.size()) + " features, at most " +
+            std::to_string(MaxFeatures) + " fit the feature bits");
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get a variant, building it on first use. The first use waits on the
+  compiler unless the variant was preloaded.
+
+\param features
+  Bits of the features the variant has
+
+\return
+  The variant, linked
+
+\exception std::runtime_error
+  If the variant fails to build
+*/
+/****************************************************************************/
+OGL::Shader& OGL::ShaderVariants::Get(ShaderFeatures features)
+{
+    Shader& shader = Variant(features);
+    if (shader.IsLinked())
+    {
+        return shader;
+    }
+
+    Timer timer;
+    shader.Create(mVertexShader, mFragmentShader, true, Defines(features));
+    DEBUG::log.Info("ShaderVariants: built", mVertexShader, "variant", features, "on first use in", timer.Milliseconds(), "ms");
+    if (mWatcher)
+    {
+        mWatcher->Watch(shader);
+    }
+    return shader;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Build variants ahead of their first use, as one batch
+
+\param variants
+  Feature bits of every variant to build, built ones are skipped
+
+\exception std::runtime_error
+  If a variant fails to build, once the others are built
+*/
+/****************************************************************************/
+void OGL::ShaderVariants::Preload(const std::vector<ShaderFeatures>& variants)
+{
+    ShaderBatch batch;
+    std::vector<Shader*> added;
+    for (ShaderFeatures features : variants)
+    {
+        Shader& shader = Variant(features);
+        if (!shader.IsLinked() && std::find(added.begin(), added.end(), &shader) == added.end())
+        {
+            batch.Add(shader, mVertexShader, mFragmentShader, true, Defines(features));
+            added.push_back(&shader);
+        }
+    }
+
+    if (added.empty())
+    {
+        return;
+    }
+
+    batch.Submit();
+    batch.Complete();
+    batch.Report();
+    if (mWatcher)
+    {
+        for (Shader* shader : added)
+        {
+            mWatcher->Watch(*shader);
+        }
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Has a variant been built
+
+\param features
+  Bits of the features the variant has
+
+\return
+  True if Get returns it without building it
+*/
+/****************************************************************************/
+bool OGL::ShaderVariants::IsLoaded(ShaderFeatures features) const
+{
+    auto it = mVariants.find(features);
+    return it != mVariants.end() && it->second->IsLinked();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get how many variants exist
+
+\return
+  Variants built or being built
+*/
+/****************************************************************************/
+std::size_t OGL::ShaderVariants::Count() const
+{
+    return mVariants.size();
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Get the defines of a set of features
+
+\param features
+  Bits of the features
+
+\return
+  The define of every set bit, in feature order
+*/
+/****************************************************************************/
+std::vector<std::string> OGL::ShaderVariants::Defines(ShaderFeatures features) const
+{
+    std::vector<std::string> defines;
+    for (std::size_t i = 0; i < mFeatures.size(); ++i)
+    {
+        if (features & (ShaderFeatures(1) << i))
+        {
+            defines.push_back(mFeatures[i]);
+        }
+    }
+    return defines;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Reload every variant, built so far and from now on, when its files
+  change
+
+\param watcher
+  The watcher, it must outlive the variants
+*/
+/****************************************************************************/
+void OGL::ShaderVariants::Watch(ShaderWatcher& watcher)
+{
+    mWatcher = &watcher;
+    for (auto& variant : mVariants)
+    {
+        if (variant.second->IsLinked())
+        {
+            mWatcher->Watch(*variant.second);
+        }
+    }
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Find a variant, or make an empty one with every block bound so far
+  recorded, the blocks are bound once it is built
+
+\param features
+  Bits of the features the variant has
+
+\return
+  The variant, not necessarily built
+*/
+/****************************************************************************/
+OGL::Shader& OGL::ShaderVariants::Variant(ShaderFeatures features)
+{
+    std::unique_ptr<Shader>& shader = mVariants[features];
+    if (!shader)
+    {
+        shader = std::make_unique<Shader>();
+        for (const std::function<void(Shader&)>& bind : mBindings)
+        {
+            bind(*shader);
+        }
+    }
+    return *shader;
+}
@@ -0,0 +1,115 @@
+/****************************************************************************/
+/*!
+\file
+   ShaderWatcher.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    The file watcher's thread only notices changes, everything that
+    touches GL happens in Update on the render thread. A shader whose
+    files change starts a reload there and keeps drawing with its
+    current program until the new one has linked.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "ShaderWatcher.hpp"
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Reload a shader whenever one of its source files, or a file they
+  include, changes
+
+\param shader
+  A created shader, it must outlive the watcher or be unwatched
+*/
+/****************************************************************************/
+void OGL::ShaderWatcher::Watch(Shader& shader)
+{
+    if (std::find(mShaders.begin(), mShaders.end(), &shader) != mShaders.end())
+    {
+        return;
+    }
+
+    mShaders.push_back(&shader);
+    for (const std::string& file : shader.Files())
+    {
+        mFiles.Watch(file);
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Stop reloading a shader, its files stay watched but are ignored
+
+\param shader
+  A watched shader
+*/
+/****************************************************************************/
+void OGL::ShaderWatcher::Unwatch(const Shader& shader)
+{
+    mShaders.erase(std::remove(mShaders.begin(), mShaders.end(), &shader), mShaders.end());
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Start reloading the shaders whose files changed and swap in those
+  that finished, call once a frame before drawing. A reload started
+  here is picked up no earlier than the next call, so without parallel
+  compile support the driver has a frame to work on it before Resolve
+  waits. A broken shader only logs its errors.
+*/
+/****************************************************************************/
+void OGL::ShaderWatcher::Update()
+{
+    std::vector<std::string> changes = mFiles.Changes();
+    for (Shader* shader : mShaders)
+    {
+        const std::vector<std::string>& files = shader->Files();
+        bool started = false;
+        for (const std::string& path : changes)
+        {
+            if (std::find(files.begin(), files.end(), path) != files.end())
+            {
+                DEBUG::log.Info("ShaderWatcher:", path, "changed, reloading");
+                shader->BeginReload();
+                started = true;
+                break;
+            }
+        }
+
+        // an edit may have added an include
+        if (!started && shader->UpdateReload())
+        {
+            for (const std::string& file : shader->Files())
+            {
+                mFiles.Watch(file);
+            }
+        }
+    }
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,239 @@
+/****************************************************************************/
+/*!
+\file
+   UniformBuffer.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    One uniform buffer split into a region per frame in flight. Blocks
+    are pushed into a CPU staging copy of the current frame's region and
+    written with one unsynchronized map per flush, the fence of the frame
+    that last used a region is waited on before it is written again, so
+    the driver never has to stall or rename the buffer.
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "UniformBuffer.hpp"
+#include "GLState.hpp"
+#include <cstring>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+namespace
+{
+    //! how long to wait on a fence at a time, in nanoseconds
+    constexpr GLuint64 FenceTimeout = 1000000000;
+}
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Delete the buffer and any fence still pending
+*/
+/****************************************************************************/
+OGL::UniformRing::~UniformRing()
+{
+    for (GLsync& fence : mFences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    GLState::DeleteBuffer(mBuffer);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Create the buffer, needs a current GL context
+
+\param frameBytes
+  Space for the blocks of one frame, the buffer holds FramesInFlight
+  regions of this size
+*/
+/****************************************************************************/
+void OGL::UniformRing::Create(std::size_t frameBytes)
+{
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    mAlignment = std::size_t(std::max(alignment, 1));
+    mFrameBytes = (frameBytes + mAlignment - 1) / mAlignment * mAlignment;
+
+    glGenBuffers(1, &mBuffer);
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, mFrameBytes * FramesInFlight, nullptr, GL_STREAM_DRAW);
+
+    mStaging.assign(mFrameBytes, 0);
+    mFrame = 0;
+    mHead = 0;
+    mFlushed = 0;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Move on to the next frame's region, waiting for the GPU to finish
+  the frame that last used it
+*/
+/****************************************************************************/
+void OGL::UniformRing::BeginFrame()
+{
+    mFrame = (mFrame + 1) % FramesInFlight;
+    mHead = 0;
+    mFlushed = 0;
+
+    GLsync& fence = mFences[mFrame];
+    if (fence)
+    {
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FenceTimeout) == GL_TIMEOUT_EXPIRED)
+        {
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Copy a block into the current frame's region
+
+\param data
+  The block, laid out as the shader declares it
+
+\param size
+  Size of the block in bytes
+
+\return
+  Where the block lives, bind it once it is flushed
+*/
+/****************************************************************************/
+OGL::UniformSlice OGL::UniformRing::Push(const void* data, std::size_t size)
+{
+    std::size_t offset = (mHead + mAlignment - 1) / mAlignment * mAlignment;
+    if (offset + size > mFrameBytes)
+    {
+        throw std::runtime_error("UniformRing: the " + std::to_string(mFrameBytes) + " bytes of a frame are used up");
+    }
+
+    std::memcpy(mStaging.data() + offset, data, size);
+    mHead = offset + size;
+    return { mFrame * mFrameBytes + offset, size };
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Write every block pushed since the last flush to the buffer, with one
+  map of the range. The region is fenced, so the map does not sync.
+*/
+/****************************************************************************/
+void OGL::UniformRing::Flush()
+{
+    if (mHead == mFlushed)
+    {
+        return;
+    }
+
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+    void* mapped = glMapBufferRange(GL_UNIFORM_BUFFER, mFrame * mFrameBytes + mFlushed, mHead - mFlushed,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped)
+    {
+        std::memcpy(mapped, mStaging.data() + mFlushed, mHead - mFlushed);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+    else
+    {
+        DEBUG::log.Error("UniformRing: mapping failed, falling back to glBufferSubData");
+        glBufferSubData(GL_UNIFORM_BUFFER, mFrame * mFrameBytes + mFlushed, mHead - mFlushed, mStaging.data() + mFlushed);
+    }
+
+    mFlushed = mHead;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Bind a pushed block to a binding point, flushing first if it is not
+  on the GPU yet. Push every block of a batch before binding any of them
+  and they are written with one flush.
+
+\param binding
+  The binding point, as the block's Binding constant
+
+\param slice
+  Slice returned by Push this frame
+*/
+/****************************************************************************/
+void OGL::UniformRing::Bind(GLuint binding, const UniformSlice& slice)
+{
+    if (slice.offset + slice.size > mFrame * mFrameBytes + mFlushed)
+    {
+        Flush();
+    }
+    GLState::BindBufferRange(GL_UNIFORM_BUFFER, binding, mBuffer, GLintptr(slice.offset), GLsizeiptr(slice.size));
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Flush what is left and fence the frame's region, call once the
+  frame's draws are issued
+*/
+/****************************************************************************/
+void OGL::UniformRing::EndFrame()
+{
+    Flush();
+    mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Space for one frame's blocks
+
+\return
+  Bytes of one region
+*/
+/****************************************************************************/
+std::size_t OGL::UniformRing::FrameBytes() const
+{
+    return mFrameBytes;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Space used by the current frame, alignment padding included
+
+\return
+  Bytes pushed this frame
+*/
+/****************************************************************************/
+std::size_t OGL::UniformRing::UsedBytes() const
+{
+    return mHead;
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,408 @@
+/****************************************************************************/
+/*!
+\file
+   VertexFormat.cpp
+\Author
+   Ryan Dugie
+\brief
+    Copyright (c) Ryan Dugie. All rights reserved.
+    Licensed under the Apache License 2.0
+
+    Vertex type and the compact GPU encodings a mesh can be uploaded in
+*/
+/****************************************************************************/
+/*============================================================================*\
+|| ------------------------------ INCLUDES ---------------------------------- ||
+\*============================================================================*/
+
+#include "OPENGLPCH.hpp"
+#include "VertexFormat.hpp"
+#include <gtc/packing.hpp>
+#include <cstring>
+
+/*============================================================================*\
+|| --------------------------- GLOBAL VARIABLES ----------------------------- ||
+\*============================================================================*/
+
+/*============================================================================*\
+|| -------------------------- STATIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+namespace OGL
+{
+    /****************************************************************************/
+    /*!
+    \brief
+      Size in bytes of an encoded position
+    */
+    /****************************************************************************/
+    static GLsizei PositionSize(PositionEncoding encoding)
+    {
+        return GLsizei(encoding == PositionEncoding::Float ? 4 * sizeof(float) : 4 * sizeof(std::int16_t));
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Size in bytes of an encoded normal
+    */
+    /****************************************************************************/
+    static GLsizei NormalSize(NormalEncoding encoding)
+    {
+        return GLsizei(encoding == NormalEncoding::Float ? 4 * sizeof(float) : sizeof(std::uint32_t));
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Float in [-1, 1] to a signed normalized integer with the given
+      number of magnitude steps
+    */
+    /****************************************************************************/
+    static int ToSnorm(float v, float steps)
+    {
+        return int(std::round(glm::clamp(v, -1.0f, 1.0f) * steps));
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Signed normalized integer back to a float, the same way GL does
+    */
+    /****************************************************************************/
+    static float FromSnorm(int v, float steps)
+    {
+        return std::max(float(v) / steps, -1.0f);
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Map a unit vector onto the octahedron, unfolded into [-1, 1]^2
+    */
+    /****************************************************************************/
+    static glm::vec2 OctahedralEncode(glm::vec3 n)
+    {
+        n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        glm::vec2 e(n.x, n.y);
+        if (n.z < 0)
+        {
+            e.x = (1.0f - std::abs(n.y)) * (n.x >= 0 ? 1.0f : -1.0f);
+            e.y = (1.0f - std::abs(n.x)) * (n.y >= 0 ? 1.0f : -1.0f);
+        }
+        return e;
+    }
+
+    /****************************************************************************/
+    /*!
+    \brief
+      Inverse of OctahedralEncode, mirrors DecodeOctahedral in Simple.vert
+    */
+    /****************************************************************************/
+    static glm::vec3 OctahedralDecode(glm::vec2 e)
+    {
+        glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        float t = std::max(-n.z, 0.0f);
+        n.x += n.x >= 0 ? -t : t;
+        n.y += n.y >= 0 ? -t : t;
+        return glm::normalize(n);
+    }
+}
+
+/*============================================================================*\
+|| -------------------------- PUBLIC FUNCTIONS ------------------------------ ||
+\*============================================================================*/
+
+/****************************************************************************/
+/*!
+\brief
+  Does this format need packing, or can Vertex be uploaded as is
+
+\return
+  True if anything is stored in a compact encoding
+*/
+/****************************************************************************/
+bool OGL::VertexFormat::IsPacked() const
+{
+    return position != PositionEncoding::Float || normal != NormalEncoding::Float;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Bytes per vertex on the GPU
+
+\return
+  The vertex stride
+*/
+/****************************************************************************/
+GLsizei OGL::VertexFormat::Stride() const
+{
+    return PositionSize(position) + NormalSize(normal);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Byte offset of the normal inside a vertex
+
+\return
+  The normal offset
+*/
+/****************************************************************************/
+GLsizei OGL::VertexFormat::NormalOffset() const
+{
+    return PositionSize(position);
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Encode vertices into this format
+
+\param vertices
+  The full precision vertices
+
+\param packed
+  Filled with Stride() bytes per vertex
+
+\return
+  What the vertex shader needs to decode the positions
+*/
+/****************************************************************************/
+OGL::VertexDecode OGL::VertexFormat::Pack(const std::vector<Vertex>& vertices, std::vector<unsigned char>& packed) const
+{
+    VertexDecode decode;
+    decode.octahedralNormals = normal == NormalEncoding::Octahedral;
+
+    // quantized positions are relative to the bounds
+    if (position == PositionEncoding::Quantized && !vertices.empty())
+    {
+        glm::vec3 min(vertices[0].position);
+        glm::vec3 max(vertices[0].position);
+        for (const Vertex& v : vertices)
+        {
+            min = glm::min(min, glm::vec3(v.position));
+            max = glm::max(max, glm::vec3(v.position));
+        }
+
+        // avoid a divide by zero on flat meshes
+        decode.positionScale = glm::max((max - min) * 0.5f, glm::vec3(1e-8f));
+        decode.positionBias = (max + min) * 0.5f;
+    }
+
+    const GLsizei stride = Stride();
+    const GLsizei normalOffset = NormalOffset();
+    packed.resize(vertices.size() * stride);
+
+    for (std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        unsigned char* out = packed.data() + i * stride;
+        const Vertex& v = vertices[i];
+
+        // position
+        switch (position)
+        {
+        case PositionEncoding::Float:
+            std::memcpy(out, &v.position, sizeof(v.position));
+            break;
+
+        case PositionEncoding::Half:
+        {
+            std::uint16_t half[4] =
+            {
+                glm::packHalf1x16(v.position.x),
+                glm::packHalf1x16(v.position.y),
+                glm::packHalf1x16(v.position.z),
+                glm::packHalf1x16(1.0f)
+            };
+            std::memcpy(out, half, sizeof(half));
+            break;
+        }
+
+        case PositionEncoding::Quantized:
+        {
+            glm::vec3 p = (glm::vec3(v.position) - decode.positionBias) / decode.positionScale;
+            std::int16_t q[4] =
+            {
+                std::int16_t(ToSnorm(p.x, 32767.0f)),
+                std::int16_t(ToSnorm(p.y, 32767.0f)),
+                std::int16_t(ToSnorm(p.z, 32767.0f)),
+                32767
+            };
+            std::memcpy(out, q, sizeof(q));
+            break;
+        }
+        }
+
+        // normal, the compact encodings store the unit direction only
+        out += normalOffset;
+        glm::vec3 n = glm::normalize(glm::vec3(v.normal));
+        switch (normal)
+        {
+        case NormalEncoding::Float:
+            std::memcpy(out, &v.normal, sizeof(v.normal));
+            break;
+
+        case NormalEncoding::Packed:
+        {
+            std::uint32_t bits =
+                (std::uint32_t(ToSnorm(n.x, 511.0f)) & 0x3FF) |
+                ((std::uint32_t(ToSnorm(n.y, 511.0f)) & 0x3FF) << 10) |
+                ((std::uint32_t(ToSnorm(n.z, 511.0f)) & 0x3FF) << 20);
+            std::memcpy(out, &bits, sizeof(bits));
+            break;
+        }
+
+        case NormalEncoding::Octahedral:
+        {
+            glm::vec2 e = OctahedralEncode(n);
+            std::int16_t q[2] = { std::int16_t(ToSnorm(e.x, 32767.0f)), std::int16_t(ToSnorm(e.y, 32767.0f)) };
+            std::memcpy(out, q, sizeof(q));
+            break;
+        }
+        }
+    }
+
+    return decode;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Decode one packed vertex on the CPU, exactly as the vertex shader would.
+  Used to measure the error of an encoding.
+
+\param vertex
+  Stride() bytes of packed vertex
+
+\param decode
+  The values returned by Pack
+
+\return
+  The decoded vertex, normal xyz is unit length
+*/
+/****************************************************************************/
+OGL::Vertex OGL::VertexFormat::Unpack(const unsigned char* vertex, const VertexDecode& decode) const
+{
+    Vertex v;
+
+    switch (position)
+    {
+    case PositionEncoding::Float:
+        std::memcpy(&v.position, vertex, sizeof(v.position));
+        break;
+
+    case PositionEncoding::Half:
+    {
+        std::uint16_t half[4];
+        std::memcpy(half, vertex, sizeof(half));
+        v.position = glm::vec4(glm::unpackHalf1x16(half[0]), glm::unpackHalf1x16(half[1]), glm::unpackHalf1x16(half[2]), 1);
+        break;
+    }
+
+    case PositionEncoding::Quantized:
+    {
+        std::int16_t q[4];
+        std::memcpy(q, vertex, sizeof(q));
+        glm::vec3 p(FromSnorm(q[0], 32767.0f), FromSnorm(q[1], 32767.0f), FromSnorm(q[2], 32767.0f));
+        v.position = glm::vec4(p * decode.positionScale + decode.positionBias, 1);
+        break;
+    }
+    }
+
+    vertex += NormalOffset();
+    glm::vec3 n(0);
+    switch (normal)
+    {
+    case NormalEncoding::Float:
+        std::memcpy(&v.normal, vertex, sizeof(v.normal));
+        n = glm::vec3(v.normal);
+        break;
+
+    case NormalEncoding::Packed:
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, vertex, sizeof(bits));
+
+        // sign extend each 10 bit field
+        auto field = [bits](int shift) { return int(std::int32_t(bits << (22 - shift)) >> 22); };
+        n = glm::vec3(FromSnorm(field(0), 511.0f), FromSnorm(field(10), 511.0f), FromSnorm(field(20), 511.0f));
+        break;
+    }
+
+    case NormalEncoding::Octahedral:
+    {
+        std::int16_t q[2];
+        std::memcpy(q, vertex, sizeof(q));
+        n = OctahedralDecode(glm::vec2(FromSnorm(q[0], 32767.0f), FromSnorm(q[1], 32767.0f)));
+        break;
+    }
+    }
+
+    v.normal = glm::vec4(glm::normalize(n), 0);
+    return v;
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Describe this format to the currently bound VAO and array buffer.
+  Attribute 0 is the position, attribute 1 the normal.
+*/
+/****************************************************************************/
+void OGL::VertexFormat::SetAttributes() const
+{
+    const GLsizei stride = Stride();
+
+    // position
+    glEnableVertexAttribArray(0);
+    switch (position)
+    {
+    case PositionEncoding::Float:
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        break;
+    case PositionEncoding::Half:
+        glVertexAttribPointer(0, 4, GL_HALF_FLOAT, GL_FALSE, stride, (void*)0);
+        break;
+    case PositionEncoding::Quantized:
+        glVertexAttribPointer(0, 4, GL_SHORT, GL_TRUE, stride, (void*)0);
+        break;
+    }
+
+    // normal
+    const void* offset = (void*)std::size_t(NormalOffset());
+    glEnableVertexAttribArray(1);
+    switch (normal)
+    {
+    case NormalEncoding::Float:
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, offset);
+        break;
+    case NormalEncoding::Packed:
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, offset);
+        break;
+    case NormalEncoding::Octahedral:
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, offset);
+        break;
+    }
+}
+
+/****************************************************************************/
+/*!
+\brief
+  Human readable name, for logs
+
+\return
+  The format name
+*/
+/****************************************************************************/
+std::string OGL::VertexFormat::Name() const
+{
+    static const char* positions[] = { "float", "half", "quantized" };
+    static const char* normals[] = { "float", "10-10-10-2", "octahedral" };
+    return std::string(positions[int(position)]) + " position / " + normals[int(normal)] + " normal";
+}
+
+/*============================================================================*\
+|| ------------------------- PRIVATE FUNCTIONS ------------------------------ ||
+\*============================================================================*/
@@ -0,0 +1,29 @@
+#version 450 core
+layout (location = 0) in vec4 aPosition;
+
+layout (location = 0) out vec4 color;
+
+// per draw state as plain uniforms, one call each
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 world;
+uniform vec4 tint;
+
+// the same state as std140 blocks
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+} camera;
+
+layout (std140) uniform Object
+{
+    mat4 world;
+    vec4 tint;
+} object;
+
+void main()
+{
+    color = tint + object.tint;
+    gl_Position = projection * view * world * camera.projection * camera.view * object.world * aPosition;
+}
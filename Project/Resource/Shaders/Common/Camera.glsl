@@ -0,0 +1,6 @@
+// std140, CameraBlock in Renderer.cpp must match it
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+};
@@ -0,0 +1,20 @@
+// decoding of the packed vertex formats, see VertexFormat.hpp
+
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return n;
+}
+
+// OCTAHEDRAL_NORMALS selects the variant for octahedral normals
+vec3 DecodeNormal(vec4 normal)
+{
+#ifdef OCTAHEDRAL_NORMALS
+    return DecodeOctahedral(normal.xy);
+#else
+    return normal.xyz;
+#endif
+}
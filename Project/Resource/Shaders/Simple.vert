@@ -4,12 +4,22 @@ layout (location = 1) in vec4 aNormal;
 
 layout (location = 0) out vec4 normal;
 
-uniform mat4 world;
-uniform mat4 view;
-uniform mat4 projection;
+#include "Common/Camera.glsl"
+#include "Common/VertexDecode.glsl"
+
+// std140, ObjectBlock in Renderer.cpp must match it
+layout (std140) uniform Object
+{
+    mat4 world;
+
+    // vertex decode, see VertexFormat.hpp
+    vec3 positionScale;
+    vec3 positionBias;
+};
 
 void main()
 {
-    normal = normalize(aNormal);   
-    gl_Position = projection * view * world * aPosition;
+    vec4 position = vec4(aPosition.xyz * positionScale + positionBias, 1.0);
+    normal = vec4(normalize(DecodeNormal(aNormal)), 0.0);
+    gl_Position = projection * view * world * position;
 }
\ No newline at end of file